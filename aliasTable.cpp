@@ -0,0 +1,47 @@
+#include "includes.hpp"
+#include "aliasTable.hpp"
+
+uint32_t AliasTable::sample(float u) const {
+    float scaled = u * static_cast<float>(size());
+    uint32_t index = std::min(static_cast<uint32_t>(scaled), static_cast<uint32_t>(size() - 1));
+    return scaled - static_cast<float>(index) < threshold[index] ? index : alias[index];
+}
+
+AliasTable buildAliasTable(const std::vector<double>& weights) {
+    size_t count = weights.size();
+    AliasTable table;
+    table.threshold.assign(count, 1.0f);
+    table.alias.resize(count);
+    table.pdf.resize(count);
+
+    double sum = 0.0;
+    for (double weight : weights) {
+        sum += std::max(weight, 0.0);
+    }
+
+    // Weights scaled so the average is 1, split into the under- and overfull ones
+    std::vector<double> scaled(count);
+    std::vector<uint32_t> small, large;
+    for (size_t i = 0; i < count; i++) {
+        double probability = sum > 0.0 ? std::max(weights[i], 0.0) / sum : 1.0 / count;
+        table.pdf[i] = static_cast<float>(probability);
+        table.alias[i] = static_cast<uint32_t>(i);
+        scaled[i] = probability * count;
+        (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+    }
+
+    // Fill each underfull entry up to 1 with part of an overfull one
+    while (!small.empty() && !large.empty()) {
+        uint32_t under = small.back();
+        small.pop_back();
+        uint32_t over = large.back();
+        large.pop_back();
+
+        table.threshold[under] = static_cast<float>(scaled[under]);
+        table.alias[under] = over;
+        scaled[over] = (scaled[over] + scaled[under]) - 1.0;
+        (scaled[over] < 1.0 ? small : large).push_back(over);
+    }
+    // Whatever is left is 1 up to rounding and keeps itself (threshold 1)
+    return table;
+}
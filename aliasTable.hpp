@@ -0,0 +1,23 @@
+#ifndef ALIAS_TABLE_HPP
+#define ALIAS_TABLE_HPP
+
+#include "includes.hpp"
+
+// Walker's alias method, built with Vose's algorithm: one uniform number u in [0, 1) picks entry
+// i = floor(u * n), which is kept when fract(u * n) < threshold[i] and replaced by alias[i] otherwise.
+// Every index then comes out with probability weights[i] / sum, in constant time for any n.
+struct AliasTable {
+    std::vector<float> threshold;
+    std::vector<uint32_t> alias;
+    std::vector<float> pdf;        // weights[i] / sum
+
+    size_t size() const { return pdf.size(); }
+
+    // Index for u in [0, 1) (non-empty table), the same steps the shaders take
+    uint32_t sample(float u) const;
+};
+
+// Negative weights count as zero, all zero weights give a uniform table
+AliasTable buildAliasTable(const std::vector<double>& weights);
+
+#endif // ALIAS_TABLE_HPP
@@ -0,0 +1,171 @@
+#include "includes.hpp"
+#include "benchmark.hpp"
+
+bool CameraPath::load(const std::string& filepath) {
+    std::ifstream file(filepath);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open camera path: " << filepath << std::endl;
+        return false;
+    }
+
+    keyframes.clear();
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(file, line)) {
+        lineNo++;
+        // Strip comments and skip blank lines
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+
+        std::istringstream stream(line);
+        CameraKeyframe keyframe;
+        if (!(stream >> keyframe.time >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z
+                     >> keyframe.yaw >> keyframe.pitch)) {
+            std::cerr << "Error: Bad keyframe on line " << lineNo << " of " << filepath << std::endl;
+            return false;
+        }
+        addKeyframe(keyframe);
+    }
+
+    return !keyframes.empty();
+}
+
+bool CameraPath::save(const std::string& filepath) const {
+    std::ofstream file(filepath);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not write camera path: " << filepath << std::endl;
+        return false;
+    }
+
+    file << "# time x y z yaw pitch\n";
+    for (const CameraKeyframe& keyframe : keyframes) {
+        file << keyframe.time << " "
+             << keyframe.position.x << " " << keyframe.position.y << " " << keyframe.position.z << " "
+             << keyframe.yaw << " " << keyframe.pitch << "\n";
+    }
+    return true;
+}
+
+void CameraPath::addKeyframe(const CameraKeyframe& keyframe) {
+    // Keep the keyframes sorted by time so sample() can binary search
+    auto it = std::upper_bound(keyframes.begin(), keyframes.end(), keyframe.time,
+        [](float time, const CameraKeyframe& other) { return time < other.time; });
+    keyframes.insert(it, keyframe);
+}
+
+CameraKeyframe CameraPath::sample(float time) const {
+    if (keyframes.empty()) {
+        return CameraKeyframe{0.0f, glm::vec3(0.0f), 0.0f, 0.0f};
+    }
+    if (time <= keyframes.front().time) {
+        return keyframes.front();
+    }
+    if (time >= keyframes.back().time) {
+        return keyframes.back();
+    }
+
+    auto next = std::upper_bound(keyframes.begin(), keyframes.end(), time,
+        [](float t, const CameraKeyframe& other) { return t < other.time; });
+    const CameraKeyframe& b = *next;
+    const CameraKeyframe& a = *(next - 1);
+
+    float span = b.time - a.time;
+    float t = span > 0.0f ? (time - a.time) / span : 0.0f;
+
+    CameraKeyframe result;
+    result.time = time;
+    result.position = glm::mix(a.position, b.position, t);
+    result.yaw = glm::mix(a.yaw, b.yaw, t);
+    result.pitch = glm::mix(a.pitch, b.pitch, t);
+    return result;
+}
+
+float CameraPath::getDuration() const {
+    if (keyframes.empty()) {
+        return 0.0f;
+    }
+    return keyframes.back().time - keyframes.front().time;
+}
+
+void FrameStats::addFrame(double milliseconds) {
+    frameTimes.push_back(milliseconds);
+}
+
+double FrameStats::percentile(double p) const {
+    if (frameTimes.empty()) {
+        return 0.0;
+    }
+
+    std::vector<double> sorted = frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+
+    // Nearest-rank percentile
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    rank = std::clamp<size_t>(rank, 1, sorted.size());
+    return sorted[rank - 1];
+}
+
+double FrameStats::mean() const {
+    if (frameTimes.empty()) {
+        return 0.0;
+    }
+
+    double sum = 0.0;
+    for (double time : frameTimes) {
+        sum += time;
+    }
+    return sum / frameTimes.size();
+}
+
+bool FrameStats::write(const std::string& filepath) const {
+    std::ofstream file(filepath);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not write frame stats: " << filepath << std::endl;
+        return false;
+    }
+
+    bool isJson = filepath.size() >= 5 && filepath.compare(filepath.size() - 5, 5, ".json") == 0;
+    return isJson ? writeJson(file) : writeCsv(file);
+}
+
+void FrameStats::printSummary(std::ostream& out) const {
+    out << "frames: " << frameTimes.size()
+        << "  mean: " << mean() << " ms"
+        << "  p50: " << percentile(50.0) << " ms"
+        << "  p95: " << percentile(95.0) << " ms"
+        << "  p99: " << percentile(99.0) << " ms" << std::endl;
+}
+
+bool FrameStats::writeCsv(std::ostream& out) const {
+    out << "frame,ms\n";
+    for (size_t i = 0; i < frameTimes.size(); i++) {
+        out << i << "," << frameTimes[i] << "\n";
+    }
+
+    // Summary rows use the same two columns so the file stays a plain table
+    out << "mean," << mean() << "\n";
+    out << "p50," << percentile(50.0) << "\n";
+    out << "p95," << percentile(95.0) << "\n";
+    out << "p99," << percentile(99.0) << "\n";
+    return true;
+}
+
+bool FrameStats::writeJson(std::ostream& out) const {
+    out << "{\n";
+    out << "  \"frames\": " << frameTimes.size() << ",\n";
+    out << "  \"mean_ms\": " << mean() << ",\n";
+    out << "  \"p50_ms\": " << percentile(50.0) << ",\n";
+    out << "  \"p95_ms\": " << percentile(95.0) << ",\n";
+    out << "  \"p99_ms\": " << percentile(99.0) << ",\n";
+    out << "  \"frame_ms\": [";
+    for (size_t i = 0; i < frameTimes.size(); i++) {
+        out << (i ? ", " : "") << frameTimes[i];
+    }
+    out << "]\n}\n";
+    return true;
+}
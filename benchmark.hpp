@@ -0,0 +1,56 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include "includes.hpp"
+
+// A single recorded camera pose
+struct CameraKeyframe {
+    float time;          // Seconds since the start of the path
+    glm::vec3 position;
+    float yaw;           // Degrees
+    float pitch;         // Degrees
+};
+
+// A list of camera keyframes that can be recorded, saved and replayed
+// File format: one keyframe per line as "time x y z yaw pitch", '#' starts a comment
+class CameraPath {
+public:
+    bool load(const std::string& filepath);
+    bool save(const std::string& filepath) const;
+
+    void addKeyframe(const CameraKeyframe& keyframe);
+
+    // Linearly interpolate the pose at a given time (clamped to the path)
+    CameraKeyframe sample(float time) const;
+
+    float getDuration() const;
+    bool isEmpty() const { return keyframes.empty(); }
+
+private:
+    std::vector<CameraKeyframe> keyframes;
+};
+
+// Collects per-frame times and writes them out with percentiles
+class FrameStats {
+public:
+    void addFrame(double milliseconds);
+
+    size_t getFrameCount() const { return frameTimes.size(); }
+
+    // Percentile in [0, 100] using nearest-rank
+    double percentile(double p) const;
+    double mean() const;
+
+    // Writes CSV or JSON depending on the file extension
+    bool write(const std::string& filepath) const;
+
+    void printSummary(std::ostream& out) const;
+
+private:
+    std::vector<double> frameTimes;
+
+    bool writeCsv(std::ostream& out) const;
+    bool writeJson(std::ostream& out) const;
+};
+
+#endif // BENCHMARK_HPP
@@ -0,0 +1,301 @@
+#include "includes.hpp"
+#include "bvh.hpp"
+
+namespace {
+
+// Nodes with more triangles than this bin/measure in parallel chunks
+constexpr uint32_t PARALLEL_BIN_THRESHOLD = 1 << 16;
+// Subtrees with more triangles than this may be handed to another thread
+constexpr uint32_t PARALLEL_BUILD_THRESHOLD = 1 << 12;
+
+constexpr float TRAVERSAL_COST = 1.0f;
+constexpr float INTERSECTION_COST = 1.0f;
+
+// Splits [first, first + count) into chunks and runs work(chunkFirst, chunkCount, chunkIndex) on each
+void forEachChunk(uint32_t first, uint32_t count, unsigned int chunks, const std::function<void(uint32_t, uint32_t, unsigned int)>& work) {
+    std::vector<std::future<void>> tasks;
+    uint32_t chunkSize = (count + chunks - 1) / chunks;
+    for (unsigned int i = 0; i < chunks; i++) {
+        uint32_t chunkFirst = first + i * chunkSize;
+        if (chunkFirst >= first + count) {
+            break;
+        }
+        uint32_t chunkCount = std::min(chunkSize, first + count - chunkFirst);
+        tasks.push_back(std::async(std::launch::async, work, chunkFirst, chunkCount, i));
+    }
+    for (auto& task : tasks) {
+        task.get();
+    }
+}
+
+} // namespace
+
+float BVH::Bounds::area() const {
+    glm::vec3 extent = max - min;
+    if (extent.x < 0.0f) {
+        return 0.0f;
+    }
+    return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+void BVH::buildTree(uint32_t count, unsigned int threads) {
+    threadCount = std::max(1u, threads);
+    busyThreads = 0;
+    nodes.clear();
+    depth = 0;
+    if (count == 0) {
+        return;
+    }
+
+    std::unique_ptr<BuildNode> root = buildNode(0, count, 1);
+
+    nodes.reserve(count * 2);
+    flatten(*root, 1);
+}
+
+void BVH::build(Mesh& mesh, unsigned int threads) {
+    uint32_t triangleCount = static_cast<uint32_t>(mesh.triangleCount());
+    triangleBounds.resize(triangleCount);
+    centroids.resize(triangleCount);
+    order.resize(triangleCount);
+    for (uint32_t i = 0; i < triangleCount; i++) {
+        Bounds bounds;
+        for (int corner = 0; corner < 3; corner++) {
+            bounds.grow(mesh.vertices[mesh.indices[i * 3 + corner]]);
+        }
+        triangleBounds[i] = bounds;
+        centroids[i] = (bounds.min + bounds.max) * 0.5f;
+        order[i] = i;
+    }
+
+    buildTree(triangleCount, threads);
+
+    // Reorder the triangles so leaves reference contiguous ranges
+    std::vector<uint32_t> sortedIndices(mesh.indices.size());
+    for (uint32_t i = 0; i < triangleCount; i++) {
+        for (int corner = 0; corner < 3; corner++) {
+            sortedIndices[i * 3 + corner] = mesh.indices[order[i] * 3 + corner];
+        }
+    }
+    mesh.indices.swap(sortedIndices);
+
+    triangleBounds.clear();
+    centroids.clear();
+    order.clear();
+}
+
+void BVH::build(const std::vector<glm::vec3>& boundsMin, const std::vector<glm::vec3>& boundsMax, unsigned int threads) {
+    uint32_t count = static_cast<uint32_t>(boundsMin.size());
+    triangleBounds.resize(count);
+    centroids.resize(count);
+    order.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        triangleBounds[i].min = boundsMin[i];
+        triangleBounds[i].max = boundsMax[i];
+        centroids[i] = (boundsMin[i] + boundsMax[i]) * 0.5f;
+        order[i] = i;
+    }
+
+    buildTree(count, threads);
+
+    // The order stays, it maps leaf positions to primitives
+    triangleBounds.clear();
+    centroids.clear();
+}
+
+void BVH::refit(const std::vector<glm::vec3>& boundsMin, const std::vector<glm::vec3>& boundsMax) {
+    // Children always come after their parent, so walking backwards visits them first
+    for (size_t i = nodes.size(); i-- > 0;) {
+        BVHNode& node = nodes[i];
+        Bounds bounds;
+        if (node.triangleCount > 0) {
+            for (uint32_t j = node.leftOrFirst; j < node.leftOrFirst + node.triangleCount; j++) {
+                bounds.grow(boundsMin[j]);
+                bounds.grow(boundsMax[j]);
+            }
+        } else {
+            const BVHNode& left = nodes[i + 1];
+            const BVHNode& right = nodes[node.leftOrFirst];
+            bounds.grow(left.boundsMin);
+            bounds.grow(left.boundsMax);
+            bounds.grow(right.boundsMin);
+            bounds.grow(right.boundsMax);
+        }
+        node.boundsMin = bounds.min;
+        node.boundsMax = bounds.max;
+    }
+}
+
+float BVH::getCost() const {
+    if (nodes.empty()) {
+        return 0.0f;
+    }
+    float cost = 0.0f;
+    for (const BVHNode& node : nodes) {
+        Bounds bounds;
+        bounds.min = node.boundsMin;
+        bounds.max = node.boundsMax;
+        cost += bounds.area() * (node.triangleCount > 0 ? INTERSECTION_COST * node.triangleCount : TRAVERSAL_COST);
+    }
+    Bounds root;
+    root.min = nodes[0].boundsMin;
+    root.max = nodes[0].boundsMax;
+    return cost / std::max(root.area(), 1e-20f);
+}
+
+void BVH::binTriangles(uint32_t first, uint32_t count, const Bounds& centroidBounds, int axis, Bin* bins) const {
+    float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+    float scale = BIN_COUNT / extent;
+    for (uint32_t i = first; i < first + count; i++) {
+        uint32_t triangle = order[i];
+        int bin = std::min(BIN_COUNT - 1, static_cast<int>((centroids[triangle][axis] - centroidBounds.min[axis]) * scale));
+        bins[bin].count++;
+        bins[bin].bounds.grow(triangleBounds[triangle]);
+    }
+}
+
+std::unique_ptr<BVH::BuildNode> BVH::buildNode(uint32_t first, uint32_t count, int level) {
+    auto node = std::make_unique<BuildNode>();
+    node->first = first;
+    node->count = count;
+
+    bool parallel = count >= PARALLEL_BIN_THRESHOLD && threadCount > 1;
+    unsigned int chunks = parallel ? threadCount : 1;
+
+    // Bounds of the triangles and of their centroids
+    std::vector<Bounds> chunkBounds(chunks), chunkCentroidBounds(chunks);
+    auto measure = [&](uint32_t chunkFirst, uint32_t chunkCount, unsigned int chunk) {
+        for (uint32_t i = chunkFirst; i < chunkFirst + chunkCount; i++) {
+            chunkBounds[chunk].grow(triangleBounds[order[i]]);
+            chunkCentroidBounds[chunk].grow(centroids[order[i]]);
+        }
+    };
+    if (parallel) {
+        forEachChunk(first, count, chunks, measure);
+    } else {
+        measure(first, count, 0);
+    }
+
+    Bounds centroidBounds;
+    for (unsigned int i = 0; i < chunks; i++) {
+        node->bounds.grow(chunkBounds[i]);
+        centroidBounds.grow(chunkCentroidBounds[i]);
+    }
+
+    // A traversal keeps at most one entry per level below the root on its stack, deeper nodes would
+    // overflow it: they stay leaves, however many triangles they hold
+    if (count == 1 || level >= MAX_DEPTH - 1) {
+        return node;
+    }
+
+    // Find the cheapest bin boundary over all three axes
+    float bestCost = std::numeric_limits<float>::max();
+    int bestAxis = -1;
+    int bestSplit = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        if (centroidBounds.max[axis] - centroidBounds.min[axis] <= 0.0f) {
+            continue;
+        }
+
+        std::vector<std::array<Bin, BIN_COUNT>> chunkBins(chunks);
+        auto bin = [&](uint32_t chunkFirst, uint32_t chunkCount, unsigned int chunk) {
+            binTriangles(chunkFirst, chunkCount, centroidBounds, axis, chunkBins[chunk].data());
+        };
+        if (parallel) {
+            forEachChunk(first, count, chunks, bin);
+        } else {
+            bin(first, count, 0);
+        }
+
+        Bin bins[BIN_COUNT];
+        for (const auto& binsOfChunk : chunkBins) {
+            for (int i = 0; i < BIN_COUNT; i++) {
+                bins[i].count += binsOfChunk[i].count;
+                bins[i].bounds.grow(binsOfChunk[i].bounds);
+            }
+        }
+
+        // Sweep from both sides, split i puts bins [0, i] on the left
+        float leftCost[BIN_COUNT - 1];
+        Bounds leftBounds;
+        uint32_t leftCount = 0;
+        for (int i = 0; i < BIN_COUNT - 1; i++) {
+            leftBounds.grow(bins[i].bounds);
+            leftCount += bins[i].count;
+            leftCost[i] = leftCount * leftBounds.area();
+        }
+        Bounds rightBounds;
+        uint32_t rightCount = 0;
+        for (int i = BIN_COUNT - 1; i > 0; i--) {
+            rightBounds.grow(bins[i].bounds);
+            rightCount += bins[i].count;
+            if (rightCount == 0 || rightCount == count) {
+                continue;
+            }
+            float cost = leftCost[i - 1] + rightCount * rightBounds.area();
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = i - 1;
+            }
+        }
+    }
+
+    float parentArea = node->bounds.area();
+    float splitCost = TRAVERSAL_COST + INTERSECTION_COST * bestCost / std::max(parentArea, 1e-20f);
+    float leafCost = INTERSECTION_COST * count;
+    if (count <= MAX_LEAF_SIZE && (bestAxis < 0 || leafCost <= splitCost)) {
+        return node;
+    }
+
+    uint32_t middle = first + count / 2;
+    if (bestAxis >= 0) {
+        float extent = centroidBounds.max[bestAxis] - centroidBounds.min[bestAxis];
+        float scale = BIN_COUNT / extent;
+        auto isLeft = [&](uint32_t triangle) {
+            int bin = std::min(BIN_COUNT - 1, static_cast<int>((centroids[triangle][bestAxis] - centroidBounds.min[bestAxis]) * scale));
+            return bin <= bestSplit;
+        };
+        auto split = std::partition(order.begin() + first, order.begin() + first + count, isLeft);
+        middle = static_cast<uint32_t>(split - order.begin());
+    }
+    // All centroids in one spot (or a degenerate partition): fall back to an even split
+    if (middle == first || middle == first + count) {
+        middle = first + count / 2;
+    }
+
+    uint32_t leftCount = middle - first;
+    uint32_t rightCount = count - leftCount;
+
+    // Hand the left subtree to another thread while this one builds the right subtree
+    if (count >= PARALLEL_BUILD_THRESHOLD && busyThreads.fetch_add(1) < static_cast<int>(threadCount) - 1) {
+        auto leftTask = std::async(std::launch::async, [this, first, leftCount, level] {
+            return buildNode(first, leftCount, level + 1);
+        });
+        node->right = buildNode(middle, rightCount, level + 1);
+        node->left = leftTask.get();
+        busyThreads--;
+    } else {
+        if (count >= PARALLEL_BUILD_THRESHOLD) {
+            busyThreads--;
+        }
+        node->left = buildNode(first, leftCount, level + 1);
+        node->right = buildNode(middle, rightCount, level + 1);
+    }
+
+    return node;
+}
+
+void BVH::flatten(const BuildNode& node, int level) {
+    depth = std::max(depth, level);
+
+    uint32_t index = static_cast<uint32_t>(nodes.size());
+    nodes.push_back({node.bounds.min, node.first, node.bounds.max, node.count});
+
+    if (node.left) {
+        nodes[index].triangleCount = 0;
+        flatten(*node.left, level + 1);
+        nodes[index].leftOrFirst = static_cast<uint32_t>(nodes.size());
+        flatten(*node.right, level + 1);
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef BVH_HPP
+#define BVH_HPP
+
+#include "includes.hpp"
+#include "mesh.hpp"
+
+// Flattened BVH node, 32 bytes, same layout as BVHNode in the compute shader (std430).
+// Nodes are stored depth first: the left child of an interior node is always the next node.
+struct BVHNode {
+    glm::vec3 boundsMin;
+    uint32_t leftOrFirst;     // Interior: index of the right child, leaf: first triangle
+    glm::vec3 boundsMax;
+    uint32_t triangleCount;   // 0 for interior nodes
+};
+static_assert(sizeof(BVHNode) == 32, "BVHNode must match the std430 layout in the shader");
+
+// Surface area heuristic BVH over the triangles of a mesh (or any boxes, see the TLAS), built with
+// binned SAH on the CPU. Large subtrees and the binning of large nodes are spread over worker threads.
+class BVH {
+public:
+    // Builds the tree and reorders mesh.indices so every leaf covers a contiguous triangle range
+    void build(Mesh& mesh, unsigned int threadCount = std::thread::hardware_concurrency());
+
+    // Builds the tree over one box per primitive. Leaves cover ranges of getOrder(): position i of a
+    // leaf range is primitive getOrder()[i].
+    void build(const std::vector<glm::vec3>& boundsMin, const std::vector<glm::vec3>& boundsMax,
+               unsigned int threadCount = std::thread::hardware_concurrency());
+
+    // Recomputes the node bounds bottom-up for primitives that moved (boxes in leaf order), the
+    // structure of the tree stays as built
+    void refit(const std::vector<glm::vec3>& boundsMin, const std::vector<glm::vec3>& boundsMax);
+
+    // SAH cost of the tree relative to its root box, grows as refitting loosens the nodes
+    float getCost() const;
+
+    const std::vector<BVHNode>& getNodes() const { return nodes; }
+    const std::vector<uint32_t>& getOrder() const { return order; }
+    int getDepth() const { return depth; }
+
+    static constexpr int MAX_DEPTH = 64;     // Traversal stack size in the shader, the tree stays shallower
+    static constexpr int BIN_COUNT = 16;
+    static constexpr int MAX_LEAF_SIZE = 8;
+
+private:
+    struct Bounds {
+        glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+        glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+        void grow(const glm::vec3& point) { min = glm::min(min, point); max = glm::max(max, point); }
+        void grow(const Bounds& other) { min = glm::min(min, other.min); max = glm::max(max, other.max); }
+        float area() const;
+    };
+
+    // Temporary pointer tree, flattened into nodes once the build is done
+    struct BuildNode {
+        Bounds bounds;
+        uint32_t first = 0, count = 0;
+        std::unique_ptr<BuildNode> left, right;
+    };
+
+    struct Bin {
+        Bounds bounds;
+        uint32_t count = 0;
+    };
+
+    std::vector<BVHNode> nodes;
+    int depth = 0;
+
+    // Per triangle data used during the build
+    std::vector<Bounds> triangleBounds;
+    std::vector<glm::vec3> centroids;
+    std::vector<uint32_t> order;
+
+    unsigned int threadCount = 1;
+    std::atomic<int> busyThreads{0};
+
+    void buildTree(uint32_t count, unsigned int threads);
+    std::unique_ptr<BuildNode> buildNode(uint32_t first, uint32_t count, int level);
+    void binTriangles(uint32_t first, uint32_t count, const Bounds& centroidBounds, int axis, Bin* bins) const;
+    void flatten(const BuildNode& node, int level);
+};
+
+#endif // BVH_HPP
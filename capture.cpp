@@ -0,0 +1,201 @@
+#include "includes.hpp"
+#include "capture.hpp"
+#include "imageIO.hpp"
+
+namespace {
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Where stdout went before reserveStdout() moved std::cout
+std::streambuf* stdoutBuffer = nullptr;
+
+} // namespace
+
+void FrameCapture::reserveStdout() {
+    if (!stdoutBuffer) {
+        stdoutBuffer = std::cout.rdbuf();
+        std::cout.rdbuf(std::cerr.rdbuf());
+    }
+}
+
+FrameCapture::FrameCapture(const std::string& output, int width, int height)
+    : output(output), width(width), height(height) {
+    if (output == "-" || endsWith(output, ".y4m")) {
+        format = Y4M;
+    } else if (endsWith(output, ".png")) {
+        format = PNG;
+    } else if (endsWith(output, ".exr")) {
+        format = EXR;
+    } else {
+        std::cerr << "Error: Capture output must end in .png, .exr or .y4m (or be - for Y4M on stdout): " << output << std::endl;
+        return;
+    }
+
+    if (format == Y4M) {
+        std::ostream* stream;
+        if (output == "-") {
+            reserveStdout();
+            y4mStdout = std::make_unique<std::ostream>(stdoutBuffer);
+            stream = y4mStdout.get();
+        } else {
+            y4mFile = std::make_unique<std::ofstream>(output, std::ios::binary);
+            if (!y4mFile->is_open()) {
+                std::cerr << "Error: Could not open capture output: " << output << std::endl;
+                format = NONE;
+                return;
+            }
+            stream = y4mFile.get();
+        }
+        y4mWriter = std::make_unique<Y4MWriter>(*stream, width, height, 60);
+    }
+
+    // EXR keeps the half float values, the others are 8 bits per channel anyway
+    dataType = format == EXR ? GL_HALF_FLOAT : GL_UNSIGNED_BYTE;
+    frameSize = static_cast<size_t>(width) * height * 4 * (format == EXR ? 2 : 1);
+    for (Slot& slot : slots) {
+        glGenBuffers(1, &slot.buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, frameSize, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    writer = std::thread(&FrameCapture::writerLoop, this);
+}
+
+FrameCapture::~FrameCapture() {
+    if (writer.joinable()) {
+        finish(std::cerr);
+    }
+    for (Slot& slot : slots) {
+        if (slot.fence) {
+            glDeleteSync(slot.fence);
+        }
+        if (slot.buffer) {
+            glDeleteBuffers(1, &slot.buffer);
+        }
+    }
+}
+
+void FrameCapture::capture(const Texture& texture) {
+    if (!isValid()) {
+        return;
+    }
+    int frameIndex = frameCount++;
+
+    // Finished readbacks first, that may free the slot this frame needs
+    collect(false);
+
+    if (texture.getWidth() != width || texture.getHeight() != height) {
+        skippedSize++;
+        return;
+    }
+    Slot& slot = slots[nextSlot];
+    if (slot.fence) {
+        droppedReadback++;
+        return;
+    }
+
+    // Into the buffer, the copy happens on the GPU timeline
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    texture.bind();
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, dataType, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.frameIndex = frameIndex;
+    nextSlot = (nextSlot + 1) % SLOTS;
+}
+
+// Oldest first so frames reach the writer in order; stops at the first one still in flight
+void FrameCapture::collect(bool wait) {
+    for (int i = 0; i < SLOTS; i++) {
+        Slot& slot = slots[(nextSlot + i) % SLOTS];
+        if (!slot.fence) {
+            continue;
+        }
+        GLuint64 timeout = wait ? 1000000000ull : 0;
+        GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        while (wait && status == GL_TIMEOUT_EXPIRED) {
+            status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        }
+        if (status == GL_TIMEOUT_EXPIRED) {
+            return;
+        }
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (queue.size() >= MAX_QUEUED) {
+            droppedWriter++;
+            continue;
+        }
+        lock.unlock();
+
+        Frame frame{slot.frameIndex, std::vector<uint8_t>(frameSize)};
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameSize, GL_MAP_READ_BIT);
+        if (mapped) {
+            std::memcpy(frame.pixels.data(), mapped, frameSize);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        lock.lock();
+        queue.push_back(std::move(frame));
+        queueChanged.notify_one();
+    }
+}
+
+void FrameCapture::finish(std::ostream& out) {
+    if (!writer.joinable()) {
+        return;
+    }
+    collect(true);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+    }
+    queueChanged.notify_one();
+    writer.join();
+
+    out << "Capture: " << written << " of " << frameCount << " frames written to " << output;
+    if (droppedReadback + droppedWriter + skippedSize + writeErrors > 0) {
+        out << ", dropped " << droppedReadback << " (readback behind), " << droppedWriter << " (writer behind), "
+            << skippedSize << " (size changed), " << writeErrors << " write errors";
+    }
+    out << std::endl;
+}
+
+void FrameCapture::writerLoop() {
+    while (true) {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            queueChanged.wait(lock, [this] { return finished || !queue.empty(); });
+            if (queue.empty()) {
+                return;
+            }
+            frame = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        bool ok = writeFrame(frame);
+        std::lock_guard<std::mutex> lock(mutex);
+        (ok ? written : writeErrors)++;
+    }
+}
+
+bool FrameCapture::writeFrame(const Frame& frame) {
+    if (format == Y4M) {
+        return y4mWriter->writeFrame(frame.pixels.data());
+    }
+
+    std::vector<char> path(output.size() + 32);
+    std::snprintf(path.data(), path.size(), output.c_str(), frame.index);
+    if (format == PNG) {
+        return writePNG(path.data(), width, height, frame.pixels.data());
+    }
+    return writeEXR(path.data(), width, height, reinterpret_cast<const uint16_t*>(frame.pixels.data()));
+}
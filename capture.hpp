@@ -0,0 +1,82 @@
+#ifndef CAPTURE_HPP
+#define CAPTURE_HPP
+
+#include "includes.hpp"
+#include "shaderStuff.hpp"
+
+class Y4MWriter;
+
+// Records rendered frames without stalling the render loop. Each frame is read back into one of a
+// ring of pixel pack buffers with a fence; once a later frame finds the fence signaled (never waiting
+// for it) the buffer is mapped, copied and handed to a writer thread that encodes it. If the GPU
+// readbacks or the writer fall behind, frames are dropped and counted instead of blocking.
+//
+// Output: a printf pattern with the frame number ending in .png or .exr ("frames/%05d.png"),
+// a .y4m file, or "-" for a Y4M stream on stdout.
+class FrameCapture {
+public:
+    static constexpr int SLOTS = 3;             // Readbacks in flight
+    static constexpr size_t MAX_QUEUED = 8;     // Frames waiting for the writer
+
+    FrameCapture(const std::string& output, int width, int height);
+    ~FrameCapture();
+
+    bool isValid() const { return format != NONE; }
+
+    // Queue a readback of the texture (same size as the capture) and pass finished ones to the writer
+    void capture(const Texture& texture);
+
+    // Wait for the outstanding readbacks and the writer, then print what was written and dropped
+    void finish(std::ostream& out);
+
+    // A Y4M stream on stdout needs every other message off stdout: std::cout moves to stderr.
+    // Call before printing anything when capturing to "-".
+    static void reserveStdout();
+
+private:
+    enum Format { NONE, PNG, EXR, Y4M };
+
+    struct Frame {
+        int index;
+        std::vector<uint8_t> pixels;
+    };
+
+    struct Slot {
+        GLuint buffer = 0;
+        GLsync fence = nullptr;
+        int frameIndex = -1;
+    };
+
+    void collect(bool wait);
+    void writerLoop();
+    bool writeFrame(const Frame& frame);
+
+    std::string output;
+    Format format = NONE;
+    int width, height;
+    size_t frameSize;
+    GLenum dataType;
+
+    Slot slots[SLOTS];
+    int nextSlot = 0;
+    int frameCount = 0;
+
+    std::unique_ptr<std::ofstream> y4mFile;
+    std::unique_ptr<std::ostream> y4mStdout;
+    std::unique_ptr<Y4MWriter> y4mWriter;
+
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable queueChanged;
+    std::deque<Frame> queue;
+    bool finished = false;
+
+    // Counters, the writer ones are guarded by mutex
+    int written = 0;
+    int writeErrors = 0;
+    int droppedReadback = 0;     // All readback slots still busy on the GPU
+    int droppedWriter = 0;       // Writer queue full
+    int skippedSize = 0;         // Texture size differs from the capture size (window resized)
+};
+
+#endif // CAPTURE_HPP
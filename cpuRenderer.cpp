@@ -0,0 +1,477 @@
+#include "includes.hpp"
+#include "cpuRenderer.hpp"
+#include "sampler.hpp"
+
+namespace {
+
+const float INFINITY_DISTANCE = 99999999.0f;  // infinity in common.glsl
+
+Float3 toFloat3(const glm::vec3& v) { return {v.x, v.y, v.z}; }
+Float3 mul(const Float3& a, const Float3& b) { return {a.x * b.x, a.y * b.y, a.z * b.z}; }
+Float3 mix(const Float3& a, const Float3& b, float t) { return a + (b - a) * t; }
+Float3 reflect(const Float3& i, const Float3& n) { return i - n * (2.0f * dot(n, i)); }
+
+// GLSL refract()
+Float3 refract(const Float3& i, const Float3& n, float eta) {
+    float d = dot(n, i);
+    float k = 1.0f - eta * eta * (1.0f - d * d);
+    if (k < 0.0f) {
+        return {0.0f, 0.0f, 0.0f};
+    }
+    return i * eta - n * (eta * d + std::sqrt(k));
+}
+
+// boxSurfacePoint() of scene.glsl: a face in proportion to its area, then a uniform point on it
+Float3 boxSurfacePoint(const BoxTransform& box, const Float3& r) {
+    const Float3& s = box.size;
+    Float3 faceAreas = {s.y * s.z, s.x * s.z, s.x * s.y};
+    float totalArea = faceAreas.x + faceAreas.y + faceAreas.z;
+    if (totalArea <= 0.0f) {
+        return box.position;
+    }
+
+    float pick = r.x * totalArea;
+    float u = r.y * 2.0f - 1.0f;
+    float v = r.z * 2.0f - 1.0f;
+    Float3 local;
+    if (pick < faceAreas.x) {
+        local = {pick / faceAreas.x < 0.5f ? -s.x : s.x, u * s.y, v * s.z};
+    } else if (pick < faceAreas.x + faceAreas.y) {
+        local = {u * s.x, (pick - faceAreas.x) / faceAreas.y < 0.5f ? -s.y : s.y, v * s.z};
+    } else {
+        local = {u * s.x, v * s.y, (pick - faceAreas.x - faceAreas.y) / faceAreas.z < 0.5f ? -s.z : s.z};
+    }
+    return box.position + box.boxToWorld * local;
+}
+
+} // namespace
+
+// The shader's random numbers (sampler.glsl), one sample of one pixel
+struct CpuRenderer::Random {
+    Sampler sampler;
+
+    float hash1() {
+        return sampler.next();
+    }
+
+    void hash2(float& x, float& y) {
+        x = sampler.next();
+        y = sampler.next();
+    }
+
+    Float3 cosWeightedRandomHemisphereDirection(const Float3& n) {
+        float rx, ry;
+        hash2(rx, ry);
+        Float3 uu = cross(n, Float3{0.0f, 1.0f, 1.0f});
+        // n along (0, 1, 1) itself, any other axis gives the tangent
+        if (dot(uu, uu) < 1e-6f) {
+            uu = cross(n, Float3{1.0f, 0.0f, 0.0f});
+        }
+        uu = normalize(uu);
+        Float3 vv = cross(uu, n);
+        float ra = std::sqrt(ry);
+        float x = ra * std::cos(6.2831f * rx);
+        float y = ra * std::sin(6.2831f * rx);
+        float z = std::sqrt(1.0f - ry);
+        return normalize(uu * x + vv * y + n * z);
+    }
+
+    Float3 hash3() {
+        Float3 r;
+        r.x = sampler.next();
+        r.y = sampler.next();
+        r.z = sampler.next();
+        return r;
+    }
+
+    Float3 randomSphereDirection() {
+        float rx, ry;
+        hash2(rx, ry);
+        rx *= 6.2831f;
+        ry *= 6.2831f;
+        return {std::sin(rx) * std::sin(ry), std::sin(rx) * std::cos(ry), std::cos(rx)};
+    }
+};
+
+CpuRenderer::CpuRenderer(int width, int height, int threadCount)
+    : width(width), height(height), pool(std::make_unique<TilePool>(threadCount)),
+      color(width * height), normal(width * height), depth(width * height) {}
+
+void CpuRenderer::setThreadCount(int threadCount) {
+    pool = std::make_unique<TilePool>(threadCount);
+}
+
+void CpuRenderer::setScene(const Scene& scene, const Mesh* newMesh, const BVH* newBvh) {
+    materials.clear();
+    for (const SceneMaterial& m : scene.getMaterials()) {
+        materials.push_back({m.type, m.opaqueness, m.smoothness, m.specularity, toFloat3(m.color)});
+    }
+    if (materials.empty()) {
+        materials.push_back({1, 1.0f, 0.0f, 0.0f, {1.0f, 1.0f, 1.0f}});
+    }
+
+    auto convertSpheres = [](const std::vector<SceneSphere>& source) {
+        std::vector<CpuSphere> result;
+        for (const SceneSphere& s : source) {
+            result.push_back({toFloat3(s.position), s.radius, static_cast<int>(s.material)});
+        }
+        return result;
+    };
+    // The box transform is built once here instead of for every ray like the shader does
+    auto convertBoxes = [](const std::vector<SceneBox>& source) {
+        std::vector<CpuBox> result;
+        for (const SceneBox& b : source) {
+            result.push_back({BoxTransform(toFloat3(b.position), toFloat3(b.size), toFloat3(b.rotation)), static_cast<int>(b.material)});
+        }
+        return result;
+    };
+    spheres = convertSpheres(scene.getSpheres());
+    sphereLights = convertSpheres(scene.getSphereLights());
+    boxes = convertBoxes(scene.getBoxes());
+    boxLights = convertBoxes(scene.getBoxLights());
+    meshMaterial = static_cast<int>(scene.getMeshMaterial());
+
+    lightTable = AliasTable();
+    for (const SceneLight& light : scene.getLightTable()) {
+        lightTable.threshold.push_back(light.threshold);
+        lightTable.alias.push_back(light.alias);
+        lightTable.pdf.push_back(light.pdf);
+    }
+
+    bool hasMesh = newMesh && newBvh && newMesh->triangleCount() > 0 && !newBvh->getNodes().empty();
+    mesh = hasMesh ? newMesh : nullptr;
+    bvh = hasMesh ? newBvh : nullptr;
+}
+
+void CpuRenderer::render(const glm::mat4& invViewProj, const glm::vec3& cameraPosition, unsigned int frameNo, int samples, int bounces) {
+    int tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    int tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    Float3 origin = toFloat3(cameraPosition);
+    pool->run(tilesX * tilesY, [&](int tile) {
+        renderTile(tile, invViewProj, origin, frameNo, samples, bounces);
+    });
+}
+
+void CpuRenderer::renderTile(int tile, const glm::mat4& invViewProj, const Float3& cameraPosition, unsigned int frameNo, int samples, int bounces) {
+    int tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    int x0 = (tile % tilesX) * TILE_SIZE;
+    int y0 = (tile / tilesX) * TILE_SIZE;
+
+    for (int y = y0; y < std::min(y0 + TILE_SIZE, height); y++) {
+        for (int x = x0; x < std::min(x0 + TILE_SIZE, width); x++) {
+            // Same camera ray as the shader (its aspectRatio constant is 4/3 in integer math, so 1)
+            glm::vec4 clipSpacePos(static_cast<float>(x) / width * 2.0f - 1.0f, static_cast<float>(y) / height * 2.0f - 1.0f, -1.0f, 1.0f);
+            glm::vec4 worldSpacePos = invViewProj * clipSpacePos;
+            Ray ray;
+            ray.point = cameraPosition;
+            ray.dir = normalize(Float3{worldSpacePos.x / worldSpacePos.w, worldSpacePos.y / worldSpacePos.w, worldSpacePos.z / worldSpacePos.w});
+            ray.col = {0.0f, 0.0f, 0.0f};
+
+            Float3 pixel = traceRay(ray, x, y, frameNo, samples, bounces);
+            color[y * width + x] = glm::vec4(pixel.x, pixel.y, pixel.z, 1.0f);
+        }
+    }
+}
+
+// traceRay() and traceRayNorm() of the megakernel
+Float3 CpuRenderer::traceRay(Ray ray, int x, int y, unsigned int frameNo, int samples, int bounces) {
+    CpuMaterial material = materials[0];
+    Float3 hitNormal = {0.0f, 0.0f, 0.0f};
+
+    float distance = rayDist(ray, hitNormal, material);
+    if (distance < INFINITY_DISTANCE) {
+        normal[y * width + x] = glm::vec4(hitNormal.x, hitNormal.y, hitNormal.z, 1.0f);
+        depth[y * width + x] = distance;
+    } else {
+        normal[y * width + x] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        depth[y * width + x] = INFINITY_DISTANCE;
+    }
+
+    Float3 initPoint = ray.point;
+    Float3 initDir = ray.dir;
+    Float3 colorSum = {0.0f, 0.0f, 0.0f};
+    Float3 light = {0.0f, 0.0f, 0.0f};
+
+    int raySamples = std::min(MAX_SAMPLES, samples);
+    int rayBounces = std::min(MAX_BOUNCES, bounces);
+    Random random;
+    int realSamples = 0;
+    for (int k = 0; k < raySamples; k++) {
+        realSamples++;
+        random.sampler.begin(x, y, frameNo * MAX_SAMPLES + (realSamples - 1));
+        ray.point = initPoint + random.randomSphereDirection() * 0.001f;
+        ray.dir = initDir;
+        ray.col = {1.0f, 1.0f, 1.0f};
+        int segments = 0;
+        for (int i = 0; i < rayBounces; i++) {
+            segments++;
+            distance = rayDist(ray, hitNormal, material);
+            if (distance < INFINITY_DISTANCE) {
+                ray.point = ray.point + ray.dir * distance;
+
+                if (material.type == 0) {
+                    ray.col = mul(ray.col, material.color);
+                    light = light + material.color;
+                    k += std::max(1 - i, 0) * raySamples;
+                    break;
+                }
+
+                float opaqueness = material.opaqueness;
+                float refractiveIndex = 0.1f;
+                float specProbability = material.specularity;
+                random.sampler.dimension = Sampler::bounceDimension(segments - 1, LIGHT_SAMPLES);
+                int isSpec = specProbability > random.hash1() ? 1 : 0;
+                float smoothness = material.smoothness * isSpec;
+                int isTransparent = opaqueness < random.hash1() ? 1 : 0;
+                i -= isTransparent;
+                Float3 refractedDir = refract(ray.dir, hitNormal, refractiveIndex);
+                Float3 diffuseDir = random.cosWeightedRandomHemisphereDirection(hitNormal * static_cast<float>(1 - isTransparent * 2));
+                Float3 specDir = reflect(ray.dir, hitNormal);
+                Float3 opaqueDir = mix(specDir, refractedDir, static_cast<float>(isTransparent));
+                ray.dir = mix(diffuseDir, opaqueDir, smoothness);
+                ray.point = ray.point + ray.dir * 0.001f;
+                ray.col = mul(ray.col, mix(material.color, Float3{1.0f, 1.0f, 1.0f}, static_cast<float>(std::min(isSpec + isTransparent, 1))));
+
+                float couldBeLit;
+                Float3 directBrightness = sampleLight(ray.point, hitNormal, random, couldBeLit);
+                k += static_cast<int>(couldBeLit * 0.2f);  // Priority sampling, like the shader
+                light = light + mix(directBrightness, Float3{0.0f, 0.0f, 0.0f}, std::min(smoothness + isTransparent, 1.0f));
+            } else {
+                k += std::max(1 - i, 0) * raySamples;
+                break;
+            }
+        }
+        colorSum = colorSum + ray.col;
+    }
+    return mul(light, colorSum) * (1.0f / static_cast<float>(realSamples * realSamples));
+}
+
+float CpuRenderer::rayDist(const Ray& ray, Float3& hitNormal, CpuMaterial& material) const {
+    float dist = INFINITY_DISTANCE;
+
+    auto testSpheres = [&](const std::vector<CpuSphere>& list) {
+        for (const CpuSphere& sphere : list) {
+            float side;
+            float bd = sphereHit(ray.point, ray.dir, sphere.center, sphere.radius, side);
+            if (bd > 0.0f && bd < dist) {
+                dist = bd;
+                hitNormal = normalize((ray.point + ray.dir * bd - sphere.center) * side);
+                material = materials[sphere.material];
+            }
+        }
+    };
+    auto testBoxes = [&](const std::vector<CpuBox>& list) {
+        for (const CpuBox& box : list) {
+            Float3 boxNormal;
+            float bd = boxHit(ray.point, ray.dir, box.transform, boxNormal);
+            if (bd > 0.0f && bd < dist) {
+                dist = bd;
+                hitNormal = boxNormal;
+                material = materials[box.material];
+            }
+        }
+    };
+
+    // Flat list, unlike the shader's TLAS walk (nearest child first, mesh last): objects at exactly
+    // the same distance may resolve differently from the GPU
+    testSpheres(spheres);
+    testBoxes(boxes);
+    if (mesh) {
+        Float3 meshNormal;
+        float bd = meshHit(ray, dist, meshNormal);
+        if (bd > 0.0f && bd < dist) {
+            dist = bd;
+            hitNormal = meshNormal;
+            material = materials[meshMaterial];
+        }
+    }
+    testSpheres(sphereLights);
+    testBoxes(boxLights);
+    return dist;
+}
+
+float CpuRenderer::meshHit(const Ray& ray, float tMax, Float3& hitNormal) const {
+    const std::vector<BVHNode>& nodes = bvh->getNodes();
+    Float3 invDir = {1.0f / ray.dir.x, 1.0f / ray.dir.y, 1.0f / ray.dir.z};
+
+    auto aabbHit = [&](const BVHNode& node, float maxDist) {
+        float tx0 = (node.boundsMin.x - ray.point.x) * invDir.x, tx1 = (node.boundsMax.x - ray.point.x) * invDir.x;
+        float ty0 = (node.boundsMin.y - ray.point.y) * invDir.y, ty1 = (node.boundsMax.y - ray.point.y) * invDir.y;
+        float tz0 = (node.boundsMin.z - ray.point.z) * invDir.z, tz1 = (node.boundsMax.z - ray.point.z) * invDir.z;
+        float tn = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::max(std::min(tz0, tz1), 0.0f));
+        float tf = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::min(std::max(tz0, tz1), maxDist));
+        return tn <= tf ? tn : INFINITY_DISTANCE;
+    };
+
+    float dist = tMax;
+    if (aabbHit(nodes[0], dist) >= INFINITY_DISTANCE) {
+        return -1.0f;
+    }
+
+    uint32_t stack[BVH::MAX_DEPTH];
+    int stackSize = 0;
+    uint32_t nodeIndex = 0;
+    while (true) {
+        const BVHNode& node = nodes[nodeIndex];
+        if (node.triangleCount > 0) {
+            for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.triangleCount; i++) {
+                Float3 v0 = toFloat3(mesh->vertices[mesh->indices[i * 3]]);
+                Float3 v1 = toFloat3(mesh->vertices[mesh->indices[i * 3 + 1]]);
+                Float3 v2 = toFloat3(mesh->vertices[mesh->indices[i * 3 + 2]]);
+                float u, v;
+                float t = triangleHit(ray.point, ray.dir, v0, v1, v2, u, v);
+                if (t > 0.0f && t < dist) {
+                    dist = t;
+                    hitNormal = normalize(cross(v1 - v0, v2 - v0));
+                }
+            }
+            if (stackSize == 0) break;
+            nodeIndex = stack[--stackSize];
+            continue;
+        }
+
+        // Nearer child first, the other one waits on the stack
+        uint32_t nearChild = nodeIndex + 1;
+        uint32_t farChild = node.leftOrFirst;
+        float nearDist = aabbHit(nodes[nearChild], dist);
+        float farDist = aabbHit(nodes[farChild], dist);
+        if (nearDist > farDist) {
+            std::swap(nearChild, farChild);
+            std::swap(nearDist, farDist);
+        }
+
+        if (nearDist >= INFINITY_DISTANCE) {
+            if (stackSize == 0) break;
+            nodeIndex = stack[--stackSize];
+            continue;
+        }
+        nodeIndex = nearChild;
+        if (farDist < INFINITY_DISTANCE && stackSize < BVH::MAX_DEPTH) {
+            stack[stackSize++] = farChild;
+        }
+    }
+
+    return dist < tMax ? dist : -1.0f;
+}
+
+// occluded() of trace.glsl: any non-light surface closer than tMax
+bool CpuRenderer::occluded(const Ray& ray, float tMax) const {
+    for (const CpuSphere& sphere : spheres) {
+        float side;
+        float bd = sphereHit(ray.point, ray.dir, sphere.center, sphere.radius, side);
+        if (bd > 0.0f && bd < tMax) {
+            return true;
+        }
+    }
+    for (const CpuBox& box : boxes) {
+        Float3 boxNormal;
+        float bd = boxHit(ray.point, ray.dir, box.transform, boxNormal);
+        if (bd > 0.0f && bd < tMax) {
+            return true;
+        }
+    }
+    return mesh && meshOccluded(ray, tMax);
+}
+
+// meshOccluded() of scene.glsl: stops at the first triangle, children are only culled, not sorted
+bool CpuRenderer::meshOccluded(const Ray& ray, float tMax) const {
+    const std::vector<BVHNode>& nodes = bvh->getNodes();
+    Float3 invDir = {1.0f / ray.dir.x, 1.0f / ray.dir.y, 1.0f / ray.dir.z};
+
+    auto aabbHit = [&](const BVHNode& node) {
+        float tx0 = (node.boundsMin.x - ray.point.x) * invDir.x, tx1 = (node.boundsMax.x - ray.point.x) * invDir.x;
+        float ty0 = (node.boundsMin.y - ray.point.y) * invDir.y, ty1 = (node.boundsMax.y - ray.point.y) * invDir.y;
+        float tz0 = (node.boundsMin.z - ray.point.z) * invDir.z, tz1 = (node.boundsMax.z - ray.point.z) * invDir.z;
+        float tn = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::max(std::min(tz0, tz1), 0.0f));
+        float tf = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::min(std::max(tz0, tz1), tMax));
+        return tn <= tf;
+    };
+
+    if (!aabbHit(nodes[0])) {
+        return false;
+    }
+
+    uint32_t stack[BVH::MAX_DEPTH];
+    int stackSize = 0;
+    uint32_t nodeIndex = 0;
+    while (true) {
+        const BVHNode& node = nodes[nodeIndex];
+        if (node.triangleCount > 0) {
+            for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.triangleCount; i++) {
+                Float3 v0 = toFloat3(mesh->vertices[mesh->indices[i * 3]]);
+                Float3 v1 = toFloat3(mesh->vertices[mesh->indices[i * 3 + 1]]);
+                Float3 v2 = toFloat3(mesh->vertices[mesh->indices[i * 3 + 2]]);
+                float u, v;
+                float t = triangleHit(ray.point, ray.dir, v0, v1, v2, u, v);
+                if (t > 0.0f && t < tMax) {
+                    return true;
+                }
+            }
+        } else {
+            uint32_t leftChild = nodeIndex + 1;
+            uint32_t rightChild = node.leftOrFirst;
+            bool hitLeft = aabbHit(nodes[leftChild]);
+            bool hitRight = aabbHit(nodes[rightChild]);
+            if (hitLeft) {
+                if (hitRight && stackSize < BVH::MAX_DEPTH) {
+                    stack[stackSize++] = rightChild;
+                }
+                nodeIndex = leftChild;
+                continue;
+            }
+            if (hitRight) {
+                nodeIndex = rightChild;
+                continue;
+            }
+        }
+        if (stackSize == 0) break;
+        nodeIndex = stack[--stackSize];
+    }
+    return false;
+}
+
+// sampleLight() of trace.glsl with shadow rays, couldBeLit is its w component
+Float3 CpuRenderer::sampleLight(const Float3& point, const Float3& surfaceNormal, Random& random, float& couldBeLit) const {
+    Float3 lightness = {0.0f, 0.0f, 0.0f};
+    couldBeLit = INFINITY_DISTANCE;
+
+    // lightHit(ray) is the distance to the picked light along the ray
+    auto addLight = [&](const Float3& lightPos, const CpuMaterial& lightMaterial, float weight, auto lightHit) {
+        Float3 dirToLight = lightPos - point;
+        Ray lightRay;
+        lightRay.dir = normalize(dirToLight);
+        lightRay.point = point + lightRay.dir * 0.0001f;
+        float squareDist = dot(dirToLight, dirToLight);
+        float lightDist = lightHit(lightRay);
+        float distance = lightDist > 0.0f ? lightDist : std::sqrt(squareDist);
+
+        if (!occluded(lightRay, distance)) {
+            float cosine = std::min(std::max(dot(lightRay.dir, surfaceNormal), 0.0f), 1.0f);
+            lightness = lightness + lightMaterial.color * (cosine * weight / distance);
+        } else {
+            couldBeLit = std::min(squareDist / (lightMaterial.color.x + lightMaterial.color.y + lightMaterial.color.z), couldBeLit);
+        }
+    };
+
+    uint32_t lightDimension = random.sampler.dimension;
+    random.sampler.dimension += Sampler::DIMS_PER_LIGHT * LIGHT_SAMPLES;
+    if (lightTable.size() == 0) {
+        return lightness;
+    }
+    for (int s = 0; s < LIGHT_SAMPLES; s++) {
+        uint32_t light = lightTable.sample(random.sampler.get(lightDimension + s * Sampler::DIMS_PER_LIGHT + 3));
+        random.sampler.dimension = lightDimension + s * Sampler::DIMS_PER_LIGHT;
+        float weight = 1.0f / (lightTable.pdf[light] * LIGHT_SAMPLES);
+        if (light < sphereLights.size()) {
+            const CpuSphere& sphere = sphereLights[light];
+            addLight(sphere.center + random.randomSphereDirection() * sphere.radius, materials[sphere.material], weight,
+                     [&](const Ray& ray) { float side; return sphereHit(ray.point, ray.dir, sphere.center, sphere.radius, side); });
+        } else {
+            const CpuBox& box = boxLights[light - sphereLights.size()];
+            addLight(boxSurfacePoint(box.transform, random.hash3()), materials[box.material], weight,
+                     [&](const Ray& ray) { Float3 boxNormal; return boxHit(ray.point, ray.dir, box.transform, boxNormal); });
+        }
+    }
+    random.sampler.dimension = lightDimension + Sampler::DIMS_PER_LIGHT * LIGHT_SAMPLES;
+    return lightness;
+}
@@ -0,0 +1,88 @@
+#ifndef CPU_RENDERER_HPP
+#define CPU_RENDERER_HPP
+
+#include "includes.hpp"
+#include "intersect.hpp"
+#include "tilePool.hpp"
+#include "scene.hpp"
+#include "mesh.hpp"
+#include "bvh.hpp"
+#include "aliasTable.hpp"
+
+// Path tracer on the CPU for hosts without a usable GPU: the megakernel (triangle_RayTrace_shader.glsl,
+// full variant) ported to C++, including its adaptive sample loop, rendered in 16x16 tiles on a
+// work-stealing TilePool. Produces the same color, normal and depth images as the compute shader.
+class CpuRenderer {
+public:
+    static constexpr int TILE_SIZE = 16;
+    static constexpr int MAX_SAMPLES = 10;   // RAY_SAMPLES of the full variant
+    static constexpr int MAX_BOUNCES = 5;    // RAY_BOUNCES
+    static constexpr int LIGHT_SAMPLES = 2;  // LIGHT_SAMPLES
+
+    CpuRenderer(int width, int height, int threadCount = static_cast<int>(std::thread::hardware_concurrency()));
+
+    // Copy the scene's current state (call again after it animates). The mesh and BVH are referenced,
+    // they must outlive the renderer and not change.
+    void setScene(const Scene& scene, const Mesh* mesh = nullptr, const BVH* bvh = nullptr);
+
+    // Renders one frame with the camera from the frame uniforms (camera relative inverse view-projection)
+    void render(const glm::mat4& invViewProj, const glm::vec3& cameraPosition, unsigned int frameNo, int samples, int bounces);
+
+    // Replaces the worker threads, for measuring how the frame time scales with them
+    void setThreadCount(int threadCount);
+    int getThreadCount() const { return pool->getThreadCount(); }
+    size_t getStolenTiles() const { return pool->getStolenCount(); }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    // Row-major with row 0 at the bottom, like the GPU images
+    const std::vector<glm::vec4>& getColor() const { return color; }    // rgb, a = 1
+    const std::vector<glm::vec4>& getNormal() const { return normal; }  // xyz, a = 1
+    const std::vector<float>& getDepth() const { return depth; }        // Primary hit distance
+
+private:
+    struct CpuMaterial {
+        int type;           // 0 = light, 1 = surface
+        float opaqueness, smoothness, specularity;
+        Float3 color;
+    };
+    struct CpuSphere {
+        Float3 center;
+        float radius;
+        int material;
+    };
+    struct CpuBox {
+        BoxTransform transform;
+        int material;
+    };
+    struct Ray {
+        Float3 point, dir, col;
+    };
+    struct Random;
+
+    void renderTile(int tile, const glm::mat4& invViewProj, const Float3& cameraPosition, unsigned int frameNo, int samples, int bounces);
+    float rayDist(const Ray& ray, Float3& hitNormal, CpuMaterial& material) const;
+    float meshHit(const Ray& ray, float tMax, Float3& hitNormal) const;
+    bool occluded(const Ray& ray, float tMax) const;
+    bool meshOccluded(const Ray& ray, float tMax) const;
+    Float3 sampleLight(const Float3& point, const Float3& surfaceNormal, Random& random, float& couldBeLit) const;
+    Float3 traceRay(Ray ray, int x, int y, unsigned int frameNo, int samples, int bounces);
+
+    int width, height;
+    std::unique_ptr<TilePool> pool;
+
+    std::vector<CpuMaterial> materials;
+    std::vector<CpuSphere> spheres, sphereLights;
+    std::vector<CpuBox> boxes, boxLights;
+    AliasTable lightTable;      // The scene's, over the sphere lights then the box lights
+    int meshMaterial = 0;
+    const Mesh* mesh = nullptr;
+    const BVH* bvh = nullptr;
+
+    std::vector<glm::vec4> color;
+    std::vector<glm::vec4> normal;
+    std::vector<float> depth;
+};
+
+#endif // CPU_RENDERER_HPP
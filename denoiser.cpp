@@ -0,0 +1,42 @@
+#include "includes.hpp"
+#include "denoiser.hpp"
+
+Denoiser::Denoiser(ShaderCache& shaderCache) {
+    varianceProgram = shaderCache.get({{GL_COMPUTE_SHADER, "shaders/compute/denoise/variance.glsl"}});
+    // The stride is a compile time constant, so the small ones can use the shared memory tile
+    for (int i = 0; i < MAX_ITERATIONS; i++) {
+        atrousPrograms[i] = shaderCache.get({{GL_COMPUTE_SHADER, "shaders/compute/denoise/atrous.glsl"}},
+                                            {{"STEP_SIZE", std::to_string(1 << i)}});
+    }
+}
+
+void Denoiser::estimateVariance(const Texture& color, const Texture& normal, const Texture& depth, const Texture& output) {
+    varianceProgram->use();
+    varianceProgram->setImage("colorTexture", color.getID(), 0, GL_RGBA16F);
+    varianceProgram->setImage("normalTexture", normal.getID(), 1, GL_RGBA16F);
+    varianceProgram->setImage("depthTexture", depth.getID(), 2, GL_R32F);
+    varianceProgram->setImage("outputTexture", output.getID(), 3, GL_RGBA16F);
+    glDispatchCompute((color.getWidth() + 15) / 16, (color.getHeight() + 15) / 16, 1);
+}
+
+const Texture& Denoiser::filter(const Texture& filtered, const Texture& scratch, const Texture& normal, const Texture& depth, int iterations) {
+    GLuint groupsX = (filtered.getWidth() + 15) / 16;
+    GLuint groupsY = (filtered.getHeight() + 15) / 16;
+
+    const Texture* pingPong[2] = {&filtered, &scratch};
+    int current = 0;
+    for (int i = 0; i < std::min(iterations, MAX_ITERATIONS); i++) {
+        if (i > 0) {
+            glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        }
+        const std::shared_ptr<Shader>& program = atrousPrograms[i];
+        program->use();
+        program->setImage("colorTexture", pingPong[current]->getID(), 0, GL_RGBA16F);
+        program->setImage("normalTexture", normal.getID(), 1, GL_RGBA16F);
+        program->setImage("depthTexture", depth.getID(), 2, GL_R32F);
+        program->setImage("outputTexture", pingPong[1 - current]->getID(), 3, GL_RGBA16F);
+        glDispatchCompute(groupsX, groupsY, 1);
+        current = 1 - current;
+    }
+    return *pingPong[current];
+}
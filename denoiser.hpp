@@ -0,0 +1,32 @@
+#ifndef DENOISER_HPP
+#define DENOISER_HPP
+
+#include "includes.hpp"
+#include "shaderStuff.hpp"
+
+// SVGF style spatial denoiser as compute passes: a luminance variance estimate, then à-trous
+// iterations with the tap stride doubling each time (1, 2, 4, ...), ping-ponging between two
+// textures. Edge stops on depth, normal and variance keep it from blurring across surfaces.
+// The caller provides the textures (RGBA16F, sized like color) so they can come from a pool; the
+// barrier before the result is read is the caller's too.
+class Denoiser {
+public:
+    static constexpr int MAX_ITERATIONS = 5;
+
+    explicit Denoiser(ShaderCache& shaderCache);
+
+    // Writes color (rgb) and its variance (a) into output, with the primary hit normals and distances
+    // of the same frame as edge stops
+    void estimateVariance(const Texture& color, const Texture& normal, const Texture& depth, const Texture& output);
+
+    // À-trous iterations (clamped to MAX_ITERATIONS) on the output of estimateVariance() in filtered,
+    // ping-ponging with scratch. The result ends up in filtered after an even count, in scratch after
+    // an odd one; that texture is returned.
+    const Texture& filter(const Texture& filtered, const Texture& scratch, const Texture& normal, const Texture& depth, int iterations);
+
+private:
+    std::shared_ptr<Shader> varianceProgram;
+    std::shared_ptr<Shader> atrousPrograms[MAX_ITERATIONS];
+};
+
+#endif // DENOISER_HPP
@@ -0,0 +1,60 @@
+#include "includes.hpp"
+#include "frameUniforms.hpp"
+
+FrameUniformRing::FrameUniformRing(GLuint bindingPoint) : bindingPoint(bindingPoint) {
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    slotSize = (sizeof(FrameUniforms) + alignment - 1) / alignment * alignment;
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    if (GLEW_ARB_buffer_storage) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_UNIFORM_BUFFER, slotSize * SLOTS, nullptr, flags);
+        mapped = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, slotSize * SLOTS, flags));
+    } else {
+        glBufferData(GL_UNIFORM_BUFFER, slotSize * SLOTS, nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+FrameUniformRing::~FrameUniformRing() {
+    for (GLsync fence : fences) {
+        if (fence) {
+            glDeleteSync(fence);
+        }
+    }
+    if (mapped) {
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &buffer);
+}
+
+void FrameUniformRing::upload(const FrameUniforms& uniforms) {
+    // Only blocks if the GPU is more than SLOTS frames behind
+    if (fences[slot]) {
+        while (glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {}
+        glDeleteSync(fences[slot]);
+        fences[slot] = nullptr;
+    }
+
+    size_t offset = slot * slotSize;
+    if (mapped) {
+        std::memcpy(mapped + offset, &uniforms, sizeof(FrameUniforms));
+    } else {
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, sizeof(FrameUniforms), &uniforms);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    glBindBufferRange(GL_UNIFORM_BUFFER, bindingPoint, buffer, offset, sizeof(FrameUniforms));
+}
+
+void FrameUniformRing::endFrame() {
+    if (fences[slot]) {
+        glDeleteSync(fences[slot]);
+    }
+    fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot = (slot + 1) % SLOTS;
+}
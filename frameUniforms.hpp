@@ -0,0 +1,45 @@
+#ifndef FRAME_UNIFORMS_HPP
+#define FRAME_UNIFORMS_HPP
+
+#include "includes.hpp"
+
+// Per-frame constants (std140), must match FrameUniforms in shaders/compute/include/frame.glsl
+struct FrameUniforms {
+    glm::mat4 invViewProj;      // Clip space to world directions (view without translation)
+    glm::mat4 prevViewProj;     // Last frame's camera relative view-projection, for reprojection
+    glm::vec3 cameraPosition;
+    uint32_t frameNo;
+    glm::vec3 prevCameraPosition;
+    float historyLimit;         // Max frames in the temporal history, 1 discards it
+    uint32_t samplesPerPixel;   // Runtime sample and bounce counts, capped by the variant's defines
+    uint32_t maxBounces;
+    glm::uvec2 resolution;      // Size of the traced image
+};
+
+static_assert(sizeof(FrameUniforms) == 176, "FrameUniforms must match the std140 layout in the shader");
+
+// Uniform buffer with one slot per frame in flight, persistently mapped where GL 4.4 buffer storage
+// is available. A fence per slot keeps the CPU from overwriting constants the GPU hasn't read yet.
+class FrameUniformRing {
+public:
+    static constexpr int SLOTS = 3;
+
+    explicit FrameUniformRing(GLuint bindingPoint);
+    ~FrameUniformRing();
+
+    // Waits until the next slot is free, copies the constants in and binds that slot
+    void upload(const FrameUniforms& uniforms);
+
+    // Fences the current slot, call after the frame's last draw/dispatch that reads it
+    void endFrame();
+
+private:
+    GLuint buffer = 0;
+    GLuint bindingPoint;
+    size_t slotSize;              // sizeof(FrameUniforms) rounded up to the UBO offset alignment
+    unsigned char* mapped = nullptr;   // Null when falling back to glBufferSubData
+    GLsync fences[SLOTS] = {};
+    int slot = 0;
+};
+
+#endif // FRAME_UNIFORMS_HPP
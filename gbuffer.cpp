@@ -0,0 +1,82 @@
+#include "includes.hpp"
+#include "gbuffer.hpp"
+
+GBuffer::GBuffer(int width, int height)
+    : width(width), height(height),
+      normalTexture(width, height, GL_RG16_SNORM, GL_RG, GL_FLOAT),
+      distanceTexture(width, height, GL_R32F, GL_RED, GL_FLOAT),
+      materialTexture(width, height, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT),
+      depthTexture(width, height, GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT) {
+    framebuffer.attachTexture(normalTexture, 0);
+    framebuffer.attachTexture(distanceTexture, 1);
+    framebuffer.attachTexture(materialTexture, 2);
+    framebuffer.attachDepthTexture(depthTexture);
+    if (!framebuffer.isComplete()) {
+        std::cerr << "G-buffer framebuffer is incomplete!" << std::endl;
+    }
+    framebuffer.unbind();
+
+    glGenVertexArrays(1, &vao);
+}
+
+GBuffer::~GBuffer() {
+    glDeleteVertexArrays(1, &vao);
+}
+
+void GBuffer::setVariant(ShaderCache& shaderCache, const ShaderDefines& defines) {
+    ShaderDefines passDefines;
+    auto it = defines.find("USE_MESH");
+    if (it != defines.end()) {
+        passDefines["USE_MESH"] = it->second;
+    }
+    drawMesh = it == defines.end() || it->second != "0";
+    program = shaderCache.get({
+        {GL_VERTEX_SHADER, "shaders/rendering/gbuffer/vertex.glsl"},
+        {GL_FRAGMENT_SHADER, "shaders/rendering/gbuffer/fragment.glsl"}
+    }, passDefines);
+}
+
+void GBuffer::render(const glm::mat4& viewProj, const Scene& scene, size_t triangleCount) {
+    GLint previousFramebuffer;
+    GLint previousViewport[4];
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, previousViewport);
+
+    framebuffer.bind();
+    glViewport(0, 0, width, height);
+    const GLfloat noNormal[] = {0.0f, 0.0f, 0.0f, 0.0f};
+    const GLfloat noDistance[] = {99999999.0f, 0.0f, 0.0f, 0.0f};  // infinity in common.glsl
+    const GLuint noMaterial[] = {NO_MATERIAL, 0, 0, 0};
+    const GLfloat farDepth = 1.0f;
+    glClearBufferfv(GL_COLOR, 0, noNormal);
+    glClearBufferfv(GL_COLOR, 1, noDistance);
+    glClearBufferuiv(GL_COLOR, 2, noMaterial);
+    glClearBufferfv(GL_DEPTH, 0, &farDepth);
+
+    // Every face of a bounding cube finds the same hit, so nothing is culled: the far faces still
+    // cover the object when the camera is inside its cube
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glDisable(GL_CULL_FACE);
+
+    // The compute shaders trace through the pixel's corner, the rasterizer samples its center
+    glm::mat4 pixelShift = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f / width, 1.0f / height, 0.0f));
+    program->use();
+    program->setMat4("rasterViewProj", pixelShift * viewProj);
+    glBindVertexArray(vao);
+
+    size_t objectCount = scene.getSpheres().size() + scene.getBoxes().size() +
+                         scene.getSphereLights().size() + scene.getBoxLights().size();
+    if (objectCount > 0) {
+        program->setUInt("meshPass", 0);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 36, static_cast<GLsizei>(objectCount));
+    }
+    if (drawMesh && triangleCount > 0) {
+        program->setUInt("meshPass", 1);
+        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(triangleCount * 3));
+    }
+
+    glBindVertexArray(0);
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+}
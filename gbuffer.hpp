@@ -0,0 +1,46 @@
+#ifndef GBUFFER_HPP
+#define GBUFFER_HPP
+
+#include "includes.hpp"
+#include "shaderStuff.hpp"
+#include "scene.hpp"
+
+// Rasterized primary visibility at the trace resolution. Spheres and boxes are drawn as instanced
+// bounding cubes whose fragments intersect the real shape on the compute shaders' camera ray and
+// write its depth, mesh triangles are drawn as they are. The result per pixel: depth, octahedral
+// normal (RG16 snorm), hit distance (R32F) and material index (R32UI, NO_MATERIAL where nothing
+// was hit). The megakernel's RASTER_PRIMARY variant starts its paths there instead of casting primary rays.
+class GBuffer {
+public:
+    static constexpr GLuint NO_MATERIAL = 0xffffffffu;    // NO_MATERIAL in shaders/rendering/gbuffer/
+
+    GBuffer(int width, int height);
+    ~GBuffer();
+
+    // Compile (through the cache) with the variant's USE_MESH
+    void setVariant(ShaderCache& shaderCache, const ShaderDefines& defines);
+
+    // Draw the scene's objects and the first triangleCount mesh triangles as seen through viewProj
+    // (camera relative, the inverse of the frame uniforms' invViewProj). Frame uniforms, scene and mesh
+    // buffers must be bound. The framebuffer and viewport bound before are restored.
+    void render(const glm::mat4& viewProj, const Scene& scene, size_t triangleCount);
+
+    const Texture& getNormalTexture() const { return normalTexture; }
+    const Texture& getDistanceTexture() const { return distanceTexture; }
+    const Texture& getMaterialTexture() const { return materialTexture; }
+    const Texture& getDepthTexture() const { return depthTexture; }
+
+private:
+    int width, height;
+    Texture normalTexture;
+    Texture distanceTexture;
+    Texture materialTexture;
+    Texture depthTexture;
+    Framebuffer framebuffer;
+    GLuint vao;     // Empty, the vertex shader reads the scene and mesh buffers
+
+    std::shared_ptr<Shader> program;
+    bool drawMesh = true;
+};
+
+#endif // GBUFFER_HPP
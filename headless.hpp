@@ -0,0 +1,21 @@
+#ifndef HEADLESS_HPP
+#define HEADLESS_HPP
+
+#include "includes.hpp"
+
+// Offscreen OpenGL context without a window, created through EGL.
+// Prefers the Mesa surfaceless platform so it also works on GPU-less machines (llvmpipe).
+class HeadlessContext {
+public:
+    HeadlessContext(int majorVersion = 4, int minorVersion = 3);
+    ~HeadlessContext();
+
+    bool isValid() const { return context != nullptr; }
+
+private:
+    // EGL handles are kept as void* so EGL (and X11) headers stay out of the rest of the build
+    void* display;
+    void* context;
+};
+
+#endif // HEADLESS_HPP
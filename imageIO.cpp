@@ -0,0 +1,245 @@
+#include "includes.hpp"
+#include "imageIO.hpp"
+
+bool writePPM(const std::string& filepath, int width, int height, const std::vector<glm::vec4>& pixels) {
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not write image: " << filepath << std::endl;
+        return false;
+    }
+
+    file << "P6\n" << width << " " << height << "\n255\n";
+    std::vector<unsigned char> row(width * 3);
+    // PPM starts with the top row
+    for (int y = height - 1; y >= 0; y--) {
+        for (int x = 0; x < width; x++) {
+            const glm::vec4& pixel = pixels[y * width + x];
+            for (int c = 0; c < 3; c++) {
+                row[x * 3 + c] = static_cast<unsigned char>(std::min(std::max(pixel[c], 0.0f), 1.0f) * 255.0f + 0.5f);
+            }
+        }
+        file.write(reinterpret_cast<const char*>(row.data()), row.size());
+    }
+    return static_cast<bool>(file);
+}
+
+namespace {
+
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> result{};
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            result[n] = c;
+        }
+        return result;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void appendBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+void writePNGChunk(std::ofstream& file, const char* type, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> chunk;
+    appendBigEndian(chunk, static_cast<uint32_t>(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    appendBigEndian(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+    file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+}
+
+template <typename T>
+void appendLittleEndian(std::vector<uint8_t>& out, T value) {
+    for (size_t i = 0; i < sizeof(T); i++) {
+        out.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i)));
+    }
+}
+
+void appendFloat(std::vector<uint8_t>& out, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    appendLittleEndian(out, bits);
+}
+
+void appendAttribute(std::vector<uint8_t>& out, const char* name, const char* type, const std::vector<uint8_t>& value) {
+    out.insert(out.end(), name, name + std::strlen(name) + 1);
+    out.insert(out.end(), type, type + std::strlen(type) + 1);
+    appendLittleEndian(out, static_cast<int32_t>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+} // namespace
+
+bool writePNG(const std::string& filepath, int width, int height, const uint8_t* rgba) {
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not write image: " << filepath << std::endl;
+        return false;
+    }
+
+    // Scanlines from the top, each with filter type 0
+    std::vector<uint8_t> raw;
+    raw.reserve(static_cast<size_t>(height) * (width * 3 + 1));
+    for (int y = height - 1; y >= 0; y--) {
+        raw.push_back(0);
+        const uint8_t* row = rgba + static_cast<size_t>(y) * width * 4;
+        for (int x = 0; x < width; x++) {
+            raw.insert(raw.end(), row + x * 4, row + x * 4 + 3);
+        }
+    }
+
+    // zlib stream of stored deflate blocks (at most 65535 bytes each) and the Adler-32 of the data
+    std::vector<uint8_t> zlib = {0x78, 0x01};
+    size_t offset = 0;
+    do {
+        size_t blockSize = std::min<size_t>(raw.size() - offset, 65535);
+        bool last = offset + blockSize == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        appendLittleEndian(zlib, static_cast<uint16_t>(blockSize));
+        appendLittleEndian(zlib, static_cast<uint16_t>(~blockSize));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+        offset += blockSize;
+    } while (offset < raw.size());
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : raw) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    appendBigEndian(zlib, (b << 16) | a);
+
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+    std::vector<uint8_t> header;
+    appendBigEndian(header, width);
+    appendBigEndian(header, height);
+    header.insert(header.end(), {8, 2, 0, 0, 0});   // 8 bits, RGB, deflate, no filter method, no interlace
+    writePNGChunk(file, "IHDR", header);
+    writePNGChunk(file, "IDAT", zlib);
+    writePNGChunk(file, "IEND", {});
+    return static_cast<bool>(file);
+}
+
+bool writeEXR(const std::string& filepath, int width, int height, const uint16_t* rgbaHalf) {
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not write image: " << filepath << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> header;
+    appendLittleEndian(header, static_cast<uint32_t>(20000630));   // Magic number
+    appendLittleEndian(header, static_cast<uint32_t>(2));          // Version 2, scanline image
+
+    // Channels in alphabetical order, the order of the pixel data too
+    std::vector<uint8_t> channels;
+    for (const char* name : {"B", "G", "R"}) {
+        channels.insert(channels.end(), name, name + 2);
+        appendLittleEndian(channels, static_cast<int32_t>(1));     // HALF
+        appendLittleEndian(channels, static_cast<uint32_t>(0));    // pLinear and reserved
+        appendLittleEndian(channels, static_cast<int32_t>(1));     // xSampling
+        appendLittleEndian(channels, static_cast<int32_t>(1));     // ySampling
+    }
+    channels.push_back(0);
+    appendAttribute(header, "channels", "chlist", channels);
+    appendAttribute(header, "compression", "compression", {0});   // NO_COMPRESSION
+
+    std::vector<uint8_t> window;
+    for (int32_t value : {0, 0, width - 1, height - 1}) {
+        appendLittleEndian(window, value);
+    }
+    appendAttribute(header, "dataWindow", "box2i", window);
+    appendAttribute(header, "displayWindow", "box2i", window);
+    appendAttribute(header, "lineOrder", "lineOrder", {0});       // INCREASING_Y
+    std::vector<uint8_t> value;
+    appendFloat(value, 1.0f);
+    appendAttribute(header, "pixelAspectRatio", "float", value);
+    value.clear();
+    appendFloat(value, 0.0f);
+    appendFloat(value, 0.0f);
+    appendAttribute(header, "screenWindowCenter", "v2f", value);
+    value.clear();
+    appendFloat(value, 1.0f);
+    appendAttribute(header, "screenWindowWidth", "float", value);
+    header.push_back(0);
+
+    // One scanline per block: y, byte count, then each channel's values for the whole line
+    uint64_t lineSize = 8 + static_cast<uint64_t>(width) * 3 * 2;
+    uint64_t firstLine = header.size() + static_cast<uint64_t>(height) * 8;
+    for (int y = 0; y < height; y++) {
+        appendLittleEndian(header, firstLine + y * lineSize);
+    }
+    file.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+    std::vector<uint8_t> line;
+    for (int y = 0; y < height; y++) {
+        line.clear();
+        appendLittleEndian(line, static_cast<int32_t>(y));
+        appendLittleEndian(line, static_cast<int32_t>(width * 3 * 2));
+        const uint16_t* row = rgbaHalf + static_cast<size_t>(height - 1 - y) * width * 4;
+        for (int channel : {2, 1, 0}) {
+            for (int x = 0; x < width; x++) {
+                appendLittleEndian(line, row[x * 4 + channel]);
+            }
+        }
+        file.write(reinterpret_cast<const char*>(line.data()), line.size());
+    }
+    return static_cast<bool>(file);
+}
+
+Y4MWriter::Y4MWriter(std::ostream& stream, int width, int height, int framesPerSecond)
+    : stream(stream), width(width), height(height) {
+    stream << "YUV4MPEG2 W" << width << " H" << height << " F" << framesPerSecond << ":1 Ip A1:1 C420jpeg\n";
+}
+
+bool Y4MWriter::writeFrame(const uint8_t* rgba) {
+    int chromaWidth = (width + 1) / 2;
+    int chromaHeight = (height + 1) / 2;
+    planes.resize(static_cast<size_t>(width) * height + 2 * chromaWidth * chromaHeight);
+    uint8_t* yPlane = planes.data();
+    uint8_t* uPlane = yPlane + width * height;
+    uint8_t* vPlane = uPlane + chromaWidth * chromaHeight;
+
+    auto pixel = [&](int x, int y, int channel) {
+        // Top row first
+        return static_cast<float>(rgba[(static_cast<size_t>(height - 1 - y) * width + x) * 4 + channel]);
+    };
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            float luma = 0.299f * pixel(x, y, 0) + 0.587f * pixel(x, y, 1) + 0.114f * pixel(x, y, 2);
+            yPlane[y * width + x] = static_cast<uint8_t>(std::min(255.0f, luma + 0.5f));
+        }
+    }
+    // Chroma of each 2x2 block's average
+    for (int cy = 0; cy < chromaHeight; cy++) {
+        for (int cx = 0; cx < chromaWidth; cx++) {
+            float r = 0.0f, g = 0.0f, b = 0.0f;
+            for (int i = 0; i < 4; i++) {
+                int x = std::min(cx * 2 + i % 2, width - 1);
+                int y = std::min(cy * 2 + i / 2, height - 1);
+                r += pixel(x, y, 0) * 0.25f;
+                g += pixel(x, y, 1) * 0.25f;
+                b += pixel(x, y, 2) * 0.25f;
+            }
+            float u = 128.0f - 0.168736f * r - 0.331264f * g + 0.5f * b;
+            float v = 128.0f + 0.5f * r - 0.418688f * g - 0.081312f * b;
+            uPlane[cy * chromaWidth + cx] = static_cast<uint8_t>(std::min(std::max(u + 0.5f, 0.0f), 255.0f));
+            vPlane[cy * chromaWidth + cx] = static_cast<uint8_t>(std::min(std::max(v + 0.5f, 0.0f), 255.0f));
+        }
+    }
+
+    stream << "FRAME\n";
+    stream.write(reinterpret_cast<const char*>(planes.data()), planes.size());
+    stream.flush();
+    return static_cast<bool>(stream);
+}
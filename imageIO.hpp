@@ -0,0 +1,31 @@
+#ifndef IMAGE_IO_HPP
+#define IMAGE_IO_HPP
+
+#include "includes.hpp"
+
+// Image writers for rendered frames. Every input has row 0 at the bottom (GL order), the files start
+// with the top row. Colors are linear and clamped, like the fullscreen quad shows them.
+
+// Binary PPM (P6) of a float color image
+bool writePPM(const std::string& filepath, int width, int height, const std::vector<glm::vec4>& pixels);
+
+// 8-bit RGB PNG from RGBA8 pixels, stored (uncompressed) deflate blocks so no zlib is needed
+bool writePNG(const std::string& filepath, int width, int height, const uint8_t* rgba);
+
+// Uncompressed OpenEXR with half float R, G and B channels from RGBA16F pixels
+bool writeEXR(const std::string& filepath, int width, int height, const uint16_t* rgbaHalf);
+
+// YUV4MPEG2 stream (4:2:0, full range BT.601) of RGBA8 frames, for piping into ffmpeg and the like
+class Y4MWriter {
+public:
+    Y4MWriter(std::ostream& stream, int width, int height, int framesPerSecond);
+
+    bool writeFrame(const uint8_t* rgba);
+
+private:
+    std::ostream& stream;
+    int width, height;
+    std::vector<uint8_t> planes;
+};
+
+#endif // IMAGE_IO_HPP
@@ -0,0 +1,54 @@
+#include "includes.hpp"
+#include "importance.hpp"
+
+ImportanceMap::ImportanceMap(int width, int height)
+    : width(width), height(height),
+      importanceTexture((width + TILE_SIZE - 1) / TILE_SIZE, (height + TILE_SIZE - 1) / TILE_SIZE, GL_R16F, GL_RED, GL_FLOAT),
+      budgetTexture(width, height, GL_R8UI, GL_RED_INTEGER, GL_UNSIGNED_BYTE),
+      totalBuffer(Buffer::STORAGE_BUFFER, GL_DYNAMIC_COPY) {
+    float zero = 0.0f;
+    totalBuffer.generateBuffer();
+    totalBuffer.uploadData(&zero, sizeof(zero));
+}
+
+void ImportanceMap::setVariant(ShaderCache& shaderCache, const ShaderDefines& defines) {
+    ShaderDefines passDefines;
+    for (const char* name : {"USE_MESH", "SHADOWS"}) {
+        auto it = defines.find(name);
+        if (it != defines.end()) {
+            passDefines[name] = it->second;
+        }
+    }
+    importanceProgram = shaderCache.get({{GL_COMPUTE_SHADER, "shaders/compute/importance/importance.glsl"}}, passDefines);
+    reduceProgram = shaderCache.get({{GL_COMPUTE_SHADER, "shaders/compute/importance/reduce.glsl"}});
+    budgetProgram = shaderCache.get({{GL_COMPUTE_SHADER, "shaders/compute/importance/budget.glsl"}});
+}
+
+void ImportanceMap::update(float averageSamples, int maxSamples, const Texture* debugTexture) {
+    int tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    int tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+    importanceProgram->use();
+    importanceProgram->setImage("importanceTexture", importanceTexture.getID(), 0, GL_R16F);
+    glDispatchCompute((tilesX + 7) / 8, (tilesY + 7) / 8, 1);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+    totalBuffer.setBufferBinding(TOTAL_BINDING);
+    reduceProgram->use();
+    reduceProgram->setImage("importanceTexture", importanceTexture.getID(), 0, GL_R16F);
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    double budget = static_cast<double>(averageSamples) * width * height;
+    budgetProgram->use();
+    budgetProgram->setUInt("sampleBudget", static_cast<unsigned int>(std::min(budget, 4294967295.0)));
+    budgetProgram->setUInt("minSamples", 1);
+    budgetProgram->setUInt("maxSamples", std::max(1, std::min(maxSamples, 255)));
+    budgetProgram->setUInt("debugView", debugTexture ? 1 : 0);
+    budgetProgram->setImage("importanceTexture", importanceTexture.getID(), 0, GL_R16F);
+    budgetProgram->setImage("budgetTexture", budgetTexture.getID(), 1, GL_R8UI);
+    if (debugTexture) {
+        budgetProgram->setImage("debugTexture", debugTexture->getID(), 2, GL_RGBA16F);
+    }
+    glDispatchCompute((width + 15) / 16, (height + 15) / 16, 1);
+}
@@ -0,0 +1,39 @@
+#ifndef IMPORTANCE_HPP
+#define IMPORTANCE_HPP
+
+#include "includes.hpp"
+#include "shaderStuff.hpp"
+
+// Explicit importance sampling pre-pass: direct light visibility per tile into an R16F importance
+// map, summed on the GPU and turned into per-pixel sample counts (R8UI) under a fixed frame budget.
+// The megakernel's IMPORTANCE_BUDGET variant reads the counts instead of guessing inside its sample loop.
+class ImportanceMap {
+public:
+    static constexpr int TILE_SIZE = 8;     // IMPORTANCE_TILE in shaders/compute/importance/
+    static constexpr GLuint TOTAL_BINDING = 10;
+
+    ImportanceMap(int width, int height);
+
+    // Compile (through the cache) the pre-pass with the variant's defines (USE_MESH, SHADOWS)
+    void setVariant(ShaderCache& shaderCache, const ShaderDefines& defines);
+
+    // Fills the budget texture with on average averageSamples per pixel, each between 1 and maxSamples.
+    // With debugTexture set the budget is also drawn into it as a heat map. Frame uniforms must be bound.
+    // The barrier before the budget is read is the caller's.
+    void update(float averageSamples, int maxSamples, const Texture* debugTexture = nullptr);
+
+    const Texture& getImportanceTexture() const { return importanceTexture; }
+    const Texture& getBudgetTexture() const { return budgetTexture; }
+
+private:
+    int width, height;
+    Texture importanceTexture;
+    Texture budgetTexture;
+    Buffer totalBuffer;
+
+    std::shared_ptr<Shader> importanceProgram;
+    std::shared_ptr<Shader> reduceProgram;
+    std::shared_ptr<Shader> budgetProgram;
+};
+
+#endif // IMPORTANCE_HPP
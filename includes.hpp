@@ -12,5 +12,23 @@
 #include <unordered_set>
 #include <vector>
 #include <string>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <array>
+#include <filesystem>
 
 #endif
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "includes.hpp"
+#include "inputThread.hpp"
+
+InputThread::InputThread(Player& player, CameraPath* recordPath)
+    : player(player), recordPath(recordPath) {
+    // Something to render before the first step
+    snapshots.back() = player.snapshot();
+    snapshots.publish();
+    thread = std::thread(&InputThread::run, this);
+}
+
+InputThread::~InputThread() {
+    stop();
+}
+
+void InputThread::stop() {
+    running.store(false, std::memory_order_relaxed);
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void InputThread::sample(const sf::Window& window) {
+    sampled.forward = sf::Keyboard::isKeyPressed(sf::Keyboard::W);
+    sampled.backward = sf::Keyboard::isKeyPressed(sf::Keyboard::S);
+    sampled.left = sf::Keyboard::isKeyPressed(sf::Keyboard::A);
+    sampled.right = sf::Keyboard::isKeyPressed(sf::Keyboard::D);
+    sampled.up = sf::Keyboard::isKeyPressed(sf::Keyboard::Space);
+    sampled.down = sf::Keyboard::isKeyPressed(sf::Keyboard::LControl);
+    sampled.look = sf::Keyboard::isKeyPressed(sf::Keyboard::Q);
+
+    if (looking.load(std::memory_order_relaxed)) {
+        sf::Vector2i center(window.getSize().x / 2, window.getSize().y / 2);
+        sf::Vector2i mouse = sf::Mouse::getPosition(window);
+        sampled.mouseTotal += glm::ivec2(mouse.x - center.x, mouse.y - center.y);
+        sf::Mouse::setPosition(center, window);
+    }
+
+    inputs.back() = sampled;
+    inputs.publish();
+}
+
+void InputThread::run() {
+    using Clock = std::chrono::steady_clock;
+    const Clock::duration step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / RATE));
+    const sf::Time stepTime = sf::seconds(1.0f / RATE);
+
+    float recordTime = 0.0f;
+    // A running total, so samples the steps skip or see twice still move the view exactly once
+    glm::ivec2 appliedMouse(0);
+    Clock::time_point next = Clock::now();
+    while (running.load(std::memory_order_relaxed)) {
+        float aspectRatio = pendingAspectRatio.exchange(0.0f, std::memory_order_relaxed);
+        if (aspectRatio > 0.0f) {
+            player.setAspectRatio(aspectRatio);
+        }
+
+        const InputState& input = inputs.latest();
+        player.move(stepTime, input);
+        player.lookAround(glm::vec2(input.mouseTotal - appliedMouse));
+        appliedMouse = input.mouseTotal;
+        looking.store(player.isLookingAround(), std::memory_order_relaxed);
+
+        CameraSnapshot& snapshot = snapshots.back();
+        snapshot = player.snapshot();
+        snapshots.publish();
+
+        if (recordPath) {
+            recordTime += stepTime.asSeconds();
+            recordPath->addKeyframe({recordTime, snapshot.position, snapshot.yaw, snapshot.pitch});
+        }
+
+        // Fixed steps; after a long stall (debugger, suspended machine) start over instead of catching up
+        next += step;
+        Clock::time_point now = Clock::now();
+        if (now - next > step * 4) {
+            next = now;
+        }
+        std::this_thread::sleep_until(next);
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef INPUT_THREAD_HPP
+#define INPUT_THREAD_HPP
+
+#include "includes.hpp"
+#include "player.hpp"
+#include "benchmark.hpp"
+#include "tripleBuffer.hpp"
+
+// Moves the player at a fixed rate on its own thread, so camera motion isn't tied to the frame rate
+// or held up by a slow frame or a blocking display(). SFML input and the window may only be used on
+// the render thread: it samples the keys and the mouse once per frame and hands them over through a
+// triple buffer, the steps only integrate the newest sample. Each step publishes a CameraSnapshot
+// through another triple buffer; the render thread takes the newest one when it submits.
+class InputThread {
+public:
+    static constexpr int RATE = 240;  // Steps per second
+
+    // The player belongs to the thread until stop(). recordPath (optional) gets a keyframe every step.
+    InputThread(Player& player, CameraPath* recordPath = nullptr);
+    ~InputThread();
+
+    InputThread(const InputThread&) = delete;
+    InputThread& operator=(const InputThread&) = delete;
+
+    // Render thread: the newest camera, never waits
+    const CameraSnapshot& latest() { return snapshots.latest(); }
+
+    // Render thread, once per frame: reads the keys and the mouse for the next steps. While mouse
+    // look is on, the cursor's offset from the window center is added up and it is moved back there.
+    void sample(const sf::Window& window);
+
+    // Render thread: applied to the player on the next step
+    void setAspectRatio(float aspectRatio) { pendingAspectRatio.store(aspectRatio, std::memory_order_relaxed); }
+
+    void stop();
+
+private:
+    void run();
+
+    Player& player;
+    CameraPath* recordPath;
+
+    TripleBuffer<CameraSnapshot> snapshots;
+    TripleBuffer<InputState> inputs;
+    InputState sampled;                             // Render thread only
+    std::atomic<bool> looking{false};               // The player's mouse look, for sample()
+    std::atomic<float> pendingAspectRatio{0.0f};  // 0 when nothing changed
+    std::atomic<bool> running{true};
+    std::thread thread;
+};
+
+#endif // INPUT_THREAD_HPP
@@ -0,0 +1,144 @@
+#ifndef INTERSECT_HPP
+#define INTERSECT_HPP
+
+// CPU versions of the ray/primitive intersectors in shaders/compute/include/common.glsl
+// (https://iquilezles.org/articles/intersectors), same conventions: a miss returns -1.
+// Standard headers only, so it can be used and benchmarked without a GL context or glm.
+
+#include <cmath>
+
+struct Float3 {
+    float x, y, z;
+};
+
+inline Float3 operator+(const Float3& a, const Float3& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+inline Float3 operator-(const Float3& a, const Float3& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+inline Float3 operator*(const Float3& a, float s) { return {a.x * s, a.y * s, a.z * s}; }
+inline float dot(const Float3& a, const Float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline Float3 cross(const Float3& a, const Float3& b) {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+inline Float3 normalize(const Float3& a) { return a * (1.0f / std::sqrt(dot(a, a))); }
+
+// Row-major 3x3 rotation
+struct Mat3 {
+    float m[3][3];
+
+    Float3 operator*(const Float3& v) const {
+        return {m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+                m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+                m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z};
+    }
+
+    Mat3 operator*(const Mat3& b) const {
+        Mat3 r{};
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                r.m[i][j] = m[i][0] * b.m[0][j] + m[i][1] * b.m[1][j] + m[i][2] * b.m[2][j];
+            }
+        }
+        return r;
+    }
+
+    Mat3 transposed() const {
+        Mat3 r{};
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                r.m[i][j] = m[j][i];
+            }
+        }
+        return r;
+    }
+};
+
+// A box with everything boxHit() needs precomputed. The shader builds translate * rotateX * rotateY * rotateZ
+// and inverts it for every ray; the rotation is orthonormal, so the inverse is its transpose applied after
+// subtracting the position, and the normal matrix (inverse transpose) is the rotation itself.
+struct BoxTransform {
+    Float3 position;
+    Float3 size;            // Half extents
+    Mat3 worldToBox;
+    Mat3 boxToWorld;
+
+    BoxTransform() = default;
+
+    // rotation in degrees around x, y, z, like SceneBox
+    BoxTransform(const Float3& position, const Float3& size, const Float3& rotation)
+        : position(position), size(size) {
+        const float toRadians = 3.14159265f / 180.0f;
+        float xs = std::sin(rotation.x * toRadians), xc = std::cos(rotation.x * toRadians);
+        float ys = std::sin(rotation.y * toRadians), yc = std::cos(rotation.y * toRadians);
+        float zs = std::sin(rotation.z * toRadians), zc = std::cos(rotation.z * toRadians);
+        // rotateX/Y/Z from common.glsl, transposed from GLSL's column-major constructors
+        Mat3 rx = {{{1, 0, 0}, {0, xc, xs}, {0, -xs, xc}}};
+        Mat3 ry = {{{yc, 0, -ys}, {0, 1, 0}, {ys, 0, yc}}};
+        Mat3 rz = {{{zc, -zs, 0}, {zs, zc, 0}, {0, 0, 1}}};
+        boxToWorld = rx * ry * rz;
+        worldToBox = boxToWorld.transposed();
+    }
+};
+
+// Distance to the sphere, -1 on a miss. side is 1 when entering, -1 when the origin is inside, 0 on a miss
+inline float sphereHit(const Float3& origin, const Float3& dir, const Float3& center, float radius, float& side) {
+    Float3 rc = origin - center;
+    float b = dot(rc, dir);
+    float c = dot(rc, rc) - radius * radius;
+    float t = b * b - c;
+    if (t > 0.0f) {
+        float t1 = -b - std::sqrt(t);
+        float t2 = -b + std::sqrt(t);
+        if (t1 < 0.0f) {
+            side = -1.0f;
+            return t2;
+        }
+        side = 1.0f;
+        return t1;
+    }
+    side = 0.0f;
+    return -1.0f;
+}
+
+// Distance to the box, -1 on a miss, normal in world space
+inline float boxHit(const Float3& origin, const Float3& dir, const BoxTransform& box, Float3& normal) {
+    Float3 q = box.worldToBox * (origin - box.position);
+    Float3 d = box.worldToBox * dir;
+    Float3 m = {1.0f / d.x, 1.0f / d.y, 1.0f / d.z};
+    Float3 n = {m.x * q.x, m.y * q.y, m.z * q.z};
+    Float3 k = {std::fabs(m.x) * box.size.x, std::fabs(m.y) * box.size.y, std::fabs(m.z) * box.size.z};
+    Float3 t1 = {-n.x - k.x, -n.y - k.y, -n.z - k.z};
+    Float3 t2 = {-n.x + k.x, -n.y + k.y, -n.z + k.z};
+    float tn = std::fmax(std::fmax(t1.x, t1.y), t1.z);
+    float tf = std::fmin(std::fmin(t2.x, t2.y), t2.z);
+    if (tn > tf || tf < 0.0f) {
+        normal = {-1.0f, -1.0f, -1.0f};
+        return -1.0f;
+    }
+
+    // Face of the entry point from outside, of the exit point from inside
+    Float3 local = tn > 0.0f ? Float3{t1.x >= tn ? 1.0f : 0.0f, t1.y >= tn ? 1.0f : 0.0f, t1.z >= tn ? 1.0f : 0.0f}
+                             : Float3{tf >= t2.x ? 1.0f : 0.0f, tf >= t2.y ? 1.0f : 0.0f, tf >= t2.z ? 1.0f : 0.0f};
+    local = {m.x < 0.0f ? local.x : -local.x, m.y < 0.0f ? local.y : -local.y, m.z < 0.0f ? local.z : -local.z};
+    normal = box.boxToWorld * local;
+    return tn > 0.0f ? tn : tf;
+}
+
+// Distance to the triangle (-1 when the barycentrics are outside, not tested against the ray's direction,
+// like the shader), barycentric u and v
+inline float triangleHit(const Float3& origin, const Float3& dir, const Float3& v0, const Float3& v1, const Float3& v2,
+                         float& u, float& v) {
+    Float3 v1v0 = v1 - v0;
+    Float3 v2v0 = v2 - v0;
+    Float3 rov0 = origin - v0;
+    Float3 n = cross(v1v0, v2v0);
+    Float3 q = cross(rov0, dir);
+    float d = 1.0f / dot(dir, n);
+    u = -d * dot(q, v2v0);
+    v = d * dot(q, v1v0);
+    float t = -d * dot(n, rov0);
+    if (std::fmin(u, std::fmin(v, 1.0f - (u + v))) < 0.0f) {
+        t = -1.0f;
+    }
+    return t;
+}
+
+#endif // INTERSECT_HPP
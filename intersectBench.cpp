@@ -0,0 +1,211 @@
+// Microbenchmark of the CPU intersectors: checks every packet width the build supports against the
+// scalar functions, then reports millions of ray/primitive tests per second for each primitive type.
+// Build and run with "make bench" (no GL, SFML or glm needed).
+
+#include "intersect.hpp"
+#include "intersectSimd.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+const int RAY_COUNT = 4096;          // Multiple of every packet width
+const int PRIMITIVE_COUNT = 64;
+const double MIN_SECONDS = 0.25;     // Minimum measured time per kernel
+
+volatile float sink;                 // Where the benchmarks leave a sum of their results
+
+struct Triangle {
+    Float3 v0, v1, v2;
+};
+
+struct Workload {
+    std::vector<Float3> origins, dirs;
+    std::vector<Float3> sphereCenters;
+    std::vector<float> sphereRadii;
+    std::vector<BoxTransform> boxes;
+    std::vector<Triangle> triangles;
+};
+
+Workload makeWorkload() {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    auto randomPoint = [&](float scale) { return Float3{unit(rng) * scale, unit(rng) * scale, unit(rng) * scale}; };
+
+    Workload work;
+    for (int i = 0; i < RAY_COUNT; i++) {
+        // From around the camera towards the primitives, so a good part of the tests hit
+        work.origins.push_back(Float3{0.0f, 0.0f, 12.0f} + randomPoint(2.0f));
+        work.dirs.push_back(normalize(randomPoint(4.0f) - work.origins.back()));
+    }
+    for (int i = 0; i < PRIMITIVE_COUNT; i++) {
+        work.sphereCenters.push_back(randomPoint(5.0f));
+        work.sphereRadii.push_back(0.3f + 0.5f * std::fabs(unit(rng)));
+        work.boxes.emplace_back(randomPoint(5.0f), Float3{0.5f, 0.3f, 0.8f} + randomPoint(0.2f), randomPoint(180.0f));
+        Float3 corner = randomPoint(5.0f);
+        work.triangles.push_back({corner, corner + randomPoint(2.0f), corner + randomPoint(2.0f)});
+    }
+    return work;
+}
+
+template <int WIDTH>
+std::vector<RayPacket<WIDTH>> makePackets(const Workload& work) {
+    std::vector<RayPacket<WIDTH>> packets(RAY_COUNT / WIDTH);
+    for (int i = 0; i < RAY_COUNT; i++) {
+        packets[i / WIDTH].set(i % WIDTH, work.origins[i], work.dirs[i]);
+    }
+    return packets;
+}
+
+// Calls test(ray or packet index, primitive index) over the whole workload until MIN_SECONDS passed,
+// returns tests (rays times primitives) per second in millions
+template <typename Test>
+double measure(int batches, int raysPerBatch, Test test) {
+    long long tests = 0;
+    auto start = std::chrono::steady_clock::now();
+    double seconds = 0.0;
+    do {
+        for (int p = 0; p < PRIMITIVE_COUNT; p++) {
+            for (int i = 0; i < batches; i++) {
+                test(i, p);
+            }
+        }
+        tests += static_cast<long long>(batches) * raysPerBatch * PRIMITIVE_COUNT;
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (seconds < MIN_SECONDS);
+    return tests / seconds / 1e6;
+}
+
+struct Rates {
+    double sphere, box, triangle;
+};
+
+Rates benchScalar(const Workload& work) {
+    float sum = 0.0f;  // Keeps the results alive
+    Rates rates;
+    rates.sphere = measure(RAY_COUNT, 1, [&](int i, int p) {
+        float side;
+        sum += sphereHit(work.origins[i], work.dirs[i], work.sphereCenters[p], work.sphereRadii[p], side);
+    });
+    rates.box = measure(RAY_COUNT, 1, [&](int i, int p) {
+        Float3 normal;
+        sum += boxHit(work.origins[i], work.dirs[i], work.boxes[p], normal);
+    });
+    rates.triangle = measure(RAY_COUNT, 1, [&](int i, int p) {
+        float u, v;
+        const Triangle& tri = work.triangles[p];
+        sum += triangleHit(work.origins[i], work.dirs[i], tri.v0, tri.v1, tri.v2, u, v);
+    });
+    sink = sum;
+    return rates;
+}
+
+#if INTERSECT_SIMD
+bool close(float a, float b) {
+    return std::fabs(a - b) <= 1e-3f * std::max(1.0f, std::fabs(a));
+}
+
+// Number of lanes that differ from the scalar result
+template <typename F>
+int validate(const Workload& work) {
+    const int W = F::WIDTH;
+    std::vector<RayPacket<W>> packets = makePackets<W>(work);
+    HitPacket<W> hit;
+    int mismatches = 0;
+    for (int p = 0; p < PRIMITIVE_COUNT; p++) {
+        const Triangle& tri = work.triangles[p];
+        for (int i = 0; i < RAY_COUNT; i++) {
+            const RayPacket<W>& packet = packets[i / W];
+            int lane = i % W;
+            const Float3& o = work.origins[i];
+            const Float3& d = work.dirs[i];
+
+            float side;
+            float t = sphereHit(o, d, work.sphereCenters[p], work.sphereRadii[p], side);
+            sphereHitPacket<F>(packet, work.sphereCenters[p], work.sphereRadii[p], hit);
+            mismatches += !(close(t, hit.t[lane]) && side == hit.a[lane]);
+
+            Float3 normal;
+            t = boxHit(o, d, work.boxes[p], normal);
+            boxHitPacket<F>(packet, work.boxes[p], hit);
+            mismatches += !(close(t, hit.t[lane]) && close(normal.x, hit.a[lane]) &&
+                            close(normal.y, hit.b[lane]) && close(normal.z, hit.c[lane]));
+
+            float u, v;
+            t = triangleHit(o, d, tri.v0, tri.v1, tri.v2, u, v);
+            triangleHitPacket<F>(packet, tri.v0, tri.v1, tri.v2, hit);
+            mismatches += !(close(t, hit.t[lane]) && close(u, hit.a[lane]) && close(v, hit.b[lane]));
+        }
+    }
+    return mismatches;
+}
+
+template <typename F>
+Rates benchPacket(const Workload& work) {
+    const int W = F::WIDTH;
+    std::vector<RayPacket<W>> packets = makePackets<W>(work);
+    HitPacket<W> hit;
+    float sum = 0.0f;
+    int batches = RAY_COUNT / W;
+    Rates rates;
+    rates.sphere = measure(batches, W, [&](int i, int p) {
+        sphereHitPacket<F>(packets[i], work.sphereCenters[p], work.sphereRadii[p], hit);
+        sum += hit.t[0];
+    });
+    rates.box = measure(batches, W, [&](int i, int p) {
+        boxHitPacket<F>(packets[i], work.boxes[p], hit);
+        sum += hit.t[0];
+    });
+    rates.triangle = measure(batches, W, [&](int i, int p) {
+        const Triangle& tri = work.triangles[p];
+        triangleHitPacket<F>(packets[i], tri.v0, tri.v1, tri.v2, hit);
+        sum += hit.t[0];
+    });
+    sink = sum;
+    return rates;
+}
+#endif
+
+void printRates(const char* name, const Rates& rates, const Rates& scalar) {
+    std::printf("%-8s sphere %8.1f (%4.2fx)  box %8.1f (%4.2fx)  triangle %8.1f (%4.2fx)  Mtests/s\n", name,
+                rates.sphere, rates.sphere / scalar.sphere, rates.box, rates.box / scalar.box,
+                rates.triangle, rates.triangle / scalar.triangle);
+}
+
+} // namespace
+
+int main() {
+    Workload work = makeWorkload();
+    int failures = 0;
+
+#if INTERSECT_SIMD
+#ifdef __SSE4_1__
+    int sseMismatches = validate<Float4x>(work);
+    std::printf("SSE4.1 4-wide: %d mismatches against scalar\n", sseMismatches);
+    failures += sseMismatches;
+#endif
+#ifdef __AVX2__
+    int avxMismatches = validate<Float8x>(work);
+    std::printf("AVX2 8-wide: %d mismatches against scalar\n", avxMismatches);
+    failures += avxMismatches;
+#endif
+#else
+    std::printf("Built without SSE4.1/AVX2, only the scalar versions are measured\n");
+#endif
+
+    Rates scalar = benchScalar(work);
+    printRates("scalar", scalar, scalar);
+#ifdef __SSE4_1__
+    printRates("sse4.1", benchPacket<Float4x>(work), scalar);
+#endif
+#ifdef __AVX2__
+    printRates("avx2", benchPacket<Float8x>(work), scalar);
+#endif
+
+    return failures == 0 ? 0 : 1;
+}
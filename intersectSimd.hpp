@@ -0,0 +1,217 @@
+#ifndef INTERSECT_SIMD_HPP
+#define INTERSECT_SIMD_HPP
+
+// Packet versions of the intersectors in intersect.hpp: one primitive against 4 (SSE4.1) or 8 (AVX2)
+// rays at once, rays stored as structure of arrays. The kernels are written once against a small
+// vector type; which ones exist depends on the flags the file is compiled with (-msse4.1, -mavx2 or
+// -march=native), and SimdFloat/SIMD_WIDTH name the widest one. Results match the scalar versions
+// up to rounding (FMA contraction can differ between the two).
+
+#include "intersect.hpp"
+
+#if defined(__SSE4_1__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#ifdef __SSE4_1__
+struct Float4x {
+    static constexpr int WIDTH = 4;
+    __m128 v;
+
+    static Float4x load(const float* p) { return {_mm_load_ps(p)}; }
+    static Float4x broadcast(float s) { return {_mm_set1_ps(s)}; }
+    void store(float* p) const { _mm_store_ps(p, v); }
+
+    friend Float4x operator+(Float4x a, Float4x b) { return {_mm_add_ps(a.v, b.v)}; }
+    friend Float4x operator-(Float4x a, Float4x b) { return {_mm_sub_ps(a.v, b.v)}; }
+    friend Float4x operator*(Float4x a, Float4x b) { return {_mm_mul_ps(a.v, b.v)}; }
+    friend Float4x operator/(Float4x a, Float4x b) { return {_mm_div_ps(a.v, b.v)}; }
+    friend Float4x operator-(Float4x a) { return {_mm_xor_ps(a.v, _mm_set1_ps(-0.0f))}; }
+    // Comparisons give all-ones lanes where true
+    friend Float4x operator<(Float4x a, Float4x b) { return {_mm_cmplt_ps(a.v, b.v)}; }
+    friend Float4x operator>(Float4x a, Float4x b) { return {_mm_cmpgt_ps(a.v, b.v)}; }
+    friend Float4x operator>=(Float4x a, Float4x b) { return {_mm_cmpge_ps(a.v, b.v)}; }
+    friend Float4x operator|(Float4x a, Float4x b) { return {_mm_or_ps(a.v, b.v)}; }
+    friend Float4x operator&(Float4x a, Float4x b) { return {_mm_and_ps(a.v, b.v)}; }
+
+    friend Float4x min(Float4x a, Float4x b) { return {_mm_min_ps(a.v, b.v)}; }
+    friend Float4x max(Float4x a, Float4x b) { return {_mm_max_ps(a.v, b.v)}; }
+    friend Float4x sqrt(Float4x a) { return {_mm_sqrt_ps(a.v)}; }
+    friend Float4x abs(Float4x a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+    // mask ? a : b
+    friend Float4x select(Float4x mask, Float4x a, Float4x b) { return {_mm_blendv_ps(b.v, a.v, mask.v)}; }
+    friend bool none(Float4x mask) { return _mm_movemask_ps(mask.v) == 0; }
+};
+#endif
+
+#ifdef __AVX2__
+struct Float8x {
+    static constexpr int WIDTH = 8;
+    __m256 v;
+
+    static Float8x load(const float* p) { return {_mm256_load_ps(p)}; }
+    static Float8x broadcast(float s) { return {_mm256_set1_ps(s)}; }
+    void store(float* p) const { _mm256_store_ps(p, v); }
+
+    friend Float8x operator+(Float8x a, Float8x b) { return {_mm256_add_ps(a.v, b.v)}; }
+    friend Float8x operator-(Float8x a, Float8x b) { return {_mm256_sub_ps(a.v, b.v)}; }
+    friend Float8x operator*(Float8x a, Float8x b) { return {_mm256_mul_ps(a.v, b.v)}; }
+    friend Float8x operator/(Float8x a, Float8x b) { return {_mm256_div_ps(a.v, b.v)}; }
+    friend Float8x operator-(Float8x a) { return {_mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f))}; }
+    friend Float8x operator<(Float8x a, Float8x b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)}; }
+    friend Float8x operator>(Float8x a, Float8x b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)}; }
+    friend Float8x operator>=(Float8x a, Float8x b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)}; }
+    friend Float8x operator|(Float8x a, Float8x b) { return {_mm256_or_ps(a.v, b.v)}; }
+    friend Float8x operator&(Float8x a, Float8x b) { return {_mm256_and_ps(a.v, b.v)}; }
+
+    friend Float8x min(Float8x a, Float8x b) { return {_mm256_min_ps(a.v, b.v)}; }
+    friend Float8x max(Float8x a, Float8x b) { return {_mm256_max_ps(a.v, b.v)}; }
+    friend Float8x sqrt(Float8x a) { return {_mm256_sqrt_ps(a.v)}; }
+    friend Float8x abs(Float8x a) { return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)}; }
+    friend Float8x select(Float8x mask, Float8x a, Float8x b) { return {_mm256_blendv_ps(b.v, a.v, mask.v)}; }
+    friend bool none(Float8x mask) { return _mm256_movemask_ps(mask.v) == 0; }
+};
+#endif
+
+#if defined(__AVX2__)
+using SimdFloat = Float8x;
+#elif defined(__SSE4_1__)
+using SimdFloat = Float4x;
+#endif
+
+#if defined(__SSE4_1__) || defined(__AVX2__)
+#define INTERSECT_SIMD 1
+constexpr int SIMD_WIDTH = SimdFloat::WIDTH;
+#else
+#define INTERSECT_SIMD 0
+constexpr int SIMD_WIDTH = 1;
+#endif
+
+// Rays as structure of arrays, WIDTH rays per packet, aligned for the vector loads
+template <int WIDTH>
+struct RayPacket {
+    alignas(32) float originX[WIDTH];
+    alignas(32) float originY[WIDTH];
+    alignas(32) float originZ[WIDTH];
+    alignas(32) float dirX[WIDTH];
+    alignas(32) float dirY[WIDTH];
+    alignas(32) float dirZ[WIDTH];
+
+    void set(int lane, const Float3& origin, const Float3& dir) {
+        originX[lane] = origin.x; originY[lane] = origin.y; originZ[lane] = origin.z;
+        dirX[lane] = dir.x; dirY[lane] = dir.y; dirZ[lane] = dir.z;
+    }
+};
+
+// Per-lane results, same values as the scalar functions
+template <int WIDTH>
+struct HitPacket {
+    alignas(32) float t[WIDTH];
+    alignas(32) float a[WIDTH];         // sphere: side, box: normal x, triangle: u
+    alignas(32) float b[WIDTH];         // box: normal y, triangle: v
+    alignas(32) float c[WIDTH];         // box: normal z
+};
+
+template <typename F>
+struct Vec3x {
+    F x, y, z;
+};
+
+template <typename F>
+inline Vec3x<F> rotate(const Mat3& r, const Vec3x<F>& v) {
+    auto row = [&](int i) {
+        return F::broadcast(r.m[i][0]) * v.x + F::broadcast(r.m[i][1]) * v.y + F::broadcast(r.m[i][2]) * v.z;
+    };
+    return {row(0), row(1), row(2)};
+}
+
+template <typename F>
+inline void loadRays(const RayPacket<F::WIDTH>& rays, Vec3x<F>& origin, Vec3x<F>& dir) {
+    origin = {F::load(rays.originX), F::load(rays.originY), F::load(rays.originZ)};
+    dir = {F::load(rays.dirX), F::load(rays.dirY), F::load(rays.dirZ)};
+}
+
+template <typename F>
+inline void sphereHitPacket(const RayPacket<F::WIDTH>& rays, const Float3& center, float radius, HitPacket<F::WIDTH>& hit) {
+    Vec3x<F> origin, dir;
+    loadRays(rays, origin, dir);
+    F rcX = origin.x - F::broadcast(center.x);
+    F rcY = origin.y - F::broadcast(center.y);
+    F rcZ = origin.z - F::broadcast(center.z);
+    F b = rcX * dir.x + rcY * dir.y + rcZ * dir.z;
+    F c = rcX * rcX + rcY * rcY + rcZ * rcZ - F::broadcast(radius * radius);
+    F t = b * b - c;
+
+    F zero = F::broadcast(0.0f);
+    F hitMask = t > zero;
+    F root = sqrt(max(t, zero));
+    F t1 = -b - root;
+    F t2 = -b + root;
+    F inside = t1 < zero;
+
+    select(hitMask, select(inside, t2, t1), F::broadcast(-1.0f)).store(hit.t);
+    select(hitMask, select(inside, F::broadcast(-1.0f), F::broadcast(1.0f)), zero).store(hit.a);
+}
+
+template <typename F>
+inline void boxHitPacket(const RayPacket<F::WIDTH>& rays, const BoxTransform& box, HitPacket<F::WIDTH>& hit) {
+    Vec3x<F> origin, dir;
+    loadRays(rays, origin, dir);
+    Vec3x<F> offset = {origin.x - F::broadcast(box.position.x), origin.y - F::broadcast(box.position.y),
+                       origin.z - F::broadcast(box.position.z)};
+    Vec3x<F> q = rotate(box.worldToBox, offset);
+    Vec3x<F> d = rotate(box.worldToBox, dir);
+
+    F one = F::broadcast(1.0f);
+    F zero = F::broadcast(0.0f);
+    Vec3x<F> m = {one / d.x, one / d.y, one / d.z};
+    Vec3x<F> k = {abs(m.x) * F::broadcast(box.size.x), abs(m.y) * F::broadcast(box.size.y), abs(m.z) * F::broadcast(box.size.z)};
+    Vec3x<F> t1 = {-(m.x * q.x) - k.x, -(m.y * q.y) - k.y, -(m.z * q.z) - k.z};
+    Vec3x<F> t2 = {-(m.x * q.x) + k.x, -(m.y * q.y) + k.y, -(m.z * q.z) + k.z};
+    F tn = max(max(t1.x, t1.y), t1.z);
+    F tf = min(min(t2.x, t2.y), t2.z);
+    F missMask = (tn > tf) | (tf < zero);
+
+    F outside = tn > zero;
+    auto face = [&](F entry, F exit, F mAxis) {
+        F onFace = select(outside, entry >= tn, tf >= exit);
+        F sign = select(mAxis < zero, one, -one);
+        return onFace & sign;   // The mask is all ones or zero, so this keeps sign or gives +0
+    };
+    Vec3x<F> local = {face(t1.x, t2.x, m.x), face(t1.y, t2.y, m.y), face(t1.z, t2.z, m.z)};
+    Vec3x<F> normal = rotate(box.boxToWorld, local);
+
+    F miss = F::broadcast(-1.0f);
+    select(missMask, miss, select(outside, tn, tf)).store(hit.t);
+    select(missMask, miss, normal.x).store(hit.a);
+    select(missMask, miss, normal.y).store(hit.b);
+    select(missMask, miss, normal.z).store(hit.c);
+}
+
+template <typename F>
+inline void triangleHitPacket(const RayPacket<F::WIDTH>& rays, const Float3& v0, const Float3& v1, const Float3& v2,
+                              HitPacket<F::WIDTH>& hit) {
+    Vec3x<F> origin, dir;
+    loadRays(rays, origin, dir);
+    // Edges and the normal are the same for every lane
+    Float3 v1v0 = v1 - v0;
+    Float3 v2v0 = v2 - v0;
+    Float3 n = cross(v1v0, v2v0);
+    Vec3x<F> rov0 = {origin.x - F::broadcast(v0.x), origin.y - F::broadcast(v0.y), origin.z - F::broadcast(v0.z)};
+    Vec3x<F> q = {rov0.y * dir.z - rov0.z * dir.y, rov0.z * dir.x - rov0.x * dir.z, rov0.x * dir.y - rov0.y * dir.x};
+
+    auto dotConst = [](const Vec3x<F>& a, const Float3& b) {
+        return a.x * F::broadcast(b.x) + a.y * F::broadcast(b.y) + a.z * F::broadcast(b.z);
+    };
+    F d = F::broadcast(1.0f) / dotConst(dir, n);
+    F u = -d * dotConst(q, v2v0);
+    F v = d * dotConst(q, v1v0);
+    F t = -d * dotConst(rov0, n);
+    F outsideMask = min(u, min(v, F::broadcast(1.0f) - (u + v))) < F::broadcast(0.0f);
+
+    select(outsideMask, F::broadcast(-1.0f), t).store(hit.t);
+    u.store(hit.a);
+    v.store(hit.b);
+}
+
+#endif // INTERSECT_SIMD_HPP
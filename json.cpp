@@ -0,0 +1,225 @@
+#include "includes.hpp"
+#include "json.hpp"
+
+// Recursive descent parser over the document text
+class JsonParser {
+public:
+    JsonParser(const std::string& text) : text(text), pos(0) {}
+
+    bool parseDocument(JsonValue& result, std::string& error) {
+        if (!parseValue(result)) {
+            error = message;
+            return false;
+        }
+        skipWhitespace();
+        if (pos != text.size()) {
+            fail("unexpected trailing characters");
+            error = message;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    const std::string& text;
+    size_t pos;
+    std::string message;
+
+    bool fail(const std::string& what) {
+        int line = 1 + static_cast<int>(std::count(text.begin(), text.begin() + std::min(pos, text.size()), '\n'));
+        message = "line " + std::to_string(line) + ": " + what;
+        return false;
+    }
+
+    void skipWhitespace() {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) {
+            pos++;
+        }
+    }
+
+    bool match(const char* literal) {
+        size_t length = std::strlen(literal);
+        if (text.compare(pos, length, literal) == 0) {
+            pos += length;
+            return true;
+        }
+        return false;
+    }
+
+    bool parseValue(JsonValue& value) {
+        skipWhitespace();
+        if (pos >= text.size()) {
+            return fail("unexpected end of input");
+        }
+
+        char c = text[pos];
+        if (c == '{') return parseObject(value);
+        if (c == '[') return parseArray(value);
+        if (c == '"') {
+            value.type = JsonValue::STRING;
+            return parseString(value.string);
+        }
+        if (match("true")) { value.type = JsonValue::BOOL; value.boolean = true; return true; }
+        if (match("false")) { value.type = JsonValue::BOOL; value.boolean = false; return true; }
+        if (match("null")) { value.type = JsonValue::NULL_VALUE; return true; }
+        return parseNumber(value);
+    }
+
+    bool parseNumber(JsonValue& value) {
+        const char* start = text.c_str() + pos;
+        char* end = nullptr;
+        double number = std::strtod(start, &end);
+        if (end == start) {
+            return fail("expected a value");
+        }
+        pos += end - start;
+        value.type = JsonValue::NUMBER;
+        value.number = number;
+        return true;
+    }
+
+    bool parseString(std::string& result) {
+        pos++;  // Opening quote
+        result.clear();
+        while (pos < text.size() && text[pos] != '"') {
+            char c = text[pos++];
+            if (c != '\\') {
+                result += c;
+                continue;
+            }
+            if (pos >= text.size()) {
+                break;
+            }
+            char escaped = text[pos++];
+            switch (escaped) {
+                case 'n': result += '\n'; break;
+                case 't': result += '\t'; break;
+                case 'r': result += '\r'; break;
+                case 'b': result += '\b'; break;
+                case 'f': result += '\f'; break;
+                case 'u': {
+                    // Only the ASCII range is needed for scene files
+                    if (text.size() - pos < 4) {
+                        return fail("invalid \\u escape");
+                    }
+                    unsigned int code = 0;
+                    for (int i = 0; i < 4; i++) {
+                        char digit = text[pos++];
+                        code <<= 4;
+                        if (digit >= '0' && digit <= '9') {
+                            code |= digit - '0';
+                        } else if (digit >= 'a' && digit <= 'f') {
+                            code |= digit - 'a' + 10;
+                        } else if (digit >= 'A' && digit <= 'F') {
+                            code |= digit - 'A' + 10;
+                        } else {
+                            return fail("invalid \\u escape");
+                        }
+                    }
+                    result += code < 0x80 ? static_cast<char>(code) : '?';
+                    break;
+                }
+                default: result += escaped; break;
+            }
+        }
+        if (pos >= text.size()) {
+            return fail("unterminated string");
+        }
+        pos++;  // Closing quote
+        return true;
+    }
+
+    bool parseArray(JsonValue& value) {
+        value.type = JsonValue::ARRAY;
+        pos++;
+        skipWhitespace();
+        if (pos < text.size() && text[pos] == ']') {
+            pos++;
+            return true;
+        }
+        while (true) {
+            value.elements.emplace_back();
+            if (!parseValue(value.elements.back())) {
+                return false;
+            }
+            skipWhitespace();
+            if (pos < text.size() && text[pos] == ',') {
+                pos++;
+            } else if (pos < text.size() && text[pos] == ']') {
+                pos++;
+                return true;
+            } else {
+                return fail("expected ',' or ']'");
+            }
+        }
+    }
+
+    bool parseObject(JsonValue& value) {
+        value.type = JsonValue::OBJECT;
+        pos++;
+        skipWhitespace();
+        if (pos < text.size() && text[pos] == '}') {
+            pos++;
+            return true;
+        }
+        while (true) {
+            skipWhitespace();
+            if (pos >= text.size() || text[pos] != '"') {
+                return fail("expected a member name");
+            }
+            std::string key;
+            if (!parseString(key)) {
+                return false;
+            }
+            skipWhitespace();
+            if (pos >= text.size() || text[pos] != ':') {
+                return fail("expected ':'");
+            }
+            pos++;
+
+            value.members.emplace_back(key, JsonValue());
+            if (!parseValue(value.members.back().second)) {
+                return false;
+            }
+            skipWhitespace();
+            if (pos < text.size() && text[pos] == ',') {
+                pos++;
+            } else if (pos < text.size() && text[pos] == '}') {
+                pos++;
+                return true;
+            } else {
+                return fail("expected ',' or '}'");
+            }
+        }
+    }
+};
+
+bool JsonValue::parse(const std::string& text, JsonValue& result, std::string& error) {
+    result = JsonValue();
+    JsonParser parser(text);
+    return parser.parseDocument(result, error);
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const {
+    static const JsonValue nullValue;
+    return index < elements.size() ? elements[index] : nullValue;
+}
+
+bool JsonValue::has(const std::string& key) const {
+    for (const auto& member : members) {
+        if (member.first == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const JsonValue& JsonValue::operator[](const std::string& key) const {
+    static const JsonValue nullValue;
+    for (const auto& member : members) {
+        if (member.first == key) {
+            return member.second;
+        }
+    }
+    return nullValue;
+}
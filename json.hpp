@@ -0,0 +1,44 @@
+#ifndef JSON_HPP
+#define JSON_HPP
+
+#include "includes.hpp"
+
+// Minimal JSON document reader (no writer), enough for scene files
+class JsonValue {
+public:
+    enum Type { NULL_VALUE, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+
+    // Parse a whole document, on failure error holds a message with the line number
+    static bool parse(const std::string& text, JsonValue& result, std::string& error);
+
+    Type getType() const { return type; }
+    bool isNull() const { return type == NULL_VALUE; }
+    bool isArray() const { return type == ARRAY; }
+    bool isObject() const { return type == OBJECT; }
+
+    // Typed accessors return the fallback if the value has a different type
+    double asNumber(double fallback = 0.0) const { return type == NUMBER ? number : fallback; }
+    bool asBool(bool fallback = false) const { return type == BOOL ? boolean : fallback; }
+    std::string asString(const std::string& fallback = "") const { return type == STRING ? string : fallback; }
+
+    // Array elements (empty for non-arrays)
+    const std::vector<JsonValue>& getElements() const { return elements; }
+    size_t size() const { return elements.size(); }
+    const JsonValue& operator[](size_t index) const;
+
+    // Object members, a missing key returns a null value
+    bool has(const std::string& key) const;
+    const JsonValue& operator[](const std::string& key) const;
+
+private:
+    Type type = NULL_VALUE;
+    double number = 0.0;
+    bool boolean = false;
+    std::string string;
+    std::vector<JsonValue> elements;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    friend class JsonParser;
+};
+
+#endif // JSON_HPP
@@ -0,0 +1,70 @@
+#include "includes.hpp"
+#include "logger.hpp"
+#include <cstdarg>
+
+AsyncLogger::AsyncLogger(std::ostream& out)
+    : out(out), slots(new Slot[CAPACITY]) {
+    for (size_t i = 0; i < CAPACITY; i++) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    writer = std::thread(&AsyncLogger::writerLoop, this);
+}
+
+AsyncLogger::~AsyncLogger() {
+    stopping.store(true, std::memory_order_release);
+    writer.join();
+    if (size_t count = getDropped()) {
+        out << "Logger: dropped " << count << " messages" << std::endl;
+    }
+}
+
+void AsyncLogger::log(const char* format, ...) {
+    // Claim a slot: bounded multi-producer queue, the slot's sequence says whether it is free
+    size_t position = head.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+        slot = &slots[position & (CAPACITY - 1)];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        if (sequence == position) {
+            if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (sequence < position) {
+            // Still holds a message from one lap ago, the writer is behind
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            position = head.load(std::memory_order_relaxed);
+        }
+    }
+
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(slot->text, MESSAGE_SIZE, format, args);
+    va_end(args);
+    slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+void AsyncLogger::writerLoop() {
+    bool wrote = false;
+    while (true) {
+        Slot& slot = slots[tail & (CAPACITY - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) == tail + 1) {
+            out << slot.text << '\n';
+            slot.sequence.store(tail + CAPACITY, std::memory_order_release);
+            tail++;
+            wrote = true;
+            continue;
+        }
+
+        // Empty (or the next message is still being written): flush once, then poll
+        if (wrote) {
+            out.flush();
+            wrote = false;
+        }
+        if (stopping.load(std::memory_order_acquire) && tail == head.load(std::memory_order_acquire)) {
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef LOGGER_HPP
+#define LOGGER_HPP
+
+#include "includes.hpp"
+
+// printf style logging that never blocks the calling thread: messages are formatted into a fixed ring
+// of slots (any number of threads may log) and a background thread writes them out in order.
+// When the ring is full the message is dropped and counted instead of waiting.
+class AsyncLogger {
+public:
+    static constexpr size_t CAPACITY = 1024;      // Messages in the ring, a power of two
+    static constexpr size_t MESSAGE_SIZE = 128;   // Longer messages are cut off
+
+    explicit AsyncLogger(std::ostream& out);
+    ~AsyncLogger();  // Writes what is still queued
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    void log(const char* format, ...)
+#ifdef __GNUC__
+        __attribute__((format(printf, 2, 3)))
+#endif
+        ;
+
+    size_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;  // == position: free, == position + 1: holds a message
+        char text[MESSAGE_SIZE];
+    };
+
+    void writerLoop();
+
+    std::ostream& out;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<size_t> head{0};   // Next position to claim, shared by the loggers
+    size_t tail = 0;               // Next position to write, writer thread only
+    std::atomic<size_t> dropped{0};
+    std::atomic<bool> stopping{false};
+    std::thread writer;
+};
+
+#endif // LOGGER_HPP
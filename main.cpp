@@ -1,18 +1,149 @@
 #include "includes.hpp"
 #include "shaderStuff.hpp"
 #include "player.hpp"
+#include "options.hpp"
+#include "benchmark.hpp"
+#include "headless.hpp"
+#include "profiler.hpp"
+#include "mesh.hpp"
+#include "bvh.hpp"
+#include "scene.hpp"
+#include "programBinaryCache.hpp"
+#include "frameUniforms.hpp"
+#include "wavefront.hpp"
+#include "importance.hpp"
+#include "resolution.hpp"
+#include "denoiser.hpp"
+#include "cpuRenderer.hpp"
+#include "capture.hpp"
+#include "logger.hpp"
+#include "inputThread.hpp"
+#include "rayStats.hpp"
+#include "gbuffer.hpp"
+#include "rayMarcher.hpp"
+#include "imageIO.hpp"
+#include "renderGraph.hpp"
 
-int main() {
-    // Initialize SFML window and OpenGL context
-    sf::ContextSettings settings;
-    //settings.antialiasingLevel = 4;
-    //settings.majorVersion = 4;
-    //settings.minorVersion = 3;
+// Headless rendering without any GL: the CPU path tracer along the camera path, same frame
+// count, warmup and statistics as the GPU benchmark
+static int renderOnCpu(const Options& options) {
+    Scene scene;
+    if (!scene.load(options.scenePath)) {
+        return -1;
+    }
+    Mesh mesh;
+    std::string meshPath = options.meshPath.empty() ? scene.getMeshPath() : options.meshPath;
+    if (!meshPath.empty() && !mesh.load(meshPath)) {
+        return -1;
+    }
+    BVH bvh;
+    bvh.build(mesh);
+
+    Player player(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), 5.0f);
+    CameraPath cameraPath;
+    if (!options.cameraPath.empty() && !cameraPath.load(options.cameraPath)) {
+        return -1;
+    }
+
+    ResolutionController resolution(0.0, options.scale);
+    int threadCount = options.threads > 0 ? options.threads : static_cast<int>(std::thread::hardware_concurrency());
+    CpuRenderer renderer(resolution.scaled(1600), resolution.scaled(1200), threadCount);
+    std::cout << "CPU renderer: " << renderer.getWidth() << "x" << renderer.getHeight() << ", "
+              << renderer.getThreadCount() << " threads" << std::endl;
+
+    FrameStats frameStats;
+    int frameCount = options.warmupFrames + options.frames;
+    for (int frame = 0; frame < frameCount; frame++) {
+        if (!cameraPath.isEmpty()) {
+            CameraKeyframe pose = cameraPath.sample(cameraPath.getDuration() * frame / std::max(1, frameCount - 1));
+            player.setPose(pose.position, pose.yaw, pose.pitch);
+        }
+        scene.animate(frame / 60.0f);
+
+        auto frameStart = std::chrono::steady_clock::now();
+        renderer.setScene(scene, &mesh, &bvh);
+        glm::mat4 invViewProj = glm::inverse(player.getProjectionMatrix() * player.getZeroedViewMatrix());
+        renderer.render(invViewProj, player.getPosition(), frame, options.samples, options.bounces);
+        double frameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+        if (frame >= options.warmupFrames) {
+            frameStats.addFrame(frameMs);
+        }
+    }
+    frameStats.printSummary(std::cout);
+    if (!options.statsPath.empty() && !frameStats.write(options.statsPath)) {
+        return -1;
+    }
+    if (!options.imagePath.empty() && !writePPM(options.imagePath, renderer.getWidth(), renderer.getHeight(), renderer.getColor())) {
+        return -1;
+    }
+
+    // Same frame (the last one) with a growing number of threads, best of three each
+    if (options.cpuScaling) {
+        glm::mat4 invViewProj = glm::inverse(player.getProjectionMatrix() * player.getZeroedViewMatrix());
+        double singleMs = 0.0;
+        std::cout << "threads, ms, speedup, efficiency, stolen tiles" << std::endl;
+        std::vector<int> threadCounts;
+        for (int threads = 1; threads < threadCount; threads *= 2) {
+            threadCounts.push_back(threads);
+        }
+        threadCounts.push_back(threadCount);
+        for (int threads : threadCounts) {
+            renderer.setThreadCount(threads);
+            double bestMs = std::numeric_limits<double>::max();
+            for (int run = 0; run < 3; run++) {
+                auto start = std::chrono::steady_clock::now();
+                renderer.render(invViewProj, player.getPosition(), frameCount - 1, options.samples, options.bounces);
+                bestMs = std::min(bestMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            }
+            if (threads == 1) {
+                singleMs = bestMs;
+            }
+            std::cout << threads << ", " << bestMs << ", " << singleMs / bestMs << ", " << singleMs / bestMs / threads
+                      << ", " << renderer.getStolenTiles() << std::endl;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return -1;
+    }
+    if (options.capturePath == "-") {
+        // The video goes to stdout, every message printed from here on to stderr
+        FrameCapture::reserveStdout();
+    }
+
+    if (options.headless && options.cpu) {
+        return renderOnCpu(options);
+    }
+
+    std::unique_ptr<sf::RenderWindow> window;
+    std::unique_ptr<HeadlessContext> headlessContext;
+
+    if (options.headless) {
+        // Offscreen EGL context, no window or input
+        headlessContext = std::make_unique<HeadlessContext>(4, 3);
+        if (!headlessContext->isValid()) {
+            std::cerr << "Headless context creation failed, rendering on the CPU instead" << std::endl;
+            return renderOnCpu(options);
+        }
+        glewExperimental = GL_TRUE;  // Core profile: load entry points without relying on the extension string
+    } else {
+        // Initialize SFML window and OpenGL context
+        sf::ContextSettings settings;
+        //settings.antialiasingLevel = 4;
+        //settings.majorVersion = 4;
+        //settings.minorVersion = 3;
 
-    sf::RenderWindow window(sf::VideoMode(1600, 1200), "Rays And Such", sf::Style::Default, settings);
-    //window.setVerticalSyncEnabled(true);
+        window = std::make_unique<sf::RenderWindow>(sf::VideoMode(1600, 1200), "Rays And Such", sf::Style::Default, settings);
+        //window->setVerticalSyncEnabled(true);
+    }
 
-    if (glewInit() != GLEW_OK) {
+    GLenum glewStatus = glewInit();
+    // GLEW built against GLX reports a missing GLX display under EGL after it has loaded the GL functions
+    if (glewStatus != GLEW_OK && !(options.headless && glewStatus == GLEW_ERROR_NO_GLX_DISPLAY)) {
         std::cerr << "GLEW initialization failed!" << std::endl;
         return -1;
     }
@@ -20,95 +151,728 @@ int main() {
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LESS);    // Default depth function; only objects closer than the previous depth value are rendered
     glDepthMask(GL_TRUE);    // Enable writing to the depth buffer
-    
+
     // Fullscreen Quad Shader
     std::map<GLenum, std::string> quadShader = {
         {GL_VERTEX_SHADER, "shaders/rendering/vertex_shader.glsl"},
         {GL_FRAGMENT_SHADER, "shaders/rendering/fragment_shader.glsl"}
     };
 
-    Shader quadShaderProgram(quadShader);
+    // Linked programs from earlier runs on the same driver skip compilation entirely
+    std::unique_ptr<ProgramBinaryCache> binaryCache;
+    if (!options.shaderCachePath.empty()) {
+        binaryCache = std::make_unique<ProgramBinaryCache>(options.shaderCachePath);
+    }
+
+    auto shaderStart = std::chrono::steady_clock::now();
+    Shader quadShaderProgram(quadShader, ShaderDefines(), binaryCache.get());
     Quad fullScreenQuad;  // Quad object to render the full screen
 
-    // Fullscreen Quad Shader
+    // Path tracer, compiled per variant (see the defines at the top of the shader) and kept in the cache
     std::map<GLenum, std::string> computeShader = {
         {GL_COMPUTE_SHADER, "shaders/compute/triangle_RayTrace_shader.glsl"},
     };
 
-    Shader computeShaderProgram(computeShader);
+    const std::map<std::string, ShaderDefines> computeVariants = {
+        {"full", {}},
+        {"preview", {{"RAY_SAMPLES", "2"}, {"RAY_BOUNCES", "1"}, {"SHADOWS", "0"}, {"LIGHT_SAMPLES", "1"}}},
+        {"heatmap", {{"DEBUG_CHECKS", "1"}}}
+    };
+    if (computeVariants.find(options.variant) == computeVariants.end()) {
+        std::cerr << "Unknown shader variant: " << options.variant << std::endl;
+        return -1;
+    }
+
+    std::string variant = options.variant;
+    bool useImportance = options.importance;
+    bool showImportance = options.importanceView;
+    bool useRayStats = options.rayStats;
+    bool useRaster = options.raster;
+
+    // The importance budget, the ray counters and the G-buffer are more defines on top of the selected variant
+    auto megakernelDefines = [&]() {
+        ShaderDefines defines = computeVariants.at(variant);
+        if (useImportance) {
+            defines["IMPORTANCE_BUDGET"] = "1";
+        }
+        if (useRayStats) {
+            defines["RAY_STATS"] = "1";
+        }
+        if (useRaster) {
+            defines["RASTER_PRIMARY"] = "1";
+        }
+        return defines;
+    };
+
+    ShaderCache shaderCache(binaryCache.get());
+    std::shared_ptr<Shader> computeShaderProgram = shaderCache.get(computeShader, megakernelDefines());
+    std::shared_ptr<Shader> accumulateProgram = shaderCache.get({{GL_COMPUTE_SHADER, "shaders/compute/accumulate_shader.glsl"}});
+
+    // Alternative multi-pass path tracer and the importance pre-pass, only allocated once they're selected
+    std::unique_ptr<WavefrontRenderer> wavefront;
+    std::unique_ptr<ImportanceMap> importanceMap;
+    std::unique_ptr<Denoiser> denoiser;
+    std::unique_ptr<CpuRenderer> cpuRenderer;
+    std::unique_ptr<RayStats> rayStats;
+    std::unique_ptr<GBuffer> gbuffer;
+    std::unique_ptr<RayMarcher> rayMarcher;
+    bool useWavefront = options.wavefront;
+    bool useRayMarch = options.rayMarch;
+    bool useDenoiser = options.denoiseIterations > 0;
+    // F7 after --denoise 0 turns on the default count
+    int denoiseIterations = useDenoiser ? options.denoiseIterations : 4;
+
+    double shaderMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - shaderStart).count();
+    std::cout << "Shaders ready in " << shaderMs << " ms" << std::endl;
+    if (binaryCache) {
+        binaryCache->printStats(std::cout);
+    }
+
+    // Materials, primitives and lights live in SSBOs so scenes can change without recompiling shaders
+    Scene scene;
+    if (!scene.load(options.scenePath)) {
+        return -1;
+    }
+    scene.upload();
+
+    // Triangle mesh, BVH built on the CPU and uploaded as SSBOs (vertices, indices, nodes)
+    Mesh mesh;
+    std::string meshPath = options.meshPath.empty() ? scene.getMeshPath() : options.meshPath;
+    if (!meshPath.empty() && !mesh.load(meshPath)) {
+        return -1;
+    }
+
+    auto bvhStart = std::chrono::steady_clock::now();
+    BVH bvh;
+    bvh.build(mesh);
+    double bvhMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bvhStart).count();
+    std::cout << "BVH: " << mesh.triangleCount() << " triangles, " << bvh.getNodes().size() << " nodes, depth "
+              << bvh.getDepth() << ", built in " << bvhMs << " ms" << std::endl;
+
+    // vec3 arrays have a 16 byte stride in std430, so pad the vertices to vec4
+    std::vector<glm::vec4> paddedVertices;
+    paddedVertices.reserve(mesh.vertices.size());
+    for (const glm::vec3& vertex : mesh.vertices) {
+        paddedVertices.push_back(glm::vec4(vertex, 1.0f));
+    }
+
+    Buffer vertexBuffer(Buffer::STORAGE_BUFFER);
+    vertexBuffer.generateBuffer();
+    vertexBuffer.uploadData(paddedVertices.data(), paddedVertices.size() * sizeof(glm::vec4));
+    vertexBuffer.setBufferBinding(0);
+
+    Buffer indexBuffer(Buffer::STORAGE_BUFFER);
+    indexBuffer.generateBuffer();
+    indexBuffer.uploadData(mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+    indexBuffer.setBufferBinding(1);
+
+    Buffer bvhBuffer(Buffer::STORAGE_BUFFER);
+    bvhBuffer.generateBuffer();
+    bvhBuffer.uploadData(bvh.getNodes().data(), bvh.getNodes().size() * sizeof(BVHNode));
+    bvhBuffer.setBufferBinding(2);
+
+    // The mesh is one more instance of the scene's TLAS, with its BVH as the bottom level
+    if (!bvh.getNodes().empty()) {
+        scene.setMeshBounds(bvh.getNodes()[0].boundsMin, bvh.getNodes()[0].boundsMax);
+    }
+
+    // Camera and sampling constants, one ring slot per frame in flight (uniform binding 0)
+    FrameUniformRing frameUniformRing(0);
+
+    // Output size (the window, or 1600x1200 offscreen) and the size the path tracer renders at
+    int displayWidth = window ? static_cast<int>(window->getSize().x) : 1600;
+    int displayHeight = window ? static_cast<int>(window->getSize().y) : 1200;
+    ResolutionController resolution(options.targetMs, options.scale);
+    int traceWidth = resolution.scaled(displayWidth);
+    int traceHeight = resolution.scaled(displayHeight);
+
+    // The passes of each frame, the textures that don't outlive it come from its pool
+    RenderGraph renderGraph;
+
+    // Normals, primary hit distances and the accumulated history alternate between two textures
+    // per frame, so reprojection can read last frame's while this frame's are written
+    std::unique_ptr<Texture> normalTextures[2];
+    std::unique_ptr<Texture> depthTextures[2];
+    std::unique_ptr<Texture> historyTextures[2];
+    // Sized formats, image load/store ignores textures whose internal format doesn't match the image unit's
+    for (int i = 0; i < 2; i++) {
+        normalTextures[i] = std::make_unique<Texture>(traceWidth, traceHeight, GL_RGBA16F, GL_RGBA, GL_FLOAT);
+        depthTextures[i] = std::make_unique<Texture>(traceWidth, traceHeight, GL_R32F, GL_RED, GL_FLOAT);
+        historyTextures[i] = std::make_unique<Texture>(traceWidth, traceHeight, GL_RGBA32F, GL_RGBA, GL_FLOAT);
+    }
+
+    // Below full resolution the traced image is upscaled, guided by primary hit normals at the output size
+    std::shared_ptr<Shader> guideProgram;
+    std::shared_ptr<Shader> upscaleProgram;
+
+    // Camera of the previous frame, the history is discarded while historyValid is false
+    glm::mat4 prevViewProj(1.0f);
+    glm::vec3 prevCameraPosition(0.0f);
+    bool historyValid = false;
+
+    // After a window resize or a resolution change, the wavefront and importance buffers are
+    // recreated at the new size the next time they are used
+    auto resizeTargets = [&]() {
+        traceWidth = resolution.scaled(displayWidth);
+        traceHeight = resolution.scaled(displayHeight);
+        for (int i = 0; i < 2; i++) {
+            normalTextures[i]->resize(traceWidth, traceHeight);
+            depthTextures[i]->resize(traceWidth, traceHeight);
+            historyTextures[i]->resize(traceWidth, traceHeight);
+        }
+        wavefront.reset();
+        importanceMap.reset();
+        cpuRenderer.reset();
+        gbuffer.reset();
+        historyValid = false;
+    };
+
+    // Without a window there is no default framebuffer, so the quad is drawn into a texture instead
+    std::unique_ptr<Texture> presentTexture;
+    std::unique_ptr<Framebuffer> presentFramebuffer;
+    if (options.headless) {
+        presentTexture = std::make_unique<Texture>(displayWidth, displayHeight);
+        presentFramebuffer = std::make_unique<Framebuffer>();
+        presentFramebuffer->attachTexture(*presentTexture);
+        if (!presentFramebuffer->isComplete()) {
+            std::cerr << "Offscreen framebuffer is incomplete!" << std::endl;
+            return -1;
+        }
+        glViewport(0, 0, displayWidth, displayHeight);
+    }
 
-    Texture screenTexture(1600, 1200);
-    Texture normalTexture(1600, 1200);
+    // Readbacks of the final image, written out on another thread
+    std::unique_ptr<FrameCapture> capture;
+    if (!options.capturePath.empty()) {
+        capture = std::make_unique<FrameCapture>(options.capturePath, displayWidth, displayHeight);
+        if (!capture->isValid()) {
+            return -1;
+        }
+    }
 
     // Create the Player object
     Player player(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), 5.0f);  // Position, direction, speed
 
+    // Camera path to replay (headless) and/or record (windowed)
+    CameraPath cameraPath;
+    if (!options.cameraPath.empty() && !cameraPath.load(options.cameraPath)) {
+        return -1;
+    }
+    CameraPath recordedPath;
+
+    // Per-frame messages, written out on another thread
+    AsyncLogger logger(std::cout);
+
+    // In a window the player moves on the input thread, the loop below only reads its snapshots
+    std::unique_ptr<InputThread> inputThread;
+    if (!options.headless) {
+        player.setLogger(&logger);
+        inputThread = std::make_unique<InputThread>(player, options.recordPath.empty() ? nullptr : &recordedPath);
+    }
+
+    FrameStats frameStats;
+    int headlessFrame = 0;
+
+    // CPU scope and GPU pass timings
+    Profiler profiler;
+    if (!options.tracePath.empty()) {
+        profiler.enableTrace();
+    }
+
     // Time-related variables for smooth movement
     sf::Clock clock;
 
     unsigned int frameNo = 0;
+    float sceneTime = 0.0f;
 
     // Main loop
-    while (window.isOpen()) {
-        sf::Event event;
+    while (options.headless || window->isOpen()) {
+        // Get the elapsed time
+        sf::Time deltaTime = clock.restart();
+
+        profiler.beginFrame(frameNo);
+
+        if (options.headless) {
+            if (headlessFrame >= options.warmupFrames + options.frames) {
+                break;
+            }
+
+            // Fixed time steps along the path so every run renders exactly the same frames
+            if (!cameraPath.isEmpty()) {
+                float t = cameraPath.getDuration() * headlessFrame / std::max(1, options.warmupFrames + options.frames - 1);
+                CameraKeyframe pose = cameraPath.sample(t);
+                player.setPose(pose.position, pose.yaw, pose.pitch);
+            }
+        } else {
+            CpuScope inputScope(profiler, "input");
+            sf::Event event;
+            bool quit = false;
+
+            while (window->pollEvent(event)) {
+                if (event.type == sf::Event::Closed) {
+                    // No more camera steps once the window is gone
+                    inputThread->stop();
+                    window->close();
+                }
+                // The trace resolution keeps its fraction of the new window size
+                if (event.type == sf::Event::Resized && event.size.width > 0 && event.size.height > 0) {
+                    displayWidth = static_cast<int>(event.size.width);
+                    displayHeight = static_cast<int>(event.size.height);
+                    glViewport(0, 0, displayWidth, displayHeight);
+                    inputThread->setAspectRatio(static_cast<float>(displayWidth) / displayHeight);
+                    resizeTargets();
+                }
+                // Hot reload the scene file (the mesh stays as loaded at startup)
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::R) {
+                    if (scene.load(options.scenePath)) {
+                        sceneTime = 0.0f;
+                        historyValid = false;
+                        if (rayMarcher) {
+                            rayMarcher->setScene(scene);
+                        }
+                    }
+                }
+                // Switch shader variants, each one is compiled the first time it is used
+                if (event.type == sf::Event::KeyPressed) {
+                    std::string newVariant;
+                    if (event.key.code == sf::Keyboard::F1) newVariant = "full";
+                    if (event.key.code == sf::Keyboard::F2) newVariant = "preview";
+                    if (event.key.code == sf::Keyboard::F3) newVariant = "heatmap";
+                    // Importance budget on/off and its heat map
+                    if (event.key.code == sf::Keyboard::F5) {
+                        useImportance = !useImportance;
+                        showImportance = showImportance && useImportance;
+                        newVariant = variant;
+                    }
+                    if (event.key.code == sf::Keyboard::F6) {
+                        showImportance = !showImportance;
+                        newVariant = useImportance ? "" : variant;
+                        useImportance = true;
+                    }
+                    // Ray counters on/off
+                    if (event.key.code == sf::Keyboard::F8) {
+                        useRayStats = !useRayStats;
+                        newVariant = variant;
+                    }
+                    // Rasterized primary hits on/off
+                    if (event.key.code == sf::Keyboard::F9) {
+                        useRaster = !useRaster;
+                        newVariant = variant;
+                    }
+                    if (!newVariant.empty()) {
+                        variant = newVariant;
+                        computeShaderProgram = shaderCache.get(computeShader, megakernelDefines());
+                        if (wavefront) {
+                            wavefront->setVariant(shaderCache, computeVariants.at(variant));
+                        }
+                        if (importanceMap) {
+                            importanceMap->setVariant(shaderCache, computeVariants.at(variant));
+                        }
+                        if (gbuffer) {
+                            gbuffer->setVariant(shaderCache, computeVariants.at(variant));
+                        }
+                    }
+                    // Switch between the megakernel and the wavefront path tracer
+                    if (event.key.code == sf::Keyboard::F4) {
+                        useWavefront = !useWavefront;
+                    }
+                    // Switch between path tracing and sphere tracing the baked distance field
+                    if (event.key.code == sf::Keyboard::F10) {
+                        useRayMarch = !useRayMarch;
+                        historyValid = false;
+                    }
+                    // Denoiser on/off, doesn't touch the history
+                    if (event.key.code == sf::Keyboard::F7) {
+                        useDenoiser = !useDenoiser;
+                    }
+                    if (event.key.code >= sf::Keyboard::F1 && event.key.code <= sf::Keyboard::F6) {
+                        historyValid = false;
+                    }
+                }
+            }
+            // Keys and mouse for the input thread's next steps, it mustn't touch SFML itself
+            if (window->isOpen()) {
+                inputThread->sample(*window);
+            }
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Escape)) {
+                quit = true;
+            }
 
-        while (window.pollEvent(event)) {
-            if (event.type == sf::Event::Closed) {
-                window.close();
+            if (quit) {
+                break;
             }
         }
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Escape)) {
-            break;
+
+        auto frameStart = std::chrono::steady_clock::now();
+
+        // Trade resolution for frame time when a target is set
+        if (resolution.update(profiler.getGpuFrameTime())) {
+            resizeTargets();
         }
 
-        // Get the elapsed time
-        sf::Time deltaTime = clock.restart();
+        // Headless runs advance the animation by a fixed step to stay reproducible
+        sceneTime += options.headless ? 1.0f / 60.0f : deltaTime.asSeconds();
+        scene.animate(sceneTime);
 
-        // Update the player's position, view, and projection matrices (optional)
-        player.move(deltaTime, sf::Keyboard::W, sf::Keyboard::S, sf::Keyboard::A, sf::Keyboard::D, sf::Keyboard::Space, sf::Keyboard::LControl, sf::Keyboard::Q);
-        player.lookAround(window, deltaTime.asSeconds());
- 
-        glm::mat4 view = player.getViewMatrix();
-        glm::mat4 zeroedView = player.getZeroedViewMatrix();
-        
-        glm::mat4 projection = player.getProjectionMatrix();
+        // The newest camera from the input thread, headless runs place the player themselves
+        CameraSnapshot camera = inputThread ? inputThread->latest() : player.snapshot();
+        glm::mat4 view = camera.view;
+        glm::mat4 zeroedView = camera.zeroedView;
+
+        glm::mat4 projection = camera.projection;
+
+        if (presentFramebuffer) {
+            presentFramebuffer->bind();
+        }
 
         // Clear the screen
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        
-        // Use the compute shader
-        computeShaderProgram.use();
-        computeShaderProgram.setMat4("viewMatrix", zeroedView);
-        computeShaderProgram.setMat4("projMatrix", projection);
-        computeShaderProgram.setVec3("position", player.getPosition());
-        computeShaderProgram.setUInt("frameNo", frameNo);
-        computeShaderProgram.setImage("screenTexture", screenTexture.getID(), 0, GL_RGBA8);
-        computeShaderProgram.setImage("normalTexture", normalTexture.getID(), 1, GL_RGBA8);
-
-        // Dispatch compute shader (assuming it's a 512x512 grid)
-        glDispatchCompute(1600 / 16, 1200 / 16, 1);  // For example, dispatching 16x16 workgroups
-        
-        // Wait for the compute shader to finish
-        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-
-        // Set the view and projection matrices to the quad shader program
-        quadShaderProgram.use();
-        quadShaderProgram.setMat4("view", view);
-        quadShaderProgram.setMat4("projection", projection);
-        quadShaderProgram.setTexture("screenTexture", screenTexture.getID(), 0);
-        quadShaderProgram.setTexture("normalTexture", normalTexture.getID(), 1);
-
-        // Bind and draw the full-screen quad
-        fullScreenQuad.bind();
-        fullScreenQuad.draw();
-        
-        window.setTitle("FPS: " + std::to_string((1/deltaTime.asSeconds())));
-
-        // Display the frame
-        window.display();
+
+        // Ping-pong index of this frame's normal, depth and history textures
+        int current = frameNo % 2;
+        int previous = 1 - current;
+
+        {
+            CpuScope uniformScope(profiler, "uniforms");
+
+            // Only the objects that changed since the last frame are sent
+            scene.upload();
+
+            glm::mat4 viewProj = projection * zeroedView;
+            glm::vec3 cameraPosition = camera.position;
+
+            // Still camera and scene: accumulate without limit, otherwise keep a short moving average
+            float historyLimit = 1.0f;
+            if (options.temporal && historyValid) {
+                bool moving = viewProj != prevViewProj || cameraPosition != prevCameraPosition || scene.isAnimated();
+                historyLimit = moving ? static_cast<float>(options.historyFrames) : 65536.0f;
+            }
+
+            FrameUniforms frameUniforms{};
+            frameUniforms.invViewProj = glm::inverse(viewProj);
+            frameUniforms.prevViewProj = historyValid ? prevViewProj : viewProj;
+            frameUniforms.cameraPosition = cameraPosition;
+            frameUniforms.frameNo = frameNo;
+            frameUniforms.prevCameraPosition = historyValid ? prevCameraPosition : cameraPosition;
+            frameUniforms.historyLimit = historyLimit;
+            frameUniforms.samplesPerPixel = options.samples;
+            frameUniforms.maxBounces = options.bounces;
+            frameUniforms.resolution = glm::uvec2(traceWidth, traceHeight);
+            frameUniformRing.upload(frameUniforms);
+
+            prevViewProj = viewProj;
+            prevCameraPosition = cameraPosition;
+            historyValid = true;
+
+            if (useWavefront && !wavefront) {
+                wavefront = std::make_unique<WavefrontRenderer>(traceWidth, traceHeight);
+                wavefront->setVariant(shaderCache, computeVariants.at(variant));
+            }
+            if (useImportance && !importanceMap) {
+                importanceMap = std::make_unique<ImportanceMap>(traceWidth, traceHeight);
+                importanceMap->setVariant(shaderCache, computeVariants.at(variant));
+            }
+            if (options.cpu && !cpuRenderer) {
+                cpuRenderer = std::make_unique<CpuRenderer>(traceWidth, traceHeight, options.threads > 0 ? options.threads : static_cast<int>(std::thread::hardware_concurrency()));
+            }
+            if (useRaster && !gbuffer) {
+                gbuffer = std::make_unique<GBuffer>(traceWidth, traceHeight);
+                gbuffer->setVariant(shaderCache, computeVariants.at(variant));
+            }
+            if (useRayMarch && !rayMarcher) {
+                rayMarcher = std::make_unique<RayMarcher>(shaderCache);
+                rayMarcher->setScene(scene);
+            }
+            if (useDenoiser && !denoiser) {
+                denoiser = std::make_unique<Denoiser>(shaderCache);
+            }
+        }
+
+        {
+            CpuScope submitScope(profiler, "submit");
+            renderGraph.reset();
+
+            // This frame's normals and distances are kept for the next one's reprojection
+            RenderGraph::Resource normal = renderGraph.importTexture("normal", *normalTextures[current]);
+            RenderGraph::Resource depth = renderGraph.importTexture("depth", *depthTextures[current]);
+            renderGraph.keep(normal);
+            renderGraph.keep(depth);
+            RenderGraph::Resource screen = renderGraph.createTexture("screen", traceWidth, traceHeight, GL_RGBA16F, GL_RGBA, GL_FLOAT);
+
+            // Only the megakernel reads the importance budget and the G-buffer, the graph culls their
+            // passes otherwise. The wavefront tracer keeps its uniform sample count.
+            bool megakernel = !useWavefront && !useRayMarch && !cpuRenderer;
+            bool importanceView = useImportance && showImportance && megakernel;
+
+            RenderGraph::Resource budget = -1;
+            if (useImportance) {
+                budget = renderGraph.importTexture("budget", importanceMap->getBudgetTexture());
+                RenderGraph::Pass& pass = renderGraph.addPass("importance").write(budget);
+                if (importanceView) {
+                    // Debug view: the budget heat map is drawn into the screen texture instead of tracing
+                    pass.write(screen);
+                }
+                pass.execute([&]() {
+                    // Same total rays as --spp everywhere, at most 4x that in one pixel
+                    importanceMap->update(static_cast<float>(options.samples), options.samples * 4,
+                                          importanceView ? &renderGraph.getTexture(screen) : nullptr);
+                });
+            }
+
+            // Primary visibility for the megakernel, drawn instead of traced
+            RenderGraph::Resource gbufferNormal = -1, gbufferDistance = -1, gbufferMaterial = -1;
+            if (useRaster) {
+                gbufferNormal = renderGraph.importTexture("gbufferNormal", gbuffer->getNormalTexture());
+                gbufferDistance = renderGraph.importTexture("gbufferDistance", gbuffer->getDistanceTexture());
+                gbufferMaterial = renderGraph.importTexture("gbufferMaterial", gbuffer->getMaterialTexture());
+                renderGraph.addPass("gbuffer")
+                    .write(gbufferNormal, RenderGraph::ATTACHMENT)
+                    .write(gbufferDistance, RenderGraph::ATTACHMENT)
+                    .write(gbufferMaterial, RenderGraph::ATTACHMENT)
+                    .execute([&]() { gbuffer->render(projection * zeroedView, scene, mesh.triangleCount()); });
+            }
+
+            if (importanceView) {
+                historyValid = false;
+            } else {
+                RenderGraph::Pass& pass = renderGraph.addPass("pathTrace");
+                if (cpuRenderer) {
+                    // Rendered on the CPU, then the same temporal, denoise and present passes as the GPU image
+                    pass.write(screen, RenderGraph::UPLOAD).write(normal, RenderGraph::UPLOAD).write(depth, RenderGraph::UPLOAD);
+                    pass.execute([&]() {
+                        cpuRenderer->setScene(scene, &mesh, &bvh);
+                        cpuRenderer->render(glm::inverse(projection * zeroedView), camera.position, frameNo, options.samples, options.bounces);
+                        renderGraph.getTransientTexture(screen).upload(cpuRenderer->getColor().data());
+                        normalTextures[current]->upload(cpuRenderer->getNormal().data());
+                        depthTextures[current]->upload(cpuRenderer->getDepth().data());
+                    });
+                } else if (useRayMarch) {
+                    pass.write(screen).write(normal).write(depth);
+                    pass.execute([&]() {
+                        rayMarcher->render(renderGraph.getTexture(screen), *normalTextures[current], *depthTextures[current]);
+                    });
+                } else if (useWavefront) {
+                    pass.write(screen).write(normal).write(depth);
+                    pass.execute([&]() {
+                        wavefront->render(renderGraph.getTexture(screen), *normalTextures[current], *depthTextures[current],
+                                          options.samples, options.bounces);
+                    });
+                } else {
+                    pass.write(screen).write(normal).write(depth);
+                    if (useImportance) {
+                        pass.read(budget);
+                    }
+                    if (useRaster) {
+                        pass.read(gbufferNormal).read(gbufferDistance).read(gbufferMaterial);
+                    }
+                    pass.execute([&]() {
+                        // Use the compute shader
+                        computeShaderProgram->use();
+                        computeShaderProgram->setImage("screenTexture", renderGraph.getTexture(screen).getID(), 0, GL_RGBA16F);
+                        computeShaderProgram->setImage("normalTexture", normalTextures[current]->getID(), 1, GL_RGBA16F);
+                        computeShaderProgram->setImage("depthTexture", depthTextures[current]->getID(), 2, GL_R32F);
+                        if (useImportance) {
+                            computeShaderProgram->setImage("budgetTexture", importanceMap->getBudgetTexture().getID(), 3, GL_R8UI);
+                        }
+                        if (useRaster) {
+                            computeShaderProgram->setImage("gbufferNormal", gbuffer->getNormalTexture().getID(), 4, GL_RG16_SNORM);
+                            computeShaderProgram->setImage("gbufferDistance", gbuffer->getDistanceTexture().getID(), 5, GL_R32F);
+                            computeShaderProgram->setImage("gbufferMaterial", gbuffer->getMaterialTexture().getID(), 6, GL_R32UI);
+                        }
+
+                        if (useRayStats) {
+                            if (!rayStats) {
+                                rayStats = std::make_unique<RayStats>();
+                                rayStats->setFirstCountedFrame(options.headless ? options.warmupFrames : 0);
+                            }
+                            rayStats->begin(frameNo);
+                        }
+
+                        // Enough workgroups to cover the whole screen with the variant's local size
+                        glm::ivec3 groupSize = computeShaderProgram->getWorkGroupSize();
+                        glDispatchCompute((traceWidth + groupSize.x - 1) / groupSize.x, (traceHeight + groupSize.y - 1) / groupSize.y, 1);
+
+                        if (useRayStats) {
+                            rayStats->end();
+                        }
+                    });
+                }
+            }
+
+            if (options.temporal && !importanceView) {
+                RenderGraph::Resource prevNormal = renderGraph.importTexture("prevNormal", *normalTextures[previous]);
+                RenderGraph::Resource prevDepth = renderGraph.importTexture("prevDepth", *depthTextures[previous]);
+                RenderGraph::Resource historyIn = renderGraph.importTexture("historyIn", *historyTextures[previous]);
+                RenderGraph::Resource historyOut = renderGraph.importTexture("historyOut", *historyTextures[current]);
+                renderGraph.keep(historyOut);
+
+                // Blend this frame's samples into the reprojected history, the result replaces the screen texture
+                renderGraph.addPass("accumulate")
+                    .read(screen).write(screen)
+                    .read(normal).read(depth)
+                    .read(historyIn).write(historyOut)
+                    .read(prevNormal).read(prevDepth)
+                    .execute([&]() {
+                        accumulateProgram->use();
+                        accumulateProgram->setImage("screenTexture", renderGraph.getTexture(screen).getID(), 0, GL_RGBA16F);
+                        accumulateProgram->setImage("normalTexture", normalTextures[current]->getID(), 1, GL_RGBA16F);
+                        accumulateProgram->setImage("depthTexture", depthTextures[current]->getID(), 2, GL_R32F);
+                        accumulateProgram->setImage("historyIn", historyTextures[previous]->getID(), 3, GL_RGBA32F);
+                        accumulateProgram->setImage("historyOut", historyTextures[current]->getID(), 4, GL_RGBA32F);
+                        accumulateProgram->setImage("prevNormalTexture", normalTextures[previous]->getID(), 5, GL_RGBA16F);
+                        accumulateProgram->setImage("prevDepthTexture", depthTextures[previous]->getID(), 6, GL_R32F);
+                        glDispatchCompute((traceWidth + 15) / 16, (traceHeight + 15) / 16, 1);
+                    });
+            }
+
+            // Denoise at the trace resolution, before upscaling. The screen texture is free once the
+            // variance is estimated, the filter's scratch texture takes its place.
+            RenderGraph::Resource finalImage = screen;
+            if (useDenoiser && !importanceView) {
+                RenderGraph::Resource filtered = renderGraph.createTexture("denoised", traceWidth, traceHeight, GL_RGBA16F, GL_RGBA, GL_FLOAT);
+                RenderGraph::Resource scratch = renderGraph.createTexture("denoiseScratch", traceWidth, traceHeight, GL_RGBA16F, GL_RGBA, GL_FLOAT);
+                renderGraph.addPass("variance")
+                    .read(screen).read(normal).read(depth).write(filtered)
+                    .execute([&, filtered]() {
+                        denoiser->estimateVariance(renderGraph.getTexture(screen), *normalTextures[current], *depthTextures[current],
+                                                   renderGraph.getTexture(filtered));
+                    });
+
+                int iterations = std::min(denoiseIterations, Denoiser::MAX_ITERATIONS);
+                if (iterations > 0) {
+                    renderGraph.addPass("denoise")
+                        .read(filtered).write(filtered).write(scratch).read(normal).read(depth)
+                        .execute([&, filtered, scratch, iterations]() {
+                            denoiser->filter(renderGraph.getTexture(filtered), renderGraph.getTexture(scratch),
+                                             *normalTextures[current], *depthTextures[current], iterations);
+                        });
+                }
+                finalImage = iterations % 2 == 0 ? filtered : scratch;
+            }
+
+            bool upscale = traceWidth != displayWidth || traceHeight != displayHeight;
+            if (upscale) {
+                if (!guideProgram) {
+                    guideProgram = shaderCache.get({{GL_COMPUTE_SHADER, "shaders/compute/upscale/guide.glsl"}});
+                    upscaleProgram = shaderCache.get({{GL_COMPUTE_SHADER, "shaders/compute/upscale/upscale.glsl"}});
+                }
+                RenderGraph::Resource guideNormal = renderGraph.createTexture("guideNormal", displayWidth, displayHeight, GL_RGBA16F, GL_RGBA, GL_FLOAT);
+                RenderGraph::Resource upscaled = renderGraph.createTexture("upscaled", displayWidth, displayHeight, GL_RGBA16F, GL_RGBA, GL_FLOAT);
+
+                // Primary rays only, much cheaper than the samples they save at the lower resolution
+                renderGraph.addPass("guide")
+                    .write(guideNormal)
+                    .execute([&, guideNormal]() {
+                        guideProgram->use();
+                        guideProgram->setImage("guideNormalTexture", renderGraph.getTexture(guideNormal).getID(), 0, GL_RGBA16F);
+                        glDispatchCompute((displayWidth + 15) / 16, (displayHeight + 15) / 16, 1);
+                    });
+
+                renderGraph.addPass("upscale")
+                    .read(finalImage).read(normal).read(guideNormal).write(upscaled)
+                    .execute([&, finalImage, guideNormal, upscaled]() {
+                        upscaleProgram->use();
+                        upscaleProgram->setImage("traceTexture", renderGraph.getTexture(finalImage).getID(), 0, GL_RGBA16F);
+                        upscaleProgram->setImage("traceNormalTexture", normalTextures[current]->getID(), 1, GL_RGBA16F);
+                        upscaleProgram->setImage("guideNormalTexture", renderGraph.getTexture(guideNormal).getID(), 2, GL_RGBA16F);
+                        upscaleProgram->setImage("outputTexture", renderGraph.getTexture(upscaled).getID(), 3, GL_RGBA16F);
+                        glDispatchCompute((displayWidth + 15) / 16, (displayHeight + 15) / 16, 1);
+                    });
+                finalImage = upscaled;
+            }
+
+            renderGraph.addPass("blit")
+                .read(finalImage, RenderGraph::SAMPLED)
+                .sideEffect()
+                .execute([&, finalImage]() {
+                    // Set the view and projection matrices to the quad shader program
+                    quadShaderProgram.use();
+                    quadShaderProgram.setMat4("view", view);
+                    quadShaderProgram.setMat4("projection", projection);
+                    quadShaderProgram.setTexture("screenTexture", renderGraph.getTexture(finalImage).getID(), 0);
+
+                    // Bind and draw the full-screen quad
+                    fullScreenQuad.bind();
+                    fullScreenQuad.draw();
+                });
+
+            if (capture && !(options.headless && headlessFrame < options.warmupFrames)) {
+                // The readback copies from the texture into a buffer
+                renderGraph.addPass("capture")
+                    .read(finalImage, RenderGraph::TRANSFER)
+                    .sideEffect()
+                    .execute([&, finalImage]() { capture->capture(renderGraph.getTexture(finalImage)); });
+            }
+
+            renderGraph.compile();
+            renderGraph.execute(profiler);
+
+            // Last use of this frame's constants
+            frameUniformRing.endFrame();
+        }
+
+        if (options.headless) {
+            {
+                CpuScope presentScope(profiler, "present");
+                // Wait for the GPU so the measured time is the real cost of the frame
+                glFinish();
+            }
+            double frameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+            if (headlessFrame >= options.warmupFrames) {
+                frameStats.addFrame(frameMs);
+            }
+            headlessFrame++;
+        } else {
+            window->setTitle("FPS: " + std::to_string((1/deltaTime.asSeconds())) + " GPU: " + std::to_string(profiler.getGpuFrameTime()) + " ms"
+                            + " Scale: " + std::to_string(resolution.getScale())
+                            + (useRayStats && rayStats ? " Mrays/s: " + std::to_string(rayStats->getLatest().megaRaysPerSecond()) : ""));
+
+            CpuScope presentScope(profiler, "present");
+            // Display the frame
+            window->display();
+        }
         frameNo++;
     }
 
+    // Done with the player (and the recorded path)
+    if (inputThread) {
+        inputThread->stop();
+    }
+
+    if (capture) {
+        capture->finish(std::cout);
+    }
+
+    if (!options.tracePath.empty()) {
+        profiler.flush();
+        if (!profiler.writeTrace(options.tracePath)) {
+            return -1;
+        }
+    }
+
+    if (options.headless) {
+        frameStats.printSummary(std::cout);
+        // Last frame's graph
+        const RenderGraph::Stats& graphStats = renderGraph.getStats();
+        std::cout << "Render graph: " << graphStats.passes << " passes (" << graphStats.culled << " culled), "
+                  << graphStats.barriers << " barriers, transient textures " << graphStats.pooledBytes / 1048576.0 << " MB ("
+                  << graphStats.transientBytes / 1048576.0 << " MB unaliased)" << std::endl;
+        if (resolution.isEnabled()) {
+            std::cout << "Final trace resolution: " << traceWidth << "x" << traceHeight << std::endl;
+        }
+        if (!options.statsPath.empty() && !frameStats.write(options.statsPath)) {
+            return -1;
+        }
+    }
+
+    if (rayStats) {
+        rayStats->flush();
+        rayStats->printSummary(std::cout);
+    }
+
+    if (!options.recordPath.empty() && !recordedPath.save(options.recordPath)) {
+        return -1;
+    }
+
     return 0;
 }
-
@@ -0,0 +1,216 @@
+#include "includes.hpp"
+#include "mesh.hpp"
+
+bool Mesh::load(const std::string& filepath) {
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open mesh file: " << filepath << std::endl;
+        return false;
+    }
+
+    vertices.clear();
+    indices.clear();
+
+    std::string extension = filepath.substr(filepath.find_last_of('.') + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+    bool loaded = false;
+    if (extension == "obj") {
+        loaded = loadObj(file);
+    } else if (extension == "ply") {
+        loaded = loadPly(file);
+    } else {
+        std::cerr << "Error: Unsupported mesh format: " << filepath << std::endl;
+        return false;
+    }
+
+    if (!loaded || indices.empty()) {
+        std::cerr << "Error: Could not read mesh: " << filepath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Only positions and faces are read, faces with more than three corners are fan triangulated
+bool Mesh::loadObj(std::istream& file) {
+    std::string line;
+    std::vector<uint32_t> face;
+
+    while (std::getline(file, line)) {
+        std::istringstream stream(line);
+        std::string keyword;
+        stream >> keyword;
+
+        if (keyword == "v") {
+            glm::vec3 vertex;
+            stream >> vertex.x >> vertex.y >> vertex.z;
+            vertices.push_back(vertex);
+        } else if (keyword == "f") {
+            face.clear();
+            std::string corner;
+            while (stream >> corner) {
+                // "v", "v/vt", "v//vn" or "v/vt/vn", negative indices count from the end
+                long index = std::strtol(corner.c_str(), nullptr, 10);
+                if (index < 0) {
+                    index += static_cast<long>(vertices.size());
+                } else {
+                    index -= 1;
+                }
+                if (index < 0 || index >= static_cast<long>(vertices.size())) {
+                    return false;
+                }
+                face.push_back(static_cast<uint32_t>(index));
+            }
+
+            for (size_t i = 2; i < face.size(); i++) {
+                indices.push_back(face[0]);
+                indices.push_back(face[i - 1]);
+                indices.push_back(face[i]);
+            }
+        }
+    }
+    return true;
+}
+
+namespace {
+
+struct PlyProperty {
+    std::string name;
+    std::string type;
+    std::string countType;   // Non-empty for list properties
+};
+
+struct PlyElement {
+    std::string name;
+    size_t count;
+    std::vector<PlyProperty> properties;
+};
+
+size_t plyTypeSize(const std::string& type) {
+    if (type == "char" || type == "uchar" || type == "int8" || type == "uint8") return 1;
+    if (type == "short" || type == "ushort" || type == "int16" || type == "uint16") return 2;
+    if (type == "int" || type == "uint" || type == "float" || type == "int32" || type == "uint32" || type == "float32") return 4;
+    if (type == "double" || type == "float64") return 8;
+    return 0;
+}
+
+// Reads one value of the given type, either as text or as little endian binary
+double readPlyValue(std::istream& file, const std::string& type, bool binary) {
+    if (!binary) {
+        double value = 0.0;
+        file >> value;
+        return value;
+    }
+
+    unsigned char bytes[8] = {};
+    file.read(reinterpret_cast<char*>(bytes), plyTypeSize(type));
+
+    if (type == "char" || type == "int8") { int8_t v; std::memcpy(&v, bytes, 1); return v; }
+    if (type == "uchar" || type == "uint8") { uint8_t v; std::memcpy(&v, bytes, 1); return v; }
+    if (type == "short" || type == "int16") { int16_t v; std::memcpy(&v, bytes, 2); return v; }
+    if (type == "ushort" || type == "uint16") { uint16_t v; std::memcpy(&v, bytes, 2); return v; }
+    if (type == "int" || type == "int32") { int32_t v; std::memcpy(&v, bytes, 4); return v; }
+    if (type == "uint" || type == "uint32") { uint32_t v; std::memcpy(&v, bytes, 4); return v; }
+    if (type == "float" || type == "float32") { float v; std::memcpy(&v, bytes, 4); return v; }
+    if (type == "double" || type == "float64") { double v; std::memcpy(&v, bytes, 8); return v; }
+    return 0.0;
+}
+
+} // namespace
+
+// Supports ascii and binary_little_endian files, reads x/y/z and vertex_indices, skips everything else
+bool Mesh::loadPly(std::istream& file) {
+    std::string line;
+    std::getline(file, line);
+    if (line.compare(0, 3, "ply") != 0) {
+        return false;
+    }
+
+    bool binary = false;
+    std::vector<PlyElement> elements;
+
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        std::istringstream stream(line);
+        std::string keyword;
+        stream >> keyword;
+
+        if (keyword == "format") {
+            std::string format;
+            stream >> format;
+            if (format == "binary_little_endian") {
+                binary = true;
+            } else if (format != "ascii") {
+                std::cerr << "Error: Unsupported PLY format: " << format << std::endl;
+                return false;
+            }
+        } else if (keyword == "element") {
+            PlyElement element;
+            stream >> element.name >> element.count;
+            elements.push_back(element);
+        } else if (keyword == "property" && !elements.empty()) {
+            PlyProperty property;
+            stream >> property.type;
+            if (property.type == "list") {
+                stream >> property.countType >> property.type;
+            }
+            stream >> property.name;
+            elements.back().properties.push_back(property);
+        } else if (keyword == "end_header") {
+            break;
+        }
+    }
+
+    for (const PlyElement& element : elements) {
+        bool isVertex = element.name == "vertex";
+        bool isFace = element.name == "face";
+        if (isVertex) {
+            vertices.reserve(element.count);
+        }
+
+        std::vector<uint32_t> face;
+        for (size_t i = 0; i < element.count; i++) {
+            glm::vec3 vertex(0.0f);
+            for (const PlyProperty& property : element.properties) {
+                if (!property.countType.empty()) {
+                    size_t count = static_cast<size_t>(readPlyValue(file, property.countType, binary));
+                    face.clear();
+                    for (size_t j = 0; j < count; j++) {
+                        face.push_back(static_cast<uint32_t>(readPlyValue(file, property.type, binary)));
+                    }
+                    if (isFace && (property.name == "vertex_indices" || property.name == "vertex_index")) {
+                        for (size_t j = 2; j < face.size(); j++) {
+                            indices.push_back(face[0]);
+                            indices.push_back(face[j - 1]);
+                            indices.push_back(face[j]);
+                        }
+                    }
+                    continue;
+                }
+
+                double value = readPlyValue(file, property.type, binary);
+                if (isVertex) {
+                    if (property.name == "x") vertex.x = static_cast<float>(value);
+                    else if (property.name == "y") vertex.y = static_cast<float>(value);
+                    else if (property.name == "z") vertex.z = static_cast<float>(value);
+                }
+            }
+            if (isVertex) {
+                vertices.push_back(vertex);
+            }
+            if (!file) {
+                return false;
+            }
+        }
+    }
+
+    // Reject faces that point past the vertex list
+    for (uint32_t index : indices) {
+        if (index >= vertices.size()) {
+            return false;
+        }
+    }
+    return true;
+}
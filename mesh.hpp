@@ -0,0 +1,21 @@
+#ifndef MESH_HPP
+#define MESH_HPP
+
+#include "includes.hpp"
+
+// Indexed triangle mesh (positions only, three indices per triangle)
+struct Mesh {
+    std::vector<glm::vec3> vertices;
+    std::vector<uint32_t> indices;
+
+    size_t triangleCount() const { return indices.size() / 3; }
+
+    // Load a Wavefront .obj or a .ply (ascii or binary) file, chosen by extension
+    bool load(const std::string& filepath);
+
+private:
+    bool loadObj(std::istream& file);
+    bool loadPly(std::istream& file);
+};
+
+#endif // MESH_HPP
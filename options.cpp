@@ -0,0 +1,111 @@
+#include "includes.hpp"
+#include "options.hpp"
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --scene <file>        scene description (default scenes/default.json), R reloads it\n"
+              << "  --mesh <file>         triangle mesh to render, .obj or .ply (overrides the scene's mesh)\n"
+              << "  --headless            render offscreen (EGL) and exit after --frames frames\n"
+              << "  --camera-path <file>  replay camera keyframes (time x y z yaw pitch)\n"
+              << "  --record <file>       save the flown camera path on exit (windowed mode)\n"
+              << "  --spp <n>             samples per pixel per frame (default 2, at most the variant's RAY_SAMPLES)\n"
+              << "  --bounces <n>         bounces per sample (default 5, at most the variant's RAY_BOUNCES)\n"
+              << "  --no-temporal         show each frame's samples alone instead of accumulating over frames\n"
+              << "  --history <n>         frames blended while the camera or scene moves (default 16)\n"
+              << "  --denoise <n>         a-trous denoiser iterations, 0 to 5 (default 4, 0 turns it off), F7 toggles at runtime\n"
+              << "  --target-ms <ms>      lower or raise the trace resolution to keep the GPU frame time under <ms>\n"
+              << "  --scale <s>           trace resolution as a fraction of the output size (default 1, 0.25 to 1)\n"
+              << "  --frames <n>          measured frames in headless mode (default 300)\n"
+              << "  --warmup <n>          unmeasured frames before measuring (default 10)\n"
+              << "  --stats <file>        write frame times as .csv or .json\n"
+              << "  --trace <file>        write a Chrome trace (chrome://tracing) of CPU scopes and GPU passes\n"
+              << "  --shader-cache <dir>  program binary cache directory (default shader_cache)\n"
+              << "  --no-shader-cache     always compile shaders from source\n"
+              << "  --importance          spread the --spp budget by an importance pre-pass, F5 toggles at runtime\n"
+              << "  --importance-view     show the per-pixel sample budget as a heat map, F6 toggles at runtime\n"
+              << "  --ray-stats           count rays, tests and path ends on the GPU and report Mrays/s, F8 toggles at runtime\n"
+              << "  --raster              rasterize primary visibility into a G-buffer instead of tracing primary rays, F9 toggles at runtime\n"
+              << "  --wavefront           use the wavefront (multi-pass) path tracer, F4 toggles at runtime\n"
+              << "  --ray-march           sphere trace the scene baked into a sparse SDF brick map, F10 toggles at runtime\n"
+              << "  --cpu                 path trace on the CPU, with --headless no GPU is needed at all\n"
+              << "  --threads <n>         CPU renderer threads (default: every core)\n"
+              << "  --cpu-scaling         headless CPU: report the frame time with 1, 2, 4, ... threads\n"
+              << "  --image <file>        headless CPU: save the last frame as .ppm\n"
+              << "  --capture <out>       record every frame: frames/%05d.png or .exr, video.y4m, or - for Y4M on stdout\n"
+              << "  --variant <name>      path tracer variant: full, preview or heatmap (F1/F2/F3 switch at runtime)\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg == "--scene" && hasValue) {
+            options.scenePath = argv[++i];
+        } else if (arg == "--mesh" && hasValue) {
+            options.meshPath = argv[++i];
+        } else if (arg == "--camera-path" && hasValue) {
+            options.cameraPath = argv[++i];
+        } else if (arg == "--record" && hasValue) {
+            options.recordPath = argv[++i];
+        } else if (arg == "--spp" && hasValue) {
+            options.samples = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--bounces" && hasValue) {
+            options.bounces = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--no-temporal") {
+            options.temporal = false;
+        } else if (arg == "--history" && hasValue) {
+            options.historyFrames = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--denoise" && hasValue) {
+            options.denoiseIterations = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--target-ms" && hasValue) {
+            options.targetMs = std::max(0.0, std::atof(argv[++i]));
+        } else if (arg == "--scale" && hasValue) {
+            options.scale = std::min(1.0f, std::max(0.25f, static_cast<float>(std::atof(argv[++i]))));
+        } else if (arg == "--frames" && hasValue) {
+            options.frames = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--warmup" && hasValue) {
+            options.warmupFrames = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--stats" && hasValue) {
+            options.statsPath = argv[++i];
+        } else if (arg == "--trace" && hasValue) {
+            options.tracePath = argv[++i];
+        } else if (arg == "--shader-cache" && hasValue) {
+            options.shaderCachePath = argv[++i];
+        } else if (arg == "--no-shader-cache") {
+            options.shaderCachePath.clear();
+        } else if (arg == "--importance") {
+            options.importance = true;
+        } else if (arg == "--ray-stats") {
+            options.rayStats = true;
+        } else if (arg == "--importance-view") {
+            options.importance = true;
+            options.importanceView = true;
+        } else if (arg == "--raster") {
+            options.raster = true;
+        } else if (arg == "--wavefront") {
+            options.wavefront = true;
+        } else if (arg == "--ray-march") {
+            options.rayMarch = true;
+        } else if (arg == "--cpu") {
+            options.cpu = true;
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--cpu-scaling") {
+            options.cpuScaling = true;
+        } else if (arg == "--image" && hasValue) {
+            options.imagePath = argv[++i];
+        } else if (arg == "--capture" && hasValue) {
+            options.capturePath = argv[++i];
+        } else if (arg == "--variant" && hasValue) {
+            options.variant = argv[++i];
+        } else {
+            std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
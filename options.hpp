@@ -0,0 +1,42 @@
+#ifndef OPTIONS_HPP
+#define OPTIONS_HPP
+
+#include "includes.hpp"
+
+// Command line options
+struct Options {
+    bool headless = false;          // Render offscreen through EGL instead of opening a window
+    std::string cameraPath;         // Camera keyframe file to replay
+    std::string recordPath;         // Where to save the camera path flown in windowed mode
+    std::string statsPath;          // Frame time output (.csv or .json)
+    std::string scenePath = "scenes/default.json";  // Scene file (materials, primitives, lights)
+    std::string meshPath;           // Triangle mesh (.obj or .ply) overriding the one named in the scene
+    std::string tracePath;          // Chrome trace_event output of CPU scopes and GPU passes
+    std::string shaderCachePath = "shader_cache";  // Program binary cache directory, empty disables it
+    bool importance = false;        // Per-pixel sample counts from the importance pre-pass (megakernel only)
+    bool importanceView = false;    // Show the importance pre-pass sample budget instead of the image
+    bool rayStats = false;          // Count rays and intersection tests on the GPU (megakernel only)
+    bool raster = false;            // Primary hits from a rasterized G-buffer instead of primary rays (megakernel only)
+    bool wavefront = false;         // Queue-driven multi-pass path tracer instead of the megakernel
+    bool rayMarch = false;          // Sphere trace the scene baked into a distance field instead of path tracing
+    bool cpu = false;               // Path trace on the CPU (headless: without any GL context)
+    int threads = 0;                // CPU renderer threads, 0 uses every core
+    bool cpuScaling = false;        // Time a CPU frame with 1 up to --threads threads
+    std::string imagePath;          // Where to save the last headless CPU frame (.ppm)
+    std::string capturePath;        // Frame capture output: .png/.exr pattern, .y4m or - (Y4M on stdout)
+    std::string variant = "full";   // Path tracer shader variant: full, preview or heatmap
+    int samples = 2;                // Samples per pixel (capped by the shader variant)
+    int bounces = 5;                // Bounces per sample (capped by the shader variant)
+    bool temporal = true;           // Accumulate samples across frames with reprojection
+    int historyFrames = 16;         // History length while the camera or scene moves
+    int denoiseIterations = 4;      // À-trous denoiser iterations, 0 disables the denoiser
+    double targetMs = 0.0;          // GPU frame time the trace resolution adapts to, 0 keeps --scale
+    float scale = 1.0f;             // Trace resolution as a fraction of the output size
+    int frames = 300;               // Frames to measure in headless mode
+    int warmupFrames = 10;          // Frames rendered before measuring starts
+};
+
+// Returns false (after printing usage) if the arguments could not be parsed
+bool parseOptions(int argc, char** argv, Options& options);
+
+#endif // OPTIONS_HPP
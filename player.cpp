@@ -1,4 +1,23 @@
 #include "includes.hpp"
+#include "logger.hpp"
+
+// Keyboard and mouse as sampled on the render thread (SFML input and the window may only be used
+// there), consumed by the input thread's steps
+struct InputState {
+    bool forward = false, backward = false, left = false, right = false, up = false, down = false;
+    bool look = false;              // Mouse look toggle key
+    glm::ivec2 mouseTotal{0};       // Sum of the mouse offsets from the window center so far
+};
+
+// What the renderer needs of the camera, published by the input thread each step
+struct CameraSnapshot {
+    glm::mat4 view;
+    glm::mat4 zeroedView;
+    glm::mat4 projection;
+    glm::vec3 position;
+    float yaw;
+    float pitch;
+};
 
 class Player {
 public:
@@ -7,14 +26,14 @@ public:
            float fov = 100.0f, float aspectRatio = 4.0f / 3.0f, 
            float nearPlane = 0.1f, float farPlane = 100.0f);
 
-    // Move the player based on keyboard input
-    void move(const sf::Time& deltaTime, const sf::Keyboard::Key& forwardKey, 
-              const sf::Keyboard::Key& backwardKey, const sf::Keyboard::Key& leftKey, 
-              const sf::Keyboard::Key& rightKey, const sf::Keyboard::Key& upKey, 
-              const sf::Keyboard::Key& downKey, const sf::Keyboard::Key& canLookKey);
+    // Move the player based on the sampled keys
+    void move(const sf::Time& deltaTime, const InputState& input);
 
-    // Update the player's look direction based on mouse movement
-    void lookAround(const sf::Window& window, float deltaTime);
+    // Update the player's look direction by a mouse movement in pixels, while mouse look is on
+    void lookAround(const glm::vec2& mouseDelta);
+
+    // Mouse look toggled on with the look key
+    bool isLookingAround() const { return canLookAround; }
 
     // Get the transformation matrix of the player (model matrix)
     glm::mat4 getTransformationMatrix() const;
@@ -27,9 +46,25 @@ public:
     // Get the projection matrix
     glm::mat4 getProjectionMatrix() const;
 
+    // Follow the window's shape after a resize
+    void setAspectRatio(float newAspectRatio) { aspectRatio = newAspectRatio; }
+
     // Get the player's position
     glm::vec3 getPosition() const;
 
+    // Get the player's look angles in degrees
+    float getYaw() const;
+    float getPitch() const;
+
+    // Place the player at a position with a look direction (used for camera path playback)
+    void setPose(const glm::vec3& newPosition, float newYaw, float newPitch);
+
+    // Matrices and pose for the renderer
+    CameraSnapshot snapshot() const;
+
+    // Where move() reports position changes, nullptr for nowhere
+    void setLogger(AsyncLogger* newLogger) { logger = newLogger; }
+
 private:
     glm::vec3 position;
     glm::vec3 direction;
@@ -40,55 +75,59 @@ private:
     float farPlane;
     float yaw;    // Horizontal rotation (yaw)
     float pitch;  // Vertical rotation (pitch)
-    bool canLookAround;  // Vertical rotation (pitch)
+    bool canLookAround;
+    bool lookKeyWasPressed = false;
+    glm::vec3 loggedPosition;
+    glm::vec3 loggedDirection;
+    AsyncLogger* logger = nullptr;
 };
 
 Player::Player(glm::vec3 position, glm::vec3 direction, float speed, 
                float fov, float aspectRatio, float nearPlane, float farPlane)
     : position(position), direction(glm::normalize(direction)), 
       speed(speed), fov(fov), aspectRatio(aspectRatio), 
-      nearPlane(nearPlane), farPlane(farPlane), yaw(0.0f), pitch(0.0f) {}
+      nearPlane(nearPlane), farPlane(farPlane), yaw(0.0f), pitch(0.0f), canLookAround(false),
+      loggedPosition(position), loggedDirection(this->direction) {}
 
-void Player::move(const sf::Time& deltaTime, const sf::Keyboard::Key& forwardKey, 
-                  const sf::Keyboard::Key& backwardKey, const sf::Keyboard::Key& leftKey, 
-                  const sf::Keyboard::Key& rightKey, const sf::Keyboard::Key& upKey, 
-                  const sf::Keyboard::Key& downKey, const sf::Keyboard::Key& canLookKey) {
+void Player::move(const sf::Time& deltaTime, const InputState& input) {
     float velocity = speed * deltaTime.asSeconds();
 
-    if (sf::Keyboard::isKeyPressed(forwardKey)) {
+    if (input.forward) {
         position += direction * velocity;
     }
-    if (sf::Keyboard::isKeyPressed(backwardKey)) {
+    if (input.backward) {
         position -= direction * velocity;
     }
-    if (sf::Keyboard::isKeyPressed(leftKey)) {
+    if (input.left) {
         position -= glm::normalize(glm::cross(direction, glm::vec3(0.0f, 1.0f, 0.0f))) * velocity;
     }
-    if (sf::Keyboard::isKeyPressed(rightKey)) {
+    if (input.right) {
         position += glm::normalize(glm::cross(direction, glm::vec3(0.0f, 1.0f, 0.0f))) * velocity;
     }
-    if (sf::Keyboard::isKeyPressed(upKey)) {
+    if (input.up) {
         position += glm::vec3(0.0f, 1.0f, 0.0f) * velocity;
     }
-    if (sf::Keyboard::isKeyPressed(downKey)) {
+    if (input.down) {
         position -= glm::vec3(0.0f, 1.0f, 0.0f) * velocity;
     }
-    if (sf::Keyboard::isKeyPressed(canLookKey)) {
+    // Toggle once per key press, not on every step it is held
+    bool lookKeyPressed = input.look;
+    if (lookKeyPressed && !lookKeyWasPressed) {
         canLookAround = !canLookAround;
     }
+    lookKeyWasPressed = lookKeyPressed;
 
-    std::cout<<"pos : "<<position.x<<", "<<position.y<<", "<<position.z<<" dir : "<<direction.x<<", "<<direction.y<<", "<<direction.z<<std::endl;
+    if (logger && (position != loggedPosition || direction != loggedDirection)) {
+        logger->log("pos : %g, %g, %g dir : %g, %g, %g", position.x, position.y, position.z, direction.x, direction.y, direction.z);
+        loggedPosition = position;
+        loggedDirection = direction;
+    }
 }
 
-void Player::lookAround(const sf::Window& window, float deltaTime) {
+void Player::lookAround(const glm::vec2& mouseDelta) {
     if (canLookAround){
-    // Get the mouse position relative to the window
-    sf::Vector2i mousePos = sf::Mouse::getPosition(window);
-    sf::Vector2i center(window.getSize().x / 2, window.getSize().y / 2);
-
-    // Calculate the mouse delta movement
-    float deltaX = mousePos.x - center.x;
-    float deltaY = mousePos.y - center.y;
+    float deltaX = mouseDelta.x;
+    float deltaY = mouseDelta.y;
 
     // Sensitivity for mouse movement
     float sensitivity = 0.1f;
@@ -106,9 +145,6 @@ void Player::lookAround(const sf::Window& window, float deltaTime) {
     front.y = sin(glm::radians(pitch));
     front.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
     direction = glm::normalize(front);
-
-        // Move the mouse back to the center of the screen
-        sf::Mouse::setPosition(center, window);
     }
 }
 
@@ -140,3 +176,29 @@ glm::mat4 Player::getProjectionMatrix() const {
 glm::vec3 Player::getPosition() const {
     return position;
 }
+
+
+float Player::getYaw() const {
+    return yaw;
+}
+
+float Player::getPitch() const {
+    return pitch;
+}
+
+CameraSnapshot Player::snapshot() const {
+    return {getViewMatrix(), getZeroedViewMatrix(), getProjectionMatrix(), position, yaw, pitch};
+}
+
+void Player::setPose(const glm::vec3& newPosition, float newYaw, float newPitch) {
+    position = newPosition;
+    yaw = newYaw;
+    pitch = glm::clamp(newPitch, -89.0f, 89.0f);
+
+    // Same direction calculation as lookAround
+    glm::vec3 front;
+    front.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
+    front.y = sin(glm::radians(pitch));
+    front.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+    direction = glm::normalize(front);
+}
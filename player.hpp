@@ -3,6 +3,26 @@
 
 #include "includes.hpp"
 
+class AsyncLogger;
+
+// Keyboard and mouse as sampled on the render thread (SFML input and the window may only be used
+// there), consumed by the input thread's steps
+struct InputState {
+    bool forward = false, backward = false, left = false, right = false, up = false, down = false;
+    bool look = false;              // Mouse look toggle key
+    glm::ivec2 mouseTotal{0};       // Sum of the mouse offsets from the window center so far
+};
+
+// What the renderer needs of the camera, published by the input thread each step
+struct CameraSnapshot {
+    glm::mat4 view;
+    glm::mat4 zeroedView;
+    glm::mat4 projection;
+    glm::vec3 position;
+    float yaw;
+    float pitch;
+};
+
 class Player {
 public:
     // Constructor with default parameters for field of view (fov), aspect ratio, and planes
@@ -10,14 +30,14 @@ public:
            float fov = 100.0f, float aspectRatio = 4.0f / 3.0f, 
            float nearPlane = 0.1f, float farPlane = 100.0f);
 
-    // Move the player based on keyboard input
-    void move(const sf::Time& deltaTime, const sf::Keyboard::Key& forwardKey, 
-              const sf::Keyboard::Key& backwardKey, const sf::Keyboard::Key& leftKey, 
-              const sf::Keyboard::Key& rightKey, const sf::Keyboard::Key& upKey, 
-              const sf::Keyboard::Key& downKey, const sf::Keyboard::Key& canLookKey);
+    // Move the player based on the sampled keys
+    void move(const sf::Time& deltaTime, const InputState& input);
 
-    // Update the player's look direction based on mouse movement
-    void lookAround(const sf::Window& window, float deltaTime);
+    // Update the player's look direction by a mouse movement in pixels, while mouse look is on
+    void lookAround(const glm::vec2& mouseDelta);
+
+    // Mouse look toggled on with the look key
+    bool isLookingAround() const { return canLookAround; }
 
     // Get the transformation matrix of the player (model matrix)
     glm::mat4 getTransformationMatrix() const;
@@ -30,9 +50,25 @@ public:
     // Get the projection matrix
     glm::mat4 getProjectionMatrix() const;
 
+    // Follow the window's shape after a resize
+    void setAspectRatio(float newAspectRatio) { aspectRatio = newAspectRatio; }
+
     // Get the player's position
     glm::vec3 getPosition() const;
 
+    // Get the player's look angles in degrees
+    float getYaw() const;
+    float getPitch() const;
+
+    // Place the player at a position with a look direction (used for camera path playback)
+    void setPose(const glm::vec3& newPosition, float newYaw, float newPitch);
+
+    // Matrices and pose for the renderer
+    CameraSnapshot snapshot() const;
+
+    // Where move() reports position changes, nullptr for nowhere
+    void setLogger(AsyncLogger* newLogger) { logger = newLogger; }
+
 private:
     glm::vec3 position;
     glm::vec3 direction;
@@ -44,6 +80,10 @@ private:
     float yaw;    // Horizontal rotation (yaw)
     float pitch;  // Vertical rotation (pitch)
     bool canLookAround;
+    bool lookKeyWasPressed = false;
+    glm::vec3 loggedPosition;
+    glm::vec3 loggedDirection;
+    AsyncLogger* logger = nullptr;
 };
 
 #endif // PLAYER_HPP
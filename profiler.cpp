@@ -0,0 +1,128 @@
+#include "includes.hpp"
+#include "profiler.hpp"
+
+Profiler::Profiler() {
+    cpuOrigin = std::chrono::steady_clock::now();
+    glGetInteger64v(GL_TIMESTAMP, &gpuOrigin);
+}
+
+Profiler::~Profiler() {
+    for (auto& queries : frameQueries) {
+        for (const GpuQuery& query : queries) {
+            glDeleteQueries(1, &query.begin);
+            glDeleteQueries(1, &query.end);
+        }
+    }
+}
+
+void Profiler::beginFrame(unsigned int frameNo) {
+    currentSlot = frameNo % LATENCY;
+
+    // This slot was last written LATENCY frames ago, its results are (almost always) ready
+    resolveSlot(currentSlot);
+    queriesUsed[currentSlot] = 0;
+}
+
+void Profiler::beginGpu(const char* name) {
+    std::vector<GpuQuery>& queries = frameQueries[currentSlot];
+    size_t& used = queriesUsed[currentSlot];
+
+    if (used == queries.size()) {
+        GpuQuery query{name, 0, 0};
+        glGenQueries(1, &query.begin);
+        glGenQueries(1, &query.end);
+        queries.push_back(query);
+    }
+
+    GpuQuery& query = queries[used];
+    query.name = name;
+    glQueryCounter(query.begin, GL_TIMESTAMP);
+    gpuPassOpen = true;
+}
+
+void Profiler::endGpu() {
+    if (!gpuPassOpen) {
+        return;
+    }
+
+    GpuQuery& query = frameQueries[currentSlot][queriesUsed[currentSlot]];
+    glQueryCounter(query.end, GL_TIMESTAMP);
+    queriesUsed[currentSlot]++;
+    gpuPassOpen = false;
+}
+
+void Profiler::addCpuEvent(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    if (!tracing) {
+        return;
+    }
+
+    double startUs = std::chrono::duration<double, std::micro>(start - cpuOrigin).count();
+    double durationUs = std::chrono::duration<double, std::micro>(end - start).count();
+    events.push_back({name, startUs, durationUs, 0});
+}
+
+void Profiler::flush() {
+    glFinish();
+    for (int i = 1; i <= LATENCY; i++) {
+        int slot = (currentSlot + i) % LATENCY;
+        resolveSlot(slot);
+        queriesUsed[slot] = 0;
+    }
+}
+
+double Profiler::getGpuTime(const std::string& name) const {
+    auto it = lastGpuTimes.find(name);
+    return it != lastGpuTimes.end() ? it->second : 0.0;
+}
+
+void Profiler::resolveSlot(int slot) {
+    const std::vector<GpuQuery>& queries = frameQueries[slot];
+    size_t used = queriesUsed[slot];
+    if (used == 0) {
+        return;
+    }
+
+    // Never wait: if the GPU is still further behind than LATENCY frames, drop this frame's timings
+    GLint available = 0;
+    glGetQueryObjectiv(queries[used - 1].end, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        return;
+    }
+
+    double frameTime = 0.0;
+    for (size_t i = 0; i < used; i++) {
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(queries[i].begin, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(queries[i].end, GL_QUERY_RESULT, &end);
+
+        double durationMs = (end - begin) / 1.0e6;
+        lastGpuTimes[queries[i].name] = durationMs;
+        frameTime += durationMs;
+
+        if (tracing) {
+            double startUs = (static_cast<GLint64>(begin) - gpuOrigin) / 1.0e3;
+            events.push_back({queries[i].name, startUs, durationMs * 1.0e3, 1});
+        }
+    }
+    lastGpuFrameTime = frameTime;
+}
+
+bool Profiler::writeTrace(const std::string& filepath) const {
+    std::ofstream file(filepath);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not write trace: " << filepath << std::endl;
+        return false;
+    }
+
+    // Chrome trace_event format, complete ("X") events in microseconds
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+    file << std::fixed << std::setprecision(3);
+    for (const TraceEvent& event : events) {
+        file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.track
+             << ",\"ts\":" << event.start << ",\"dur\":" << event.duration << "}";
+    }
+    file << "\n]}\n";
+    return true;
+}
@@ -0,0 +1,95 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include "includes.hpp"
+
+// Frame profiler: CPU scopes and GPU passes on one timeline, exported as a Chrome trace_event JSON
+// (open in chrome://tracing or https://ui.perfetto.dev).
+// GPU passes are timed with GL_TIMESTAMP queries that are read back LATENCY frames later,
+// so reading them never waits on the GPU.
+class Profiler {
+public:
+    static constexpr int LATENCY = 4;   // Frames in flight before a query slot is reused
+
+    Profiler();
+    ~Profiler();
+
+    // Start recording trace events (GPU timings are always collected)
+    void enableTrace() { tracing = true; }
+    bool isTracing() const { return tracing; }
+
+    // Call at the start of every frame, collects the GPU timings of LATENCY frames ago
+    void beginFrame(unsigned int frameNo);
+
+    // GPU pass timing, passes must not nest
+    void beginGpu(const char* name);
+    void endGpu();
+
+    // Record a finished CPU scope
+    void addCpuEvent(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+    // Last resolved GPU time of a pass in milliseconds (0 if not measured yet)
+    double getGpuTime(const std::string& name) const;
+    // Sum of all GPU passes of the last resolved frame in milliseconds
+    double getGpuFrameTime() const { return lastGpuFrameTime; }
+
+    // Wait for the GPU and collect every outstanding frame (use at shutdown only)
+    void flush();
+
+    bool writeTrace(const std::string& filepath) const;
+
+private:
+    struct GpuQuery {
+        const char* name;
+        GLuint begin, end;
+    };
+
+    struct TraceEvent {
+        const char* name;
+        double start;     // Microseconds since the profiler was created
+        double duration;  // Microseconds
+        int track;        // 0 = CPU, 1 = GPU
+    };
+
+    // Query objects are created on demand and reused every LATENCY frames
+    std::vector<GpuQuery> frameQueries[LATENCY];
+    size_t queriesUsed[LATENCY] = {};
+    int currentSlot = 0;
+    bool gpuPassOpen = false;
+
+    bool tracing = false;
+    std::vector<TraceEvent> events;
+
+    std::chrono::steady_clock::time_point cpuOrigin;
+    GLint64 gpuOrigin = 0;   // GL_TIMESTAMP at cpuOrigin, lines both clocks up
+
+    std::map<std::string, double> lastGpuTimes;
+    double lastGpuFrameTime = 0.0;
+
+    void resolveSlot(int slot);
+};
+
+// Times the enclosing scope on the CPU track
+class CpuScope {
+public:
+    CpuScope(Profiler& profiler, const char* name)
+        : profiler(profiler), name(name), start(std::chrono::steady_clock::now()) {}
+    ~CpuScope() { profiler.addCpuEvent(name, start, std::chrono::steady_clock::now()); }
+
+private:
+    Profiler& profiler;
+    const char* name;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Times the GL commands issued in the enclosing scope on the GPU track
+class GpuScope {
+public:
+    GpuScope(Profiler& profiler, const char* name) : profiler(profiler) { profiler.beginGpu(name); }
+    ~GpuScope() { profiler.endGpu(); }
+
+private:
+    Profiler& profiler;
+};
+
+#endif // PROFILER_HPP
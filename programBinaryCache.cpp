@@ -0,0 +1,149 @@
+#include "includes.hpp"
+#include "programBinaryCache.hpp"
+
+namespace {
+
+// Entry file layout: header, then the driver's binary blob
+struct EntryHeader {
+    char magic[4];          // "RTPB"
+    uint32_t version;
+    uint32_t binaryFormat;
+    uint32_t binarySize;
+    uint64_t keyHash;       // Second hash of the key, guards against file name collisions
+};
+
+constexpr uint32_t ENTRY_VERSION = 1;
+
+// 64 bit FNV-1a
+uint64_t hashString(const std::string& text, uint64_t hash = 1469598103934665603ull) {
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string getString(GLenum name) {
+    const GLubyte* value = glGetString(name);
+    return value ? reinterpret_cast<const char*>(value) : "";
+}
+
+} // namespace
+
+ProgramBinaryCache::ProgramBinaryCache(const std::string& directory) : directory(directory) {
+    driver = getString(GL_VENDOR) + "\n" + getString(GL_RENDERER) + "\n" + getString(GL_VERSION);
+
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount <= 0) {
+        std::cerr << "Shader cache: driver has no program binary formats, caching disabled" << std::endl;
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(this->directory, error);
+    if (error) {
+        std::cerr << "Shader cache: could not create " << directory << ": " << error.message() << std::endl;
+        return;
+    }
+    enabled = true;
+}
+
+std::string ProgramBinaryCache::makeKey(const std::vector<std::pair<GLenum, std::string>>& sources) const {
+    std::string key = driver;
+    for (const auto& [type, source] : sources) {
+        key += "\n" + std::to_string(type) + "\n" + std::to_string(source.size()) + "\n" + source;
+    }
+    return key;
+}
+
+std::filesystem::path ProgramBinaryCache::entryPath(const std::string& key) const {
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << hashString(key) << ".bin";
+    return directory / name.str();
+}
+
+bool ProgramBinaryCache::load(const std::string& key, GLuint program) {
+    if (!enabled) {
+        return false;
+    }
+
+    std::ifstream file(entryPath(key), std::ios::binary);
+    EntryHeader header{};
+    if (!file.is_open() || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, "RTPB", 4) != 0 || header.version != ENTRY_VERSION ||
+        header.keyHash != hashString(key, 0x84222325cbf29ce4ull)) {
+        misses++;
+        return false;
+    }
+
+    std::vector<char> binary(header.binarySize);
+    if (!file.read(binary.data(), binary.size())) {
+        misses++;
+        return false;
+    }
+
+    glProgramBinary(program, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint success = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        // Driver changed in a way the version string doesn't show, the caller compiles from source
+        rejected++;
+        misses++;
+        return false;
+    }
+
+    hits++;
+    return true;
+}
+
+void ProgramBinaryCache::store(const std::string& key, GLuint program) {
+    if (!enabled) {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    EntryHeader header{};
+    std::memcpy(header.magic, "RTPB", 4);
+    header.version = ENTRY_VERSION;
+    header.binaryFormat = format;
+    header.binarySize = static_cast<uint32_t>(length);
+    header.keyHash = hashString(key, 0x84222325cbf29ce4ull);
+
+    // Write to a temporary file first so concurrently starting processes never read half an entry
+    std::filesystem::path path = entryPath(key);
+    std::filesystem::path temporary = path;
+    temporary += ".tmp" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Shader cache: could not write " << temporary.string() << std::endl;
+            return;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), length);
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+    }
+}
+
+void ProgramBinaryCache::printStats(std::ostream& out) const {
+    out << "Shader cache: " << hits << " hits, " << misses << " misses";
+    if (rejected > 0) {
+        out << " (" << rejected << " rejected by the driver)";
+    }
+    out << std::endl;
+}
@@ -0,0 +1,43 @@
+#ifndef PROGRAM_BINARY_CACHE_HPP
+#define PROGRAM_BINARY_CACHE_HPP
+
+#include "includes.hpp"
+
+// Linked programs stored on disk with glGetProgramBinary, one file per program.
+// The key is a hash of the preprocessed sources plus GL_VENDOR/GL_RENDERER/GL_VERSION,
+// so a driver update or an edited shader simply misses and recompiles.
+class ProgramBinaryCache {
+public:
+    explicit ProgramBinaryCache(const std::string& directory);
+
+    // False if the driver has no binary formats or the directory can't be created
+    bool isEnabled() const { return enabled; }
+
+    // Key for a set of (stage, preprocessed source) pairs on the current driver
+    std::string makeKey(const std::vector<std::pair<GLenum, std::string>>& sources) const;
+
+    // Loads the binary into program; false on a miss or when the driver rejects it
+    bool load(const std::string& key, GLuint program);
+
+    // Saves a successfully linked program (linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT)
+    void store(const std::string& key, GLuint program);
+
+    size_t getHits() const { return hits; }
+    size_t getMisses() const { return misses; }
+    size_t getRejected() const { return rejected; }
+
+    void printStats(std::ostream& out) const;
+
+private:
+    std::filesystem::path directory;
+    std::string driver;     // Vendor, renderer and version strings
+    bool enabled = false;
+
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t rejected = 0;    // Found on disk but refused by glProgramBinary (counted as misses too)
+
+    std::filesystem::path entryPath(const std::string& key) const;
+};
+
+#endif // PROGRAM_BINARY_CACHE_HPP
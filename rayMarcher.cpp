@@ -0,0 +1,132 @@
+#include "includes.hpp"
+#include "rayMarcher.hpp"
+
+namespace {
+
+GLuint createVolume(GLenum internalFormat, GLenum format, GLenum type, GLenum filter, int width, int height, int depth, const void* data) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_3D, texture);
+    glTexImage3D(GL_TEXTURE_3D, 0, internalFormat, width, height, depth, 0, format, type, data);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_3D, 0);
+    return texture;
+}
+
+} // namespace
+
+RayMarcher::RayMarcher(ShaderCache& shaderCache)
+    : coarseConeTexture(1, 1, GL_R32F, GL_RED, GL_FLOAT),
+      fineConeTexture(1, 1, GL_R32F, GL_RED, GL_FLOAT) {
+    const std::string source = "shaders/compute/rayMarch_shader.glsl";
+    const std::string coarse = std::to_string(COARSE_CONE_TILE);
+    const std::string fine = std::to_string(FINE_CONE_TILE);
+    program = shaderCache.get({{GL_COMPUTE_SHADER, source}}, {{"SDF_BRICKS", "1"}, {"CONE_PREPASS", fine}});
+    coarseConeProgram = shaderCache.get({{GL_COMPUTE_SHADER, source}}, {{"SDF_BRICKS", "1"}, {"CONE_TILE", coarse}});
+    fineConeProgram = shaderCache.get({{GL_COMPUTE_SHADER, source}},
+                                      {{"SDF_BRICKS", "1"}, {"CONE_TILE", fine}, {"CONE_PARENT_TILE", coarse}});
+}
+
+RayMarcher::~RayMarcher() {
+    GLuint textures[] = {cellTexture, cellDistanceTexture, atlasTexture, materialTexture};
+    glDeleteTextures(4, textures);
+}
+
+void RayMarcher::setScene(const Scene& scene) {
+    auto bakeStart = std::chrono::steady_clock::now();
+    brickMap = bakeSdf(sdfPrimitivesFromScene(scene), CELLS_PER_AXIS, pool);
+    double bakeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bakeStart).count();
+    std::cout << "SDF: " << brickMap.cellsX << "x" << brickMap.cellsY << "x" << brickMap.cellsZ << " cells, "
+              << brickMap.brickCount << " bricks, baked in " << bakeMs << " ms" << std::endl;
+
+    GLuint textures[] = {cellTexture, cellDistanceTexture, atlasTexture, materialTexture};
+    glDeleteTextures(4, textures);
+    if (brickMap.cellBricks.empty()) {
+        // Nothing to march against: a single empty cell
+        brickMap.cellsX = brickMap.cellsY = brickMap.cellsZ = 1;
+        brickMap.cellBricks.assign(1, SdfBrickMap::EMPTY_CELL);
+        brickMap.cellDistances.assign(1, 0.0f);
+        brickMap.atlasDistances.assign(SdfBrickMap::BRICK_SIZE * SdfBrickMap::BRICK_SIZE * SdfBrickMap::BRICK_SIZE, 0.0f);
+        brickMap.atlasMaterials.assign(brickMap.atlasDistances.size(), 0);
+    }
+
+    // The shader reads each cell's brick position in the atlas instead of its index
+    std::vector<uint32_t> cellAtlasPositions(brickMap.cellBricks.size());
+    for (size_t cell = 0; cell < cellAtlasPositions.size(); cell++) {
+        uint32_t brick = brickMap.cellBricks[cell];
+        uint32_t x = brick % brickMap.atlasBricksX;
+        uint32_t y = (brick / brickMap.atlasBricksX) % brickMap.atlasBricksY;
+        uint32_t z = brick / (brickMap.atlasBricksX * brickMap.atlasBricksY);
+        cellAtlasPositions[cell] = brick == SdfBrickMap::EMPTY_CELL ? brick : x | (y << 10) | (z << 20);
+    }
+
+    const int B = SdfBrickMap::BRICK_SIZE;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    cellTexture = createVolume(GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, GL_NEAREST,
+                               brickMap.cellsX, brickMap.cellsY, brickMap.cellsZ, cellAtlasPositions.data());
+    cellDistanceTexture = createVolume(GL_R32F, GL_RED, GL_FLOAT, GL_NEAREST,
+                                       brickMap.cellsX, brickMap.cellsY, brickMap.cellsZ, brickMap.cellDistances.data());
+    atlasTexture = createVolume(GL_R16F, GL_RED, GL_FLOAT, GL_LINEAR,
+                                brickMap.atlasBricksX * B, brickMap.atlasBricksY * B, brickMap.atlasBricksZ * B, brickMap.atlasDistances.data());
+    materialTexture = createVolume(GL_R16UI, GL_RED_INTEGER, GL_UNSIGNED_SHORT, GL_NEAREST,
+                                   brickMap.atlasBricksX * B, brickMap.atlasBricksY * B, brickMap.atlasBricksZ * B, brickMap.atlasMaterials.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void RayMarcher::bindScene(Shader& shader) {
+    shader.use();
+    shader.setVec3("sdfOrigin", glm::vec3(brickMap.origin.x, brickMap.origin.y, brickMap.origin.z));
+    shader.setFloat("sdfCellSize", brickMap.cellSize);
+    shader.setVec3("sdfGridSize", glm::vec3(brickMap.cellsX, brickMap.cellsY, brickMap.cellsZ));
+    const float B = static_cast<float>(SdfBrickMap::BRICK_SIZE);
+    shader.setVec3("sdfAtlasSize", glm::vec3(brickMap.atlasBricksX * B, brickMap.atlasBricksY * B, brickMap.atlasBricksZ * B));
+}
+
+void RayMarcher::dispatch(Shader& shader, int width, int height) {
+    glm::ivec3 groupSize = shader.getWorkGroupSize();
+    glDispatchCompute((width + groupSize.x - 1) / groupSize.x, (height + groupSize.y - 1) / groupSize.y, 1);
+}
+
+void RayMarcher::render(const Texture& screen, const Texture& normal, const Texture& depth) {
+    int width = screen.getWidth();
+    int height = screen.getHeight();
+    int coarseWidth = (width + COARSE_CONE_TILE - 1) / COARSE_CONE_TILE;
+    int coarseHeight = (height + COARSE_CONE_TILE - 1) / COARSE_CONE_TILE;
+    int fineWidth = (width + FINE_CONE_TILE - 1) / FINE_CONE_TILE;
+    int fineHeight = (height + FINE_CONE_TILE - 1) / FINE_CONE_TILE;
+    if (coarseConeTexture.getWidth() != coarseWidth || coarseConeTexture.getHeight() != coarseHeight) {
+        coarseConeTexture.resize(coarseWidth, coarseHeight);
+        fineConeTexture.resize(fineWidth, fineHeight);
+    }
+
+    // Sampler bindings 0-3 in the shader, shared by the three passes
+    GLuint textures[] = {cellTexture, cellDistanceTexture, atlasTexture, materialTexture};
+    for (GLuint unit = 0; unit < 4; unit++) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_3D, textures[unit]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    // Cone passes: 8x8 tiles from the camera, then 4x4 tiles from their 8x8 tile's distance
+    bindScene(*coarseConeProgram);
+    coarseConeProgram->setImage("coneDistance", coarseConeTexture.getID(), 3, GL_R32F);
+    dispatch(*coarseConeProgram, coarseWidth, coarseHeight);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+    bindScene(*fineConeProgram);
+    fineConeProgram->setImage("coneDistance", fineConeTexture.getID(), 3, GL_R32F);
+    fineConeProgram->setImage("parentConeDistance", coarseConeTexture.getID(), 4, GL_R32F);
+    dispatch(*fineConeProgram, fineWidth, fineHeight);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+    bindScene(*program);
+    program->setImage("screenTexture", screen.getID(), 0, GL_RGBA16F);
+    program->setImage("normalTexture", normal.getID(), 1, GL_RGBA16F);
+    program->setImage("depthTexture", depth.getID(), 2, GL_R32F);
+    program->setImage("coneDistance", fineConeTexture.getID(), 3, GL_R32F);
+    dispatch(*program, width, height);
+}
@@ -0,0 +1,51 @@
+#ifndef RAY_MARCHER_HPP
+#define RAY_MARCHER_HPP
+
+#include "includes.hpp"
+#include "shaderStuff.hpp"
+#include "scene.hpp"
+#include "sdfBaker.hpp"
+
+// Sphere-traced renderer (shaders/compute/rayMarch_shader.glsl, SDF_BRICKS variant) for the scene's
+// spheres, boxes and lights. The scene is baked into a sparse brick map on the CPU whenever it is set,
+// and uploaded as 3D textures: cell bricks (R32UI), cell center distances (R32F), the distance atlas
+// (R16F, linear filtering) and the material atlas (R16UI).
+// Before the per-pixel march two cone passes (CONE_TILE variants) find how far the rays of each 8x8 and
+// then each 4x4 pixel tile can skip together, so open space is crossed once per tile instead of per pixel.
+class RayMarcher {
+public:
+    static constexpr int CELLS_PER_AXIS = 48;   // Coarse cells along the scene's longest side
+    static constexpr int COARSE_CONE_TILE = 8;  // Pixels per side of the first cone pass's tiles
+    static constexpr int FINE_CONE_TILE = 4;    // and of the second's, the per-pixel march starts from these
+
+    explicit RayMarcher(ShaderCache& shaderCache);
+    ~RayMarcher();
+
+    RayMarcher(const RayMarcher&) = delete;
+    RayMarcher& operator=(const RayMarcher&) = delete;
+
+    // Bakes and uploads the scene's current state, animated objects keep this pose until the next call
+    void setScene(const Scene& scene);
+
+    // Marches one ray per pixel into the color, normal and depth images (trace resolution).
+    // Frame uniforms and scene buffers must be bound.
+    void render(const Texture& screen, const Texture& normal, const Texture& depth);
+
+private:
+    TilePool pool;
+    std::shared_ptr<Shader> program;
+    std::shared_ptr<Shader> coarseConeProgram;
+    std::shared_ptr<Shader> fineConeProgram;
+    Texture coarseConeTexture;      // R32F safe start distance per tile
+    Texture fineConeTexture;
+    SdfBrickMap brickMap;
+    GLuint cellTexture = 0;
+    GLuint cellDistanceTexture = 0;
+    GLuint atlasTexture = 0;
+    GLuint materialTexture = 0;
+
+    void bindScene(Shader& shader);
+    void dispatch(Shader& shader, int width, int height);
+};
+
+#endif // RAY_MARCHER_HPP
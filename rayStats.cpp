@@ -0,0 +1,152 @@
+#include "includes.hpp"
+#include "rayStats.hpp"
+
+void RayStats::Frame::add(const Frame& other) {
+    for (int i = 0; i < COUNTERS; i++) {
+        counters[i] += other.counters[i];
+    }
+    for (int i = 0; i < SAMPLE_BINS; i++) {
+        samples[i] += other.samples[i];
+    }
+    for (int i = 0; i < BOUNCE_BINS; i++) {
+        bounces[i] += other.bounces[i];
+    }
+    gpuMs += other.gpuMs;
+}
+
+RayStats::RayStats() {
+    for (Slot& slot : slots) {
+        glGenBuffers(1, &slot.buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, slot.buffer);
+        // Low and high word of each 64 bit counter
+        glBufferData(GL_SHADER_STORAGE_BUFFER, TOTAL * 2 * sizeof(GLuint), nullptr, GL_DYNAMIC_READ);
+        glGenQueries(2, slot.queries);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+RayStats::~RayStats() {
+    for (Slot& slot : slots) {
+        if (slot.fence) {
+            glDeleteSync(slot.fence);
+        }
+        glDeleteQueries(2, slot.queries);
+        glDeleteBuffers(1, &slot.buffer);
+    }
+}
+
+void RayStats::begin(unsigned int frameNo) {
+    // Oldest first, stops at the first frame the GPU hasn't finished
+    for (int i = 0; i < SLOTS; i++) {
+        Slot& slot = slots[(nextSlot + i) % SLOTS];
+        if (!slot.fence) {
+            continue;
+        }
+        if (glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            break;
+        }
+        collect(slot);
+    }
+
+    Slot& slot = slots[nextSlot];
+    if (slot.fence) {
+        // SLOTS frames behind, the counters have to be read before the buffer is reused
+        glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        collect(slot);
+    }
+
+    GLuint zero = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, slot.buffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING, slot.buffer);
+    glQueryCounter(slot.queries[0], GL_TIMESTAMP);
+    slot.frameNo = frameNo;
+}
+
+void RayStats::end() {
+    Slot& slot = slots[nextSlot];
+    glQueryCounter(slot.queries[1], GL_TIMESTAMP);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    nextSlot = (nextSlot + 1) % SLOTS;
+}
+
+void RayStats::flush() {
+    for (int i = 0; i < SLOTS; i++) {
+        Slot& slot = slots[(nextSlot + i) % SLOTS];
+        if (slot.fence) {
+            glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            collect(slot);
+        }
+    }
+}
+
+// The slot's fence has signaled: reading the buffer and the queries doesn't wait
+void RayStats::collect(Slot& slot) {
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    GLuint words[TOTAL * 2];
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, slot.buffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(words), words);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    auto value = [&](int index) { return static_cast<uint64_t>(words[index * 2 + 1]) << 32 | words[index * 2]; };
+
+    Frame frame;
+    for (int i = 0; i < COUNTERS; i++) {
+        frame.counters[i] = value(i);
+    }
+    for (int i = 0; i < SAMPLE_BINS; i++) {
+        frame.samples[i] = value(COUNTERS + i);
+    }
+    for (int i = 0; i < BOUNCE_BINS; i++) {
+        frame.bounces[i] = value(COUNTERS + SAMPLE_BINS + i);
+    }
+    GLuint64 start = 0, end = 0;
+    glGetQueryObjectui64v(slot.queries[0], GL_QUERY_RESULT, &start);
+    glGetQueryObjectui64v(slot.queries[1], GL_QUERY_RESULT, &end);
+    frame.gpuMs = (end - start) / 1e6;
+
+    latest = frame;
+    if (slot.frameNo >= firstCounted) {
+        total.add(frame);
+        frameCount++;
+    }
+}
+
+void RayStats::printSummary(std::ostream& out) const {
+    if (frameCount == 0) {
+        out << "Ray stats: no frames counted" << std::endl;
+        return;
+    }
+    double frames = frameCount;
+    auto perFrame = [&](Counter counter) { return total.counters[counter] / frames; };
+    uint64_t paths = total.counters[END_LIGHT] + total.counters[END_MISS] + total.counters[END_BOUNCES];
+    auto share = [&](Counter counter) { return paths ? 100.0 * total.counters[counter] / paths : 0.0; };
+
+    out << std::fixed << std::setprecision(1)
+        << "Ray stats over " << frameCount << " frames: " << total.megaRaysPerSecond() << " Mrays/s, "
+        << total.rays() / frames / 1e6 << " M rays per frame in " << total.gpuMs / frames << " ms\n"
+        << "  rays per frame: primary " << perFrame(PRIMARY_RAYS) << ", secondary " << perFrame(SECONDARY_RAYS)
+        << ", shadow " << perFrame(SHADOW_RAYS) << "\n"
+        << "  tests per frame: sphere " << perFrame(SPHERE_TESTS) << ", box " << perFrame(BOX_TESTS)
+        << ", triangle " << perFrame(TRIANGLE_TESTS) << ", bvh node " << perFrame(NODE_TESTS) << "\n"
+        << "  paths ended: light " << share(END_LIGHT) << "%, miss " << share(END_MISS)
+        << "%, bounce limit " << share(END_BOUNCES) << "%\n";
+
+    auto histogram = [&](const char* name, const uint64_t* bins, int count) {
+        uint64_t sum = 0;
+        for (int i = 0; i < count; i++) {
+            sum += bins[i];
+        }
+        out << "  " << name << ":";
+        for (int i = 0; i < count; i++) {
+            if (bins[i] > 0) {
+                out << " " << i << (i == count - 1 ? "+" : "") << ": " << 100.0 * bins[i] / sum << "%";
+            }
+        }
+        out << "\n";
+    };
+    histogram("samples per pixel", total.samples, SAMPLE_BINS);
+    histogram("segments per path", total.bounces, BOUNCE_BINS);
+    out << std::defaultfloat << std::setprecision(6) << std::flush;
+}
@@ -0,0 +1,82 @@
+#ifndef RAY_STATS_HPP
+#define RAY_STATS_HPP
+
+#include "includes.hpp"
+#include "shaderStuff.hpp"
+
+// Counters of the megakernel's RAY_STATS variant (shaders/compute/include/stats.glsl): rays by kind,
+// intersection tests by primitive, why paths ended, and histograms of the samples each pixel took and
+// the segments of each path. Every frame counts into its own buffer of a small ring, read back once
+// its fence has signaled, so the render loop never waits for the GPU. The trace dispatch is timed with
+// timestamp queries in the same slot, which gives rays per second for exactly the counted frame.
+class RayStats {
+public:
+    static constexpr GLuint BINDING = 11;
+    static constexpr int SLOTS = 4;          // Frames in flight
+
+    // Same order as the STAT_ constants in stats.glsl
+    enum Counter {
+        PRIMARY_RAYS, SECONDARY_RAYS, SHADOW_RAYS,
+        SPHERE_TESTS, BOX_TESTS, TRIANGLE_TESTS, NODE_TESTS,
+        END_LIGHT, END_MISS, END_BOUNCES,
+        COUNTERS
+    };
+    static constexpr int SAMPLE_BINS = 16;
+    static constexpr int BOUNCE_BINS = 8;
+    static constexpr int TOTAL = COUNTERS + SAMPLE_BINS + BOUNCE_BINS;
+
+    struct Frame {
+        uint64_t counters[COUNTERS] = {};
+        uint64_t samples[SAMPLE_BINS] = {};   // Pixels by samples taken, the last bin has the rest
+        uint64_t bounces[BOUNCE_BINS] = {};   // Paths by segments traced
+        double gpuMs = 0.0;                   // Trace dispatch time
+
+        uint64_t rays() const { return counters[PRIMARY_RAYS] + counters[SECONDARY_RAYS] + counters[SHADOW_RAYS]; }
+        double megaRaysPerSecond() const { return gpuMs > 0.0 ? rays() / gpuMs / 1000.0 : 0.0; }
+        void add(const Frame& other);
+    };
+
+    RayStats();
+    ~RayStats();
+
+    RayStats(const RayStats&) = delete;
+    RayStats& operator=(const RayStats&) = delete;
+
+    // Around the megakernel dispatch: begin() collects finished frames, then clears and binds the next slot
+    // (only waiting if it is still in flight from SLOTS frames ago)
+    void begin(unsigned int frameNo);
+    void end();
+
+    // Frames numbered below this don't go into the totals (headless warmup)
+    void setFirstCountedFrame(unsigned int frameNo) { firstCounted = frameNo; }
+
+    // Wait for every frame in flight (use at shutdown only)
+    void flush();
+
+    const Frame& getLatest() const { return latest; }
+    const Frame& getTotal() const { return total; }     // Sum over the counted frames
+    int getFrameCount() const { return frameCount; }
+
+    // Per frame averages of the totals, Mrays/s and both histograms
+    void printSummary(std::ostream& out) const;
+
+private:
+    struct Slot {
+        GLuint buffer = 0;
+        GLuint queries[2] = {};
+        GLsync fence = nullptr;
+        unsigned int frameNo = 0;
+    };
+
+    void collect(Slot& slot);
+
+    Slot slots[SLOTS];
+    int nextSlot = 0;
+    unsigned int firstCounted = 0;
+
+    Frame latest;
+    Frame total;
+    int frameCount = 0;
+};
+
+#endif // RAY_STATS_HPP
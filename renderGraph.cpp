@@ -0,0 +1,217 @@
+#include "includes.hpp"
+#include "renderGraph.hpp"
+
+namespace {
+
+// Everything an image store has to be made visible to, whichever way the texture is used next
+const GLbitfield IMAGE_STORE_HAZARD = GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT |
+                                      GL_TEXTURE_UPDATE_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT |
+                                      GL_FRAMEBUFFER_BARRIER_BIT;
+
+} // namespace
+
+RenderGraph::Pass& RenderGraph::Pass::read(Resource resource, Access access) {
+    uses.push_back({resource, access, false});
+    return *this;
+}
+
+RenderGraph::Pass& RenderGraph::Pass::write(Resource resource, Access access) {
+    uses.push_back({resource, access, true});
+    return *this;
+}
+
+void RenderGraph::reset() {
+    passes.clear();
+    resources.clear();
+}
+
+RenderGraph::Resource RenderGraph::importTexture(const char* name, const Texture& texture) {
+    ResourceInfo info{name, &texture, false};
+    resources.push_back(info);
+    return static_cast<Resource>(resources.size() - 1);
+}
+
+RenderGraph::Resource RenderGraph::createTexture(const char* name, int width, int height, GLenum internalFormat, GLenum format, GLenum dataType) {
+    ResourceInfo info{name, nullptr, true};
+    info.width = width;
+    info.height = height;
+    info.internalFormat = internalFormat;
+    info.format = format;
+    info.dataType = dataType;
+    resources.push_back(info);
+    return static_cast<Resource>(resources.size() - 1);
+}
+
+void RenderGraph::keep(Resource resource) {
+    resources[resource].kept = true;
+}
+
+RenderGraph::Pass& RenderGraph::addPass(const char* name) {
+    passes.emplace_back();
+    passes.back().name = name;
+    return passes.back();
+}
+
+void RenderGraph::compile() {
+    stats = Stats();
+    stats.passes = static_cast<int>(passes.size());
+
+    // Backwards from the side effects and kept resources: a pass is needed when a needed pass after it
+    // reads something it writes
+    std::vector<bool> needed(resources.size(), false);
+    for (size_t i = 0; i < resources.size(); i++) {
+        needed[i] = resources[i].kept;
+    }
+    for (int i = static_cast<int>(passes.size()) - 1; i >= 0; i--) {
+        Pass& pass = passes[i];
+        pass.live = pass.hasSideEffect;
+        for (const Pass::Use& use : pass.uses) {
+            pass.live = pass.live || (use.write && needed[use.resource]);
+        }
+        if (!pass.live) {
+            stats.culled++;
+            continue;
+        }
+        for (const Pass::Use& use : pass.uses) {
+            if (!use.write) {
+                needed[use.resource] = true;
+            }
+        }
+    }
+
+    // Lifetimes over the passes that run
+    for (int i = 0; i < static_cast<int>(passes.size()); i++) {
+        if (!passes[i].live) {
+            continue;
+        }
+        for (const Pass::Use& use : passes[i].uses) {
+            ResourceInfo& info = resources[use.resource];
+            if (info.firstPass < 0) {
+                info.firstPass = i;
+            }
+            info.lastPass = i;
+        }
+    }
+
+    // Greedy assignment in order of first use: any pooled texture of the same size and format whose
+    // current resource is done before this one starts, or a new one
+    for (PoolEntry& entry : pool) {
+        entry.busyUntil = -1;
+    }
+    std::vector<bool> assigned(pool.size(), false);
+    for (int i = 0; i < static_cast<int>(passes.size()); i++) {
+        for (ResourceInfo& info : resources) {
+            if (!info.transient || info.firstPass != i) {
+                continue;
+            }
+            size_t slot = 0;
+            for (; slot < pool.size(); slot++) {
+                const PoolEntry& entry = pool[slot];
+                if (entry.busyUntil < i && entry.texture->getWidth() == info.width && entry.texture->getHeight() == info.height &&
+                    entry.internalFormat == info.internalFormat && entry.format == info.format && entry.dataType == info.dataType) {
+                    break;
+                }
+            }
+            if (slot == pool.size()) {
+                pool.push_back({std::make_unique<Texture>(info.width, info.height, info.internalFormat, info.format, info.dataType),
+                                info.internalFormat, info.format, info.dataType, -1});
+                assigned.push_back(false);
+            }
+            pool[slot].busyUntil = info.lastPass;
+            assigned[slot] = true;
+            info.pooled = pool[slot].texture.get();
+            info.texture = info.pooled;
+            stats.transientBytes += static_cast<size_t>(info.width) * info.height * bytesPerPixel(info.internalFormat);
+        }
+    }
+
+    // Free what this frame didn't need
+    size_t kept = 0;
+    for (size_t slot = 0; slot < pool.size(); slot++) {
+        if (!assigned[slot]) {
+            hazards.erase(pool[slot].texture->getID());
+            continue;
+        }
+        const Texture& texture = *pool[slot].texture;
+        stats.pooledBytes += static_cast<size_t>(texture.getWidth()) * texture.getHeight() * bytesPerPixel(pool[slot].internalFormat);
+        if (kept != slot) {
+            pool[kept] = std::move(pool[slot]);
+        }
+        kept++;
+    }
+    pool.resize(kept);
+}
+
+void RenderGraph::execute(Profiler& profiler) {
+    for (Pass& pass : passes) {
+        if (!pass.live) {
+            continue;
+        }
+
+        // One barrier with the bits this pass's accesses are still missing
+        pass.barrier = 0;
+        for (const Pass::Use& use : pass.uses) {
+            const Hazard& hazard = hazards[resources[use.resource].texture->getID()];
+            GLbitfield bit = barrierBit(use.access);
+            pass.barrier |= hazard.read & bit;
+            if (use.write) {
+                pass.barrier |= hazard.write & bit;
+            }
+        }
+
+        GpuScope gpuScope(profiler, pass.name);
+        if (pass.barrier) {
+            glMemoryBarrier(pass.barrier);
+            stats.barriers++;
+            // It covers every texture, not just this pass's
+            for (auto& entry : hazards) {
+                entry.second.read &= ~pass.barrier;
+                entry.second.write &= ~pass.barrier;
+            }
+        }
+
+        // Only image loads and stores are incoherent, the other accesses are ordered by GL
+        for (const Pass::Use& use : pass.uses) {
+            if (use.access != IMAGE) {
+                continue;
+            }
+            Hazard& hazard = hazards[resources[use.resource].texture->getID()];
+            if (use.write) {
+                hazard.read = IMAGE_STORE_HAZARD;
+            } else {
+                hazard.write |= GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+            }
+        }
+
+        pass.run();
+    }
+}
+
+const Texture& RenderGraph::getTexture(Resource resource) const {
+    return *resources[resource].texture;
+}
+
+Texture& RenderGraph::getTransientTexture(Resource resource) const {
+    return *resources[resource].pooled;
+}
+
+GLbitfield RenderGraph::barrierBit(Access access) {
+    switch (access) {
+        case IMAGE: return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+        case SAMPLED: return GL_TEXTURE_FETCH_BARRIER_BIT;
+        // The readback goes through a pixel pack buffer
+        case TRANSFER: return GL_TEXTURE_UPDATE_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT;
+        case UPLOAD: return GL_TEXTURE_UPDATE_BARRIER_BIT;
+        case ATTACHMENT: return GL_FRAMEBUFFER_BARRIER_BIT;
+    }
+    return 0;
+}
+
+size_t RenderGraph::bytesPerPixel(GLenum internalFormat) {
+    switch (internalFormat) {
+        case GL_R8UI: return 1;
+        case GL_RGBA16F: return 8;
+        case GL_RGBA32F: return 16;
+        default: return 4;    // GL_R32F, GL_R32UI, GL_RG16_SNORM, GL_RGBA8
+    }
+}
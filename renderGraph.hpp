@@ -0,0 +1,122 @@
+#ifndef RENDER_GRAPH_HPP
+#define RENDER_GRAPH_HPP
+
+#include "includes.hpp"
+#include "shaderStuff.hpp"
+#include "profiler.hpp"
+
+// Rebuilt every frame: passes declare the textures they read and write and how, the graph runs them
+// in declaration order and takes care of the rest.
+//  - Culling: a pass runs only if it has side effects (presenting, capturing) or writes something a
+//    later running pass reads or that is kept for the next frame.
+//  - Barriers: glMemoryBarrier is issued before a pass with only the bits its accesses need, for
+//    textures that were image stored (or image loaded, before a write) since the last barrier
+//    covering that kind of access. The state carries over between frames.
+//  - Transient textures: allocated from a pool, a pooled texture is handed to several resources of
+//    the same size and format when their lifetimes (first to last running pass using them) don't
+//    overlap. GL can't place two textures in the same memory, so aliasing reuses the texture object.
+//    Pooled textures no resource used this frame are freed, after a resize for example.
+class RenderGraph {
+public:
+    using Resource = int;
+
+    // How a pass touches a texture
+    enum Access {
+        IMAGE,         // imageLoad / imageStore
+        SAMPLED,       // texture() through a sampler, read only
+        TRANSFER,      // Read back with glGetTexImage / glReadPixels, read only
+        UPLOAD,        // glTexSubImage from the CPU, write only
+        ATTACHMENT     // Framebuffer color attachment
+    };
+
+    class Pass {
+    public:
+        Pass& read(Resource resource, Access access = IMAGE);
+        Pass& write(Resource resource, Access access = IMAGE);
+        // Runs even when nothing reads what it writes
+        Pass& sideEffect() { hasSideEffect = true; return *this; }
+        Pass& execute(std::function<void()> function) { run = std::move(function); return *this; }
+
+    private:
+        friend class RenderGraph;
+        struct Use {
+            Resource resource;
+            Access access;
+            bool write;
+        };
+
+        const char* name;       // Also the GPU profiler scope
+        std::vector<Use> uses;
+        std::function<void()> run;
+        bool hasSideEffect = false;
+        bool live = false;
+        GLbitfield barrier = 0;
+    };
+
+    struct Stats {
+        int passes = 0;
+        int culled = 0;
+        int barriers = 0;
+        size_t transientBytes = 0;   // Every transient resource in its own texture
+        size_t pooledBytes = 0;      // The pooled textures they were assigned to
+    };
+
+    // Forget the previous frame's passes and resources, the pool and barrier state stay
+    void reset();
+
+    // A texture that lives outside the graph (ping-pong history, buffers owned by a renderer)
+    Resource importTexture(const char* name, const Texture& texture);
+    // A texture that only lives within this frame
+    Resource createTexture(const char* name, int width, int height, GLenum internalFormat, GLenum format, GLenum dataType);
+    // The passes writing the resource run even if nothing reads it this frame
+    void keep(Resource resource);
+
+    Pass& addPass(const char* name);
+
+    // Culls passes and assigns pooled textures to the transient resources
+    void compile();
+    // Runs the live passes in order, each in a GPU profiler scope after its barrier
+    void execute(Profiler& profiler);
+
+    // The texture behind a resource, transient ones only once compiled
+    const Texture& getTexture(Resource resource) const;
+    // Writable texture of a transient resource (for uploads), once compiled
+    Texture& getTransientTexture(Resource resource) const;
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct ResourceInfo {
+        const char* name;
+        const Texture* texture;     // Imported, or the pooled texture once compiled
+        bool transient;
+        Texture* pooled = nullptr;
+        bool kept = false;
+        int width = 0, height = 0;
+        GLenum internalFormat = 0, format = 0, dataType = 0;
+        int firstPass = -1, lastPass = -1;
+    };
+
+    struct PoolEntry {
+        std::unique_ptr<Texture> texture;
+        GLenum internalFormat, format, dataType;
+        int busyUntil;              // Last pass of the resource currently assigned to it, this frame
+    };
+
+    // Bits still missing before the texture may be accessed in one way
+    struct Hazard {
+        GLbitfield read = 0;        // Before any access (after an image store)
+        GLbitfield write = 0;       // Before a write (after an image load)
+    };
+
+    static GLbitfield barrierBit(Access access);
+    static size_t bytesPerPixel(GLenum internalFormat);
+
+    std::deque<Pass> passes;
+    std::vector<ResourceInfo> resources;
+    std::vector<PoolEntry> pool;
+    std::map<GLuint, Hazard> hazards;
+    Stats stats;
+};
+
+#endif // RENDER_GRAPH_HPP
@@ -0,0 +1,37 @@
+#include "includes.hpp"
+#include "resolution.hpp"
+
+ResolutionController::ResolutionController(double targetMs, float initialScale)
+    : targetMs(targetMs), scale(std::min(MAX_SCALE, std::max(MIN_SCALE, initialScale))) {}
+
+bool ResolutionController::update(double gpuMs) {
+    if (targetMs <= 0.0 || gpuMs <= 0.0) {
+        return false;
+    }
+
+    framesSinceChange++;
+    if (framesSinceChange <= SETTLE_FRAMES) {
+        smoothedMs = gpuMs;
+        return false;
+    }
+    smoothedMs = smoothedMs * 0.9 + gpuMs * 0.1;
+
+    float newScale = scale;
+    if (smoothedMs > targetMs) {
+        newScale = std::max(MIN_SCALE, scale - STEP);
+    } else if (scale < MAX_SCALE) {
+        float up = std::min(MAX_SCALE, scale + STEP);
+        double predictedMs = smoothedMs * (up * up) / (scale * scale);
+        // Some headroom so it doesn't bounce between two steps
+        if (predictedMs < targetMs * 0.9) {
+            newScale = up;
+        }
+    }
+
+    if (newScale == scale) {
+        return false;
+    }
+    scale = newScale;
+    framesSinceChange = 0;
+    return true;
+}
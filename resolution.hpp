@@ -0,0 +1,37 @@
+#ifndef RESOLUTION_HPP
+#define RESOLUTION_HPP
+
+#include "includes.hpp"
+#include "profiler.hpp"
+
+// Picks the internal trace resolution (as a fraction of the output size) that keeps the measured
+// GPU frame time under a target. Steps one notch down when over budget and one up when the
+// predicted time at the next step (time grows with the pixel count) still fits.
+class ResolutionController {
+public:
+    static constexpr float MIN_SCALE = 0.25f;
+    static constexpr float MAX_SCALE = 1.0f;
+    static constexpr float STEP = 0.125f;
+    // GPU times arrive LATENCY frames late, ignore the ones still measuring the old resolution
+    static constexpr int SETTLE_FRAMES = Profiler::LATENCY + 4;
+
+    // targetMs <= 0 keeps the initial scale
+    ResolutionController(double targetMs, float initialScale = 1.0f);
+
+    // Feed the last resolved GPU frame time, returns true when the scale changed
+    bool update(double gpuMs);
+
+    float getScale() const { return scale; }
+    bool isEnabled() const { return targetMs > 0.0; }
+
+    // Trace size for an output size at the current scale, never smaller than one workgroup
+    int scaled(int size) const { return std::max(16, static_cast<int>(size * scale + 0.5f)); }
+
+private:
+    double targetMs;
+    float scale;
+    double smoothedMs = 0.0;
+    int framesSinceChange = 0;
+};
+
+#endif // RESOLUTION_HPP
@@ -0,0 +1,34 @@
+#ifndef SAMPLER_HPP
+#define SAMPLER_HPP
+
+#include "includes.hpp"
+
+// Owen-scrambled Sobol sampler, the same numbers as shaders/compute/include/sampler.glsl: each pixel
+// gets its own shuffled and scrambled copy of a 4D Sobol sequence, dimensions past 4 come from
+// independently shuffled groups of four. The dimension layout constants match the shader's.
+struct Sampler {
+    static constexpr uint32_t DIM_CAMERA = 0;
+    static constexpr uint32_t DIM_BOUNCES = 4;
+    static constexpr uint32_t DIM_BOUNCE_LIGHTS = 4;
+    static constexpr uint32_t DIMS_PER_LIGHT = 4;
+
+    // First dimension of a path segment's block (bounceDimension() of the shader)
+    static constexpr uint32_t bounceDimension(uint32_t segment, uint32_t lightSamples) {
+        return DIM_BOUNCES + segment * (DIM_BOUNCE_LIGHTS + DIMS_PER_LIGHT * lightSamples);
+    }
+
+    uint32_t seed = 0;
+    uint32_t index = 0;
+    uint32_t dimension = 0;
+
+    // Start sample sampleIndex of a pixel
+    void begin(uint32_t pixelX, uint32_t pixelY, uint32_t sampleIndex);
+
+    // Coordinate of the current sample in [0, 1)
+    float get(uint32_t dim) const;
+
+    // The next dimension
+    float next() { return get(dimension++); }
+};
+
+#endif // SAMPLER_HPP
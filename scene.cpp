@@ -0,0 +1,238 @@
+#include "includes.hpp"
+#include "scene.hpp"
+#include "json.hpp"
+#include "aliasTable.hpp"
+
+namespace {
+
+glm::vec3 readVec3(const JsonValue& value, const glm::vec3& fallback) {
+    if (!value.isArray() || value.size() != 3) {
+        return fallback;
+    }
+    return glm::vec3(value[0].asNumber(), value[1].asNumber(), value[2].asNumber());
+}
+
+} // namespace
+
+Scene::Scene()
+    : materials(MATERIAL_BINDING), spheres(SPHERE_BINDING), boxes(BOX_BINDING),
+      sphereLights(SPHERE_LIGHT_BINDING), boxLights(BOX_LIGHT_BINDING), lightTable(LIGHT_TABLE_BINDING),
+      instances(INSTANCE_BINDING), tlasNodes(TLAS_NODE_BINDING) {}
+
+/*
+ * Scene file layout:
+ * {
+ *   "materials": [{"name": "red", "emissive": false, "opaqueness": 1, "smoothness": 0, "specularity": 0, "color": [1, 0, 0]}],
+ *   "spheres": [{"position": [0, 1, 0], "radius": 1, "material": "red", "orbit": {"center": [0, 0, 0], "speed": 30}}],
+ *   "boxes": [{"position": [0, 1, 0], "size": [1, 1, 1], "rotation": [0, 45, 0], "material": "red"}],
+ *   "sphereLights": [...], "boxLights": [...],
+ *   "mesh": {"file": "meshes/triangle.obj", "material": "mirror"}
+ * }
+ */
+bool Scene::load(const std::string& filepath) {
+    std::ifstream file(filepath);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open scene file: " << filepath << std::endl;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+
+    JsonValue root;
+    std::string error;
+    if (!JsonValue::parse(buffer.str(), root, error)) {
+        std::cerr << "Error: " << filepath << " " << error << std::endl;
+        return false;
+    }
+
+    std::vector<SceneMaterial> newMaterials;
+    std::map<std::string, uint32_t> materialIndices;
+    for (const JsonValue& entry : root["materials"].getElements()) {
+        SceneMaterial material{};
+        material.type = entry["emissive"].asBool() ? 0 : 1;
+        material.opaqueness = static_cast<float>(entry["opaqueness"].asNumber(1.0));
+        material.smoothness = static_cast<float>(entry["smoothness"].asNumber(0.0));
+        material.specularity = static_cast<float>(entry["specularity"].asNumber(0.0));
+        material.color = readVec3(entry["color"], glm::vec3(1.0f));
+        materialIndices[entry["name"].asString()] = static_cast<uint32_t>(newMaterials.size());
+        newMaterials.push_back(material);
+    }
+
+    bool valid = true;
+    auto findMaterial = [&](const JsonValue& entry) -> uint32_t {
+        auto it = materialIndices.find(entry["material"].asString());
+        if (it == materialIndices.end()) {
+            std::cerr << "Error: Unknown material \"" << entry["material"].asString() << "\" in " << filepath << std::endl;
+            valid = false;
+            return 0;
+        }
+        return it->second;
+    };
+
+    std::vector<Orbit> newOrbits;
+    auto readOrbit = [&](const JsonValue& entry, ObjectKind kind, size_t index, const glm::vec3& position) {
+        if (entry.has("orbit")) {
+            const JsonValue& orbit = entry["orbit"];
+            newOrbits.push_back({kind, index, readVec3(orbit["center"], glm::vec3(0.0f)), position,
+                                 static_cast<float>(orbit["speed"].asNumber(30.0))});
+        }
+    };
+
+    auto readSpheres = [&](const JsonValue& list, ObjectKind kind) {
+        std::vector<SceneSphere> result;
+        for (const JsonValue& entry : list.getElements()) {
+            SceneSphere sphere{};
+            sphere.position = readVec3(entry["position"], glm::vec3(0.0f));
+            sphere.radius = static_cast<float>(entry["radius"].asNumber(1.0));
+            sphere.material = findMaterial(entry);
+            readOrbit(entry, kind, result.size(), sphere.position);
+            result.push_back(sphere);
+        }
+        return result;
+    };
+
+    auto readBoxes = [&](const JsonValue& list, ObjectKind kind) {
+        std::vector<SceneBox> result;
+        for (const JsonValue& entry : list.getElements()) {
+            SceneBox box{};
+            box.position = readVec3(entry["position"], glm::vec3(0.0f));
+            box.size = readVec3(entry["size"], glm::vec3(1.0f));
+            box.rotation = readVec3(entry["rotation"], glm::vec3(0.0f));
+            box.material = findMaterial(entry);
+            readOrbit(entry, kind, result.size(), box.position);
+            result.push_back(box);
+        }
+        return result;
+    };
+
+    std::vector<SceneSphere> newSpheres = readSpheres(root["spheres"], SPHERE);
+    std::vector<SceneBox> newBoxes = readBoxes(root["boxes"], BOX);
+    std::vector<SceneSphere> newSphereLights = readSpheres(root["sphereLights"], SPHERE_LIGHT);
+    std::vector<SceneBox> newBoxLights = readBoxes(root["boxLights"], BOX_LIGHT);
+
+    uint32_t meshMaterial = 0;
+    std::string newMeshPath;
+    if (root.has("mesh")) {
+        newMeshPath = root["mesh"]["file"].asString();
+        meshMaterial = findMaterial(root["mesh"]);
+    }
+
+    if (!valid) {
+        return false;
+    }
+
+    // Only replace the current scene once the whole file was read
+    materials.assign(newMaterials, meshMaterial);
+    spheres.assign(newSpheres);
+    boxes.assign(newBoxes);
+    sphereLights.assign(newSphereLights);
+    boxLights.assign(newBoxLights);
+    orbits = newOrbits;
+    meshPath = newMeshPath;
+    buildLightTable();
+    instancesChanged = true;
+    return true;
+}
+
+// Power of each light as brightness times surface area, the shaders pick lights in proportion to it
+void Scene::buildLightTable() {
+    auto brightness = [&](uint32_t material) {
+        const glm::vec3& color = materials.getItems()[material].color;
+        return static_cast<double>(color.x + color.y + color.z);
+    };
+
+    std::vector<double> powers;
+    for (const SceneSphere& sphere : sphereLights.getItems()) {
+        powers.push_back(brightness(sphere.material) * 4.0 * glm::pi<double>() * sphere.radius * sphere.radius);
+    }
+    for (const SceneBox& box : boxLights.getItems()) {
+        const glm::vec3& s = box.size;  // Half extents
+        powers.push_back(brightness(box.material) * 8.0 * (s.x * s.y + s.y * s.z + s.z * s.x));
+    }
+
+    AliasTable table = buildAliasTable(powers);
+    std::vector<SceneLight> entries(table.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        entries[i] = {table.threshold[i], table.alias[i], table.pdf[i], 0};
+    }
+    lightTable.assign(entries);
+}
+
+void Scene::animate(float time) {
+    for (const Orbit& orbit : orbits) {
+        float angle = glm::radians(orbit.speed * time);
+        glm::vec3 offset = orbit.start - orbit.center;
+        glm::vec3 rotated(offset.x * std::cos(angle) - offset.z * std::sin(angle),
+                          offset.y,
+                          offset.x * std::sin(angle) + offset.z * std::cos(angle));
+        setPosition(orbit.kind, orbit.index, orbit.center + rotated);
+    }
+}
+
+void Scene::setPosition(ObjectKind kind, size_t index, const glm::vec3& position) {
+    instancesChanged = true;
+    switch (kind) {
+        case SPHERE: spheres.edit(index).position = position; break;
+        case BOX: boxes.edit(index).position = position; break;
+        case SPHERE_LIGHT: sphereLights.edit(index).position = position; break;
+        case BOX_LIGHT: boxLights.edit(index).position = position; break;
+    }
+}
+
+void Scene::setRotation(ObjectKind kind, size_t index, const glm::vec3& rotation) {
+    instancesChanged = true;
+    switch (kind) {
+        case BOX: boxes.edit(index).rotation = rotation; break;
+        case BOX_LIGHT: boxLights.edit(index).rotation = rotation; break;
+        default: break;  // Spheres have no rotation
+    }
+}
+
+void Scene::setMeshBounds(const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    hasMesh = true;
+    meshMin = boundsMin;
+    meshMax = boundsMax;
+    instancesChanged = true;
+}
+
+// Every object as an instance of the TLAS, in a fixed order so moving objects only refit it
+void Scene::updateInstances() {
+    std::vector<TLAS::Object> objects;
+    objects.reserve(spheres.getItems().size() + boxes.getItems().size() + sphereLights.getItems().size() + boxLights.getItems().size() + 1);
+    auto addSpheres = [&](const std::vector<SceneSphere>& items, TLAS::Kind kind) {
+        for (const SceneSphere& sphere : items) {
+            objects.push_back({kind, sphere.position, glm::vec3(sphere.radius), glm::vec3(0.0f), sphere.material});
+        }
+    };
+    auto addBoxes = [&](const std::vector<SceneBox>& items, TLAS::Kind kind) {
+        for (const SceneBox& box : items) {
+            objects.push_back({kind, box.position, box.size, box.rotation, box.material});
+        }
+    };
+    addSpheres(spheres.getItems(), TLAS::SPHERE);
+    addBoxes(boxes.getItems(), TLAS::BOX);
+    addSpheres(sphereLights.getItems(), TLAS::SPHERE_LIGHT);
+    addBoxes(boxLights.getItems(), TLAS::BOX_LIGHT);
+    if (hasMesh) {
+        objects.push_back({TLAS::MESH, (meshMin + meshMax) * 0.5f, (meshMax - meshMin) * 0.5f, glm::vec3(0.0f), materials.getExtra()});
+    }
+
+    tlas.update(objects);
+    instances.update(tlas.getInstances());
+    tlasNodes.update(tlas.getNodes());
+}
+
+void Scene::upload() {
+    if (instancesChanged) {
+        updateInstances();
+        instancesChanged = false;
+    }
+    materials.upload();
+    spheres.upload();
+    boxes.upload();
+    sphereLights.upload();
+    boxLights.upload();
+    lightTable.upload();
+    instances.upload();
+    tlasNodes.upload();
+}
@@ -0,0 +1,203 @@
+#ifndef SCENE_HPP
+#define SCENE_HPP
+
+#include "includes.hpp"
+#include "shaderStuff.hpp"
+#include "tlas.hpp"
+
+// GPU side layouts (std430), must match the structs in the compute shaders
+struct SceneMaterial {
+    int32_t type;          // 0 = light, 1 = surface
+    float opaqueness, smoothness, specularity;
+    glm::vec3 color;
+    float padding;
+};
+
+struct SceneSphere {
+    glm::vec3 position;
+    float radius;
+    uint32_t material;     // Index into the material array
+    uint32_t padding[3];
+};
+
+struct SceneBox {
+    glm::vec3 position;
+    uint32_t material;
+    glm::vec3 size;        // Half extents
+    float padding0;
+    glm::vec3 rotation;    // Degrees around x, y, z
+    float padding1;
+};
+
+// Entry of the light alias table (aliasTable.hpp). Entry i is light i: the sphere lights first,
+// then the box lights.
+struct SceneLight {
+    float threshold;       // Keep this light when the random fraction is below, otherwise take the alias
+    uint32_t alias;
+    float pdf;             // Probability of picking this light, proportional to its power
+    uint32_t padding;
+};
+
+static_assert(sizeof(SceneMaterial) == 32, "SceneMaterial must match the std430 layout in the shader");
+static_assert(sizeof(SceneSphere) == 32, "SceneSphere must match the std430 layout in the shader");
+static_assert(sizeof(SceneBox) == 48, "SceneBox must match the std430 layout in the shader");
+static_assert(sizeof(SceneLight) == 16, "SceneLight must match the std430 layout in the shader");
+
+// One SSBO holding a 16 byte header (element count + one extra value) followed by the elements.
+// Edits mark a dirty range that is sent with glBufferSubData, changing the element count reallocates.
+template <typename T>
+class SceneArray {
+public:
+    static constexpr size_t HEADER_SIZE = 16;
+
+    explicit SceneArray(GLuint bindingPoint)
+        : buffer(Buffer::STORAGE_BUFFER, GL_DYNAMIC_DRAW), bindingPoint(bindingPoint) {}
+
+    const std::vector<T>& getItems() const { return items; }
+
+    // Replace everything, forces a full upload
+    void assign(const std::vector<T>& newItems, uint32_t newExtra = 0) {
+        items = newItems;
+        extra = newExtra;
+        reallocate = true;
+    }
+
+    // Replace every element, uploaded in place while the count stays the same
+    void update(const std::vector<T>& newItems) {
+        if (newItems.size() != items.size()) {
+            assign(newItems, extra);
+            return;
+        }
+        items = newItems;
+        dirtyBegin = 0;
+        dirtyEnd = items.size();
+    }
+
+    // Edit one element in place
+    T& edit(size_t index) {
+        dirtyBegin = std::min(dirtyBegin, index);
+        dirtyEnd = std::max(dirtyEnd, index + 1);
+        return items[index];
+    }
+
+    uint32_t getExtra() const { return extra; }
+
+    void upload() {
+        if (reallocate || items.size() != uploadedCount) {
+            if (buffer.getBufferID() == 0) {
+                buffer.generateBuffer();
+            }
+
+            // Always at least one element so the buffer is never empty
+            std::vector<unsigned char> data(HEADER_SIZE + std::max<size_t>(items.size(), 1) * sizeof(T), 0);
+            uint32_t header[2] = { static_cast<uint32_t>(items.size()), extra };
+            std::memcpy(data.data(), header, sizeof(header));
+            if (!items.empty()) {
+                std::memcpy(data.data() + HEADER_SIZE, items.data(), items.size() * sizeof(T));
+            }
+            buffer.uploadData(data.data(), data.size());
+            buffer.setBufferBinding(bindingPoint);
+
+            uploadedCount = items.size();
+            reallocate = false;
+        } else if (dirtyBegin < dirtyEnd) {
+            buffer.uploadSubData(items.data() + dirtyBegin, HEADER_SIZE + dirtyBegin * sizeof(T), (dirtyEnd - dirtyBegin) * sizeof(T));
+        }
+
+        dirtyBegin = std::numeric_limits<size_t>::max();
+        dirtyEnd = 0;
+    }
+
+private:
+    std::vector<T> items;
+    uint32_t extra = 0;
+    Buffer buffer;
+    GLuint bindingPoint;
+
+    size_t uploadedCount = 0;
+    bool reallocate = true;
+    size_t dirtyBegin = std::numeric_limits<size_t>::max();
+    size_t dirtyEnd = 0;
+};
+
+// Scene loaded from a JSON file and kept in SSBOs (materials, spheres, boxes, sphere and box lights)
+// so it can be swapped or animated without recompiling shaders. Rays find objects through a TLAS over
+// all of them (and the mesh), refit on upload whenever something moved.
+class Scene {
+public:
+    // SSBO binding points used by the compute shaders
+    static constexpr GLuint MATERIAL_BINDING = 3;
+    static constexpr GLuint SPHERE_BINDING = 4;
+    static constexpr GLuint BOX_BINDING = 5;
+    static constexpr GLuint SPHERE_LIGHT_BINDING = 6;
+    static constexpr GLuint BOX_LIGHT_BINDING = 7;
+    static constexpr GLuint LIGHT_TABLE_BINDING = 12;
+    static constexpr GLuint INSTANCE_BINDING = 13;
+    static constexpr GLuint TLAS_NODE_BINDING = 14;
+
+    enum ObjectKind { SPHERE, BOX, SPHERE_LIGHT, BOX_LIGHT };
+
+    Scene();
+
+    // Replace the whole scene, the next upload() sends everything
+    bool load(const std::string& filepath);
+
+    // Move objects with an "orbit" in the scene file to their position at the given time
+    void animate(float time);
+
+    // Incremental edits, only the touched elements are uploaded
+    void setPosition(ObjectKind kind, size_t index, const glm::vec3& position);
+    void setRotation(ObjectKind kind, size_t index, const glm::vec3& rotation);
+
+    // World space box of the triangle mesh (its BVH root), which becomes one more instance of the TLAS.
+    // Kept across load().
+    void setMeshBounds(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+    // Send pending changes to the GPU
+    void upload();
+
+    const std::string& getMeshPath() const { return meshPath; }
+
+    // True if anything moves on its own (orbits), temporal history can't assume a static scene then
+    bool isAnimated() const { return !orbits.empty(); }
+
+    const std::vector<SceneMaterial>& getMaterials() const { return materials.getItems(); }
+    const std::vector<SceneSphere>& getSpheres() const { return spheres.getItems(); }
+    const std::vector<SceneBox>& getBoxes() const { return boxes.getItems(); }
+    const std::vector<SceneSphere>& getSphereLights() const { return sphereLights.getItems(); }
+    const std::vector<SceneBox>& getBoxLights() const { return boxLights.getItems(); }
+    uint32_t getMeshMaterial() const { return materials.getExtra(); }
+    const std::vector<SceneLight>& getLightTable() const { return lightTable.getItems(); }
+
+private:
+    SceneArray<SceneMaterial> materials;   // Header extra value: material of the mesh
+    SceneArray<SceneSphere> spheres;
+    SceneArray<SceneBox> boxes;
+    SceneArray<SceneSphere> sphereLights;
+    SceneArray<SceneBox> boxLights;
+    SceneArray<SceneLight> lightTable;     // Picks lights by power, rebuilt on load (moving doesn't change power)
+    SceneArray<SceneInstance> instances;   // In TLAS leaf order
+    SceneArray<BVHNode> tlasNodes;
+
+    TLAS tlas;
+    bool instancesChanged = true;          // Objects were loaded or moved since the last upload
+    bool hasMesh = false;
+    glm::vec3 meshMin = glm::vec3(0.0f), meshMax = glm::vec3(0.0f);
+
+    void buildLightTable();
+    void updateInstances();
+
+    // Object circling around a vertical axis
+    struct Orbit {
+        ObjectKind kind;
+        size_t index;
+        glm::vec3 center;
+        glm::vec3 start;
+        float speed;   // Degrees per second
+    };
+    std::vector<Orbit> orbits;
+
+    std::string meshPath;
+};
+
+#endif // SCENE_HPP
@@ -0,0 +1,189 @@
+#include "includes.hpp"
+#include "sdfBaker.hpp"
+
+namespace {
+
+const float MAX_BOUNDED_SIZE = 100.0f;
+
+Float3 toFloat3(const glm::vec3& v) { return {v.x, v.y, v.z}; }
+
+float length(const Float3& v) { return std::sqrt(dot(v, v)); }
+
+// sdSphere() / sdBox() of rayMarch_shader.glsl, the box in its own rotated frame
+float primitiveDistance(const SdfPrimitive& primitive, const Float3& p) {
+    Float3 local = p - primitive.box.position;
+    if (primitive.kind == SdfPrimitive::SPHERE) {
+        return length(local) - primitive.box.size.x;
+    }
+    local = primitive.box.worldToBox * local;
+    const Float3& b = primitive.box.size;
+    Float3 q = {std::abs(local.x) - b.x, std::abs(local.y) - b.y, std::abs(local.z) - b.z};
+    Float3 outside = {std::max(q.x, 0.0f), std::max(q.y, 0.0f), std::max(q.z, 0.0f)};
+    return length(outside) + std::min(std::max(q.x, std::max(q.y, q.z)), 0.0f);
+}
+
+// World space bounds of the primitive
+void primitiveBounds(const SdfPrimitive& primitive, Float3& lower, Float3& upper) {
+    Float3 extent = primitive.box.size;
+    if (primitive.kind == SdfPrimitive::SPHERE) {
+        extent = {extent.x, extent.x, extent.x};
+    } else {
+        // Rotated half extents: |R| * size
+        const Mat3& r = primitive.box.boxToWorld;
+        const Float3& s = primitive.box.size;
+        extent = {std::abs(r.m[0][0]) * s.x + std::abs(r.m[0][1]) * s.y + std::abs(r.m[0][2]) * s.z,
+                  std::abs(r.m[1][0]) * s.x + std::abs(r.m[1][1]) * s.y + std::abs(r.m[1][2]) * s.z,
+                  std::abs(r.m[2][0]) * s.x + std::abs(r.m[2][1]) * s.y + std::abs(r.m[2][2]) * s.z};
+    }
+    lower = primitive.box.position - extent;
+    upper = primitive.box.position + extent;
+}
+
+} // namespace
+
+std::vector<SdfPrimitive> sdfPrimitivesFromScene(const Scene& scene) {
+    std::vector<SdfPrimitive> primitives;
+    auto addSpheres = [&](const std::vector<SceneSphere>& spheres) {
+        for (const SceneSphere& s : spheres) {
+            Float3 radius = {s.radius, s.radius, s.radius};
+            primitives.push_back({SdfPrimitive::SPHERE, BoxTransform(toFloat3(s.position), radius, {0.0f, 0.0f, 0.0f}), s.material});
+        }
+    };
+    auto addBoxes = [&](const std::vector<SceneBox>& boxes) {
+        for (const SceneBox& b : boxes) {
+            primitives.push_back({SdfPrimitive::BOX, BoxTransform(toFloat3(b.position), toFloat3(b.size), toFloat3(b.rotation)), b.material});
+        }
+    };
+    addSpheres(scene.getSpheres());
+    addBoxes(scene.getBoxes());
+    addSpheres(scene.getSphereLights());
+    addBoxes(scene.getBoxLights());
+    return primitives;
+}
+
+SdfBrickMap bakeSdf(const std::vector<SdfPrimitive>& primitives, int cellsPerAxis, TilePool& pool) {
+    SdfBrickMap map;
+    if (primitives.empty() || cellsPerAxis <= 0) {
+        return map;
+    }
+
+    // The grid covers the primitives of a sensible size; huge ones (a ground sphere) would stretch the
+    // cells too far, they are only baked where they pass through that region. A quarter of the size
+    // is added on every side so they still reach around the rest.
+    Float3 lower = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+    Float3 upper = lower * -1.0f;
+    for (int pass = 0; pass < 2 && lower.x > upper.x; pass++) {
+        for (const SdfPrimitive& primitive : primitives) {
+            Float3 l, u;
+            primitiveBounds(primitive, l, u);
+            Float3 size = u - l;
+            if (pass == 0 && std::max(size.x, std::max(size.y, size.z)) > MAX_BOUNDED_SIZE) {
+                continue;
+            }
+            lower = {std::min(lower.x, l.x), std::min(lower.y, l.y), std::min(lower.z, l.z)};
+            upper = {std::max(upper.x, u.x), std::max(upper.y, u.y), std::max(upper.z, u.z)};
+        }
+    }
+    Float3 extent = upper - lower;
+    float margin = std::max(std::max(extent.x, extent.y), extent.z) * 0.25f;
+    lower = lower - Float3{margin, margin, margin};
+    upper = upper + Float3{margin, margin, margin};
+
+    // One more cell on every side
+    extent = upper - lower;
+    map.cellSize = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-3f)) / static_cast<float>(cellsPerAxis);
+    map.cellsX = static_cast<int>(std::ceil(extent.x / map.cellSize)) + 2;
+    map.cellsY = static_cast<int>(std::ceil(extent.y / map.cellSize)) + 2;
+    map.cellsZ = static_cast<int>(std::ceil(extent.z / map.cellSize)) + 2;
+    map.origin = lower - Float3{map.cellSize, map.cellSize, map.cellSize};
+
+    int cellCount = map.cellsX * map.cellsY * map.cellsZ;
+    map.cellBricks.assign(cellCount, SdfBrickMap::EMPTY_CELL);
+    map.cellDistances.resize(cellCount);
+
+    auto cellMin = [&](int cell) {
+        int x = cell % map.cellsX;
+        int y = (cell / map.cellsX) % map.cellsY;
+        int z = cell / (map.cellsX * map.cellsY);
+        return map.origin + Float3{x * map.cellSize, y * map.cellSize, z * map.cellSize};
+    };
+    float halfDiagonal = map.cellSize * 0.8660254f;
+    Float3 halfCell = {map.cellSize * 0.5f, map.cellSize * 0.5f, map.cellSize * 0.5f};
+
+    const int B = SdfBrickMap::BRICK_SIZE;
+    float spacing = map.cellSize / static_cast<float>(B - 1);
+
+    // Coarse pass, one slab of cells per task: the distance at each center decides whether a surface
+    // can pass through the cell. Cells within a sample spacing of one get a brick too, so the normal
+    // taps around a hit never land in an empty cell.
+    std::vector<uint8_t> hasSurface(cellCount, 0);
+    int slabSize = map.cellsX * map.cellsY;
+    pool.run(map.cellsZ, [&](int z) {
+        for (int cell = z * slabSize; cell < (z + 1) * slabSize; cell++) {
+            Float3 center = cellMin(cell) + halfCell;
+            float distance = std::numeric_limits<float>::max();
+            for (const SdfPrimitive& primitive : primitives) {
+                distance = std::min(distance, primitiveDistance(primitive, center));
+            }
+            map.cellDistances[cell] = distance;
+            hasSurface[cell] = std::abs(distance) <= halfDiagonal + spacing;
+        }
+    });
+
+    std::vector<int> brickCells;
+    for (int cell = 0; cell < cellCount; cell++) {
+        if (hasSurface[cell]) {
+            map.cellBricks[cell] = static_cast<uint32_t>(brickCells.size());
+            brickCells.push_back(cell);
+        }
+    }
+    map.brickCount = static_cast<int>(brickCells.size());
+
+    // Roughly cubic atlas, the 3D texture size limit (2048) allows 256 bricks per axis
+    map.atlasBricksX = std::max(1, static_cast<int>(std::ceil(std::cbrt(static_cast<double>(map.brickCount)))));
+    map.atlasBricksY = map.atlasBricksX;
+    map.atlasBricksZ = std::max(1, (map.brickCount + map.atlasBricksX * map.atlasBricksY - 1) / (map.atlasBricksX * map.atlasBricksY));
+    size_t atlasX = static_cast<size_t>(map.atlasBricksX) * B;
+    size_t atlasY = static_cast<size_t>(map.atlasBricksY) * B;
+    size_t atlasSize = atlasX * atlasY * static_cast<size_t>(map.atlasBricksZ) * B;
+    map.atlasDistances.assign(atlasSize, 0.0f);
+    map.atlasMaterials.assign(atlasSize, 0);
+
+    // Brick pass: only primitives whose distance at the center is within a cell diagonal of the closest
+    // can be the closest anywhere in the cell
+    pool.run(map.brickCount, [&](int brick) {
+        int cell = brickCells[brick];
+        Float3 base = cellMin(cell);
+        Float3 center = base + halfCell;
+        std::vector<const SdfPrimitive*> candidates;
+        for (const SdfPrimitive& primitive : primitives) {
+            if (primitiveDistance(primitive, center) <= map.cellDistances[cell] + 2.0f * halfDiagonal) {
+                candidates.push_back(&primitive);
+            }
+        }
+
+        size_t bx = static_cast<size_t>(brick % map.atlasBricksX) * B;
+        size_t by = static_cast<size_t>((brick / map.atlasBricksX) % map.atlasBricksY) * B;
+        size_t bz = static_cast<size_t>(brick / (map.atlasBricksX * map.atlasBricksY)) * B;
+        for (int k = 0; k < B; k++) {
+            for (int j = 0; j < B; j++) {
+                for (int i = 0; i < B; i++) {
+                    Float3 p = base + Float3{i * spacing, j * spacing, k * spacing};
+                    float distance = std::numeric_limits<float>::max();
+                    uint32_t material = 0;
+                    for (const SdfPrimitive* primitive : candidates) {
+                        float d = primitiveDistance(*primitive, p);
+                        if (d < distance) {
+                            distance = d;
+                            material = primitive->material;
+                        }
+                    }
+                    size_t index = ((bz + k) * atlasY + (by + j)) * atlasX + (bx + i);
+                    map.atlasDistances[index] = distance;
+                    map.atlasMaterials[index] = static_cast<uint16_t>(material);
+                }
+            }
+        }
+    });
+    return map;
+}
@@ -0,0 +1,47 @@
+#ifndef SDF_BAKER_HPP
+#define SDF_BAKER_HPP
+
+#include "includes.hpp"
+#include "intersect.hpp"
+#include "scene.hpp"
+#include "tilePool.hpp"
+
+// One primitive of the baked distance field: a sphere (radius in box.size.x) or a rotated box
+struct SdfPrimitive {
+    enum Kind { SPHERE, BOX };
+    Kind kind;
+    BoxTransform box;
+    uint32_t material;
+};
+
+// The scene's spheres, boxes and lights as distance field primitives
+std::vector<SdfPrimitive> sdfPrimitivesFromScene(const Scene& scene);
+
+// Sparse brick map of a signed distance field. A coarse grid covers the primitives; cells that no
+// surface passes through only keep the distance at their center (a lower bound for every point in
+// them is that minus the distance to the center), the others point to a BRICK_SIZE^3 brick of
+// distance samples spanning the cell corner to corner, packed into a 3D atlas. The nearest
+// primitive's material is stored per sample next to the distance.
+struct SdfBrickMap {
+    static constexpr int BRICK_SIZE = 8;                    // BRICK_SIZE in rayMarch_shader.glsl
+    static constexpr uint32_t EMPTY_CELL = 0xffffffffu;     // EMPTY_CELL
+
+    Float3 origin = {0.0f, 0.0f, 0.0f};    // Minimum corner of the grid
+    float cellSize = 1.0f;
+    int cellsX = 0, cellsY = 0, cellsZ = 0;
+    std::vector<uint32_t> cellBricks;       // Brick of each cell (x fastest), EMPTY_CELL without a surface
+    std::vector<float> cellDistances;       // Distance at each cell's center
+
+    int brickCount = 0;
+    int atlasBricksX = 1, atlasBricksY = 1, atlasBricksZ = 1;   // Atlas size in bricks
+    std::vector<float> atlasDistances;      // BRICK_SIZE * atlasBricks* samples per axis, x fastest
+    std::vector<uint16_t> atlasMaterials;
+};
+
+// Bakes the primitives on the pool's threads, cellsPerAxis cells along the longest side of their bounds
+// (primitives over 100 units across don't count towards them, they are clipped to the grid) plus a
+// quarter of it on every side. Each brick only evaluates the primitives that can be the closest one
+// somewhere in its cell.
+SdfBrickMap bakeSdf(const std::vector<SdfPrimitive>& primitives, int cellsPerAxis, TilePool& pool);
+
+#endif // SDF_BAKER_HPP
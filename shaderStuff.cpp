@@ -1,8 +1,16 @@
 #include "includes.hpp"
+#include "programBinaryCache.hpp"
+
+// Per-variant preprocessor defines (name -> value), injected right after #version
+using ShaderDefines = std::map<std::string, std::string>;
+
+class ProgramBinaryCache;
 
 class Shader {
 public:
-    Shader(const std::map<GLenum, std::string>& shaderPaths);
+    // With a binary cache the linked program is loaded from disk when possible and stored after compiling
+    Shader(const std::map<GLenum, std::string>& shaderPaths, const ShaderDefines& defines = ShaderDefines(),
+           ProgramBinaryCache* binaryCache = nullptr);
     ~Shader();
 
     void use() const;
@@ -12,30 +20,80 @@ public:
     void setMat4(const std::string& name, const glm::mat4& matrix) const;
     void setVec3(const std::string& name, const glm::vec3& value) const;
     void setUInt(const std::string& name, unsigned int value) const;
+    void setFloat(const std::string& name, float value) const;
 
     void setTexture(const std::string& name, GLuint textureID, GLuint unit) const;
     void setImage(const std::string& name, GLuint textureID, GLuint bindingPoint, GLenum format = GL_RGBA8) const;
 
+    // Local work group size of a compute program
+    glm::ivec3 getWorkGroupSize() const;
+
 private:
-    GLuint compileShader(GLenum type, const std::string& source);
-    GLuint createProgram(const std::vector<GLuint>& shaders);
+    GLuint compileShader(GLenum type, const std::string& source, const std::vector<std::string>& sourceFiles);
+    GLuint createProgram(const std::vector<GLuint>& shaders, bool retrievable = false);
 
     GLuint program;
 
+    // Uniform locations looked up once per name instead of on every set call
+    mutable std::unordered_map<std::string, GLint> uniformLocations;
+    GLint getUniformLocation(const std::string& name) const;
+
     // Helper function to load shader source from a file
     std::string loadShaderSource(const std::string& filepath);
+
+    // Resolves #include "file" (relative to the including file, each file at most once) and
+    // injects the defines after #version. sourceFiles receives the #line source string numbers.
+    std::string preprocess(const std::string& filepath, const ShaderDefines& defines, std::vector<std::string>& sourceFiles);
+    bool expandIncludes(const std::string& filepath, std::string& output, std::vector<std::string>& sourceFiles, std::unordered_set<std::string>& included);
 };
 
-Shader::Shader(const std::map<GLenum, std::string>& shaderPaths) {
-    std::vector<GLuint> shaders;
+// Linked programs keyed by (file set, defines), so switching variants at runtime never recompiles
+class ShaderCache {
+public:
+    explicit ShaderCache(ProgramBinaryCache* binaryCache = nullptr) : binaryCache(binaryCache) {}
+
+    std::shared_ptr<Shader> get(const std::map<GLenum, std::string>& shaderPaths, const ShaderDefines& defines = ShaderDefines());
+
+    size_t size() const { return programs.size(); }
+    void clear() { programs.clear(); }
 
+private:
+    std::map<std::string, std::shared_ptr<Shader>> programs;
+    ProgramBinaryCache* binaryCache;
+};
+
+Shader::Shader(const std::map<GLenum, std::string>& shaderPaths, const ShaderDefines& defines,
+               ProgramBinaryCache* binaryCache) {
+    std::vector<std::pair<GLenum, std::string>> sources;
+    std::vector<std::vector<std::string>> sourceFiles;
     for (const auto& [type, path] : shaderPaths) {
-        std::string source = loadShaderSource(path);
-        GLuint shader = compileShader(type, source);
+        sourceFiles.emplace_back();
+        sources.emplace_back(type, preprocess(path, defines, sourceFiles.back()));
+    }
+
+    std::string cacheKey;
+    if (binaryCache && binaryCache->isEnabled()) {
+        cacheKey = binaryCache->makeKey(sources);
+        program = glCreateProgram();
+        if (binaryCache->load(cacheKey, program)) {
+            return;
+        }
+        glDeleteProgram(program);
+    }
+
+    std::vector<GLuint> shaders;
+    for (size_t i = 0; i < sources.size(); i++) {
+        GLuint shader = compileShader(sources[i].first, sources[i].second, sourceFiles[i]);
         shaders.push_back(shader);
     }
 
-    program = createProgram(shaders);
+    program = createProgram(shaders, !cacheKey.empty());
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (linked && !cacheKey.empty()) {
+        binaryCache->store(cacheKey, program);
+    }
 
     // Clean up shaders (they're already attached to the program)
     for (GLuint shader : shaders) {
@@ -51,7 +109,7 @@ void Shader::use() const {
     glUseProgram(program);
 }
 
-GLuint Shader::compileShader(GLenum type, const std::string& source) {
+GLuint Shader::compileShader(GLenum type, const std::string& source, const std::vector<std::string>& sourceFiles) {
     GLuint shader = glCreateShader(type);
     const char* sourceCStr = source.c_str();
     glShaderSource(shader, 1, &sourceCStr, nullptr);
@@ -65,14 +123,22 @@ GLuint Shader::compileShader(GLenum type, const std::string& source) {
         char* log = new char[logLength];
         glGetShaderInfoLog(shader, logLength, &logLength, log);
         std::cerr << "Shader Compilation Failed (" << type << "): " << log << std::endl;
+        // Error locations are "source:line", where source indexes this list
+        for (size_t i = 0; i < sourceFiles.size(); i++) {
+            std::cerr << "  source " << i << ": " << sourceFiles[i] << std::endl;
+        }
         delete[] log;
     }
 
     return shader;
 }
 
-GLuint Shader::createProgram(const std::vector<GLuint>& shaders) {
+GLuint Shader::createProgram(const std::vector<GLuint>& shaders, bool retrievable) {
     GLuint program = glCreateProgram();
+    if (retrievable) {
+        // Lets the driver keep what glGetProgramBinary needs
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
 
     // Attach all shaders
     for (GLuint shader : shaders) {
@@ -95,23 +161,38 @@ GLuint Shader::createProgram(const std::vector<GLuint>& shaders) {
     return program;
 }
 
-void Shader::setMat4(const std::string& name, const glm::mat4& matrix) const {
+GLint Shader::getUniformLocation(const std::string& name) const {
+    auto it = uniformLocations.find(name);
+    if (it != uniformLocations.end()) {
+        return it->second;
+    }
     GLint location = glGetUniformLocation(program, name.c_str());
+    uniformLocations[name] = location;
+    return location;
+}
+
+void Shader::setMat4(const std::string& name, const glm::mat4& matrix) const {
+    GLint location = getUniformLocation(name);
     glUniformMatrix4fv(location, 1, GL_FALSE, &matrix[0][0]);
 }
 
 void Shader::setVec3(const std::string& name, const glm::vec3& value) const {
-    GLint location = glGetUniformLocation(program, name.c_str());
+    GLint location = getUniformLocation(name);
     glUniform3fv(location, 1, &value[0]);
 }
 
 void Shader::setUInt(const std::string& name, unsigned int value) const {
-    GLint location = glGetUniformLocation(program, name.c_str());
+    GLint location = getUniformLocation(name);
     glUniform1ui(location, value);
 }
 
+void Shader::setFloat(const std::string& name, float value) const {
+    GLint location = getUniformLocation(name);
+    glUniform1f(location, value);
+}
+
 void Shader::setTexture(const std::string& name, GLuint textureID, GLuint unit) const {
-    GLint location = glGetUniformLocation(program, name.c_str());
+    GLint location = getUniformLocation(name);
     if (location == -1) {
         std::cerr << "Warning: Texture uniform " << name << " not found in shader!" << std::endl;
         return;
@@ -125,7 +206,7 @@ void Shader::setTexture(const std::string& name, GLuint textureID, GLuint unit)
 
 // New method for binding images to compute shaders
 void Shader::setImage(const std::string& name, GLuint textureID, GLuint bindingPoint, GLenum format) const {
-    GLint location = glGetUniformLocation(program, name.c_str());
+    GLint location = getUniformLocation(name);
     if (location == -1) {
         std::cerr << "Warning: Image uniform " << name << " not found in shader!" << std::endl;
         return;
@@ -147,6 +228,107 @@ std::string Shader::loadShaderSource(const std::string& filepath) {
     return buffer.str();
 }
 
+// Local work group size of a compute program
+glm::ivec3 Shader::getWorkGroupSize() const {
+    GLint size[3] = {1, 1, 1};
+    glGetProgramiv(program, GL_COMPUTE_WORK_GROUP_SIZE, size);
+    return glm::ivec3(size[0], size[1], size[2]);
+}
+
+std::string Shader::preprocess(const std::string& filepath, const ShaderDefines& defines, std::vector<std::string>& sourceFiles) {
+    std::string source;
+    std::unordered_set<std::string> included;
+    sourceFiles.clear();
+    if (!expandIncludes(filepath, source, sourceFiles, included)) {
+        return "";
+    }
+
+    std::string defineBlock;
+    for (const auto& [name, value] : defines) {
+        defineBlock += "#define " + name + " " + value + "\n";
+    }
+    if (defineBlock.empty()) {
+        return source;
+    }
+
+    // #version has to stay the first statement, so the defines go on the line after it
+    size_t versionPos = source.find("#version");
+    if (versionPos == std::string::npos) {
+        return defineBlock + "#line 1 0\n" + source;
+    }
+    size_t lineEnd = source.find('\n', versionPos);
+    if (lineEnd == std::string::npos) {
+        return source + "\n" + defineBlock;
+    }
+    int versionLine = 1 + static_cast<int>(std::count(source.begin(), source.begin() + lineEnd, '\n'));
+    defineBlock += "#line " + std::to_string(versionLine + 1) + " 0\n";
+    return source.insert(lineEnd + 1, defineBlock);
+}
+
+bool Shader::expandIncludes(const std::string& filepath, std::string& output, std::vector<std::string>& sourceFiles, std::unordered_set<std::string>& included) {
+    std::filesystem::path path = std::filesystem::path(filepath).lexically_normal();
+    if (!included.insert(path.string()).second) {
+        return true;  // Already included once
+    }
+
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open shader file: " << path.string() << std::endl;
+        return false;
+    }
+
+    int fileIndex = static_cast<int>(sourceFiles.size());
+    sourceFiles.push_back(path.string());
+    if (fileIndex > 0) {
+        output += "#line 1 " + std::to_string(fileIndex) + "\n";
+    }
+
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(file, line)) {
+        lineNo++;
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line.compare(start, 8, "#include") != 0) {
+            output += line + "\n";
+            continue;
+        }
+
+        size_t open = line.find('"', start);
+        size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+        if (close == std::string::npos) {
+            std::cerr << "Error: Malformed #include in " << path.string() << ":" << lineNo << std::endl;
+            return false;
+        }
+
+        std::filesystem::path includePath = path.parent_path() / line.substr(open + 1, close - open - 1);
+        if (!expandIncludes(includePath.string(), output, sourceFiles, included)) {
+            return false;
+        }
+        output += "#line " + std::to_string(lineNo + 1) + " " + std::to_string(fileIndex) + "\n";
+    }
+    return true;
+}
+
+std::shared_ptr<Shader> ShaderCache::get(const std::map<GLenum, std::string>& shaderPaths, const ShaderDefines& defines) {
+    std::string key;
+    for (const auto& [type, path] : shaderPaths) {
+        key += std::to_string(type) + ":" + path + ";";
+    }
+    key += "|";
+    for (const auto& [name, value] : defines) {
+        key += name + "=" + value + ";";
+    }
+
+    auto it = programs.find(key);
+    if (it != programs.end()) {
+        return it->second;
+    }
+
+    auto shader = std::make_shared<Shader>(shaderPaths, defines, binaryCache);
+    programs[key] = shader;
+    return shader;
+}
+
 class Buffer {
 public:
     enum Type {
@@ -157,61 +339,34 @@ public:
     };
 
     // Constructor for a buffer object
-    Buffer(Type type, GLenum usage = GL_STATIC_DRAW)
-        : type(type), usage(usage), bufferID(0) {}
-
-    // Destructor
-    ~Buffer() {
-        if (bufferID != 0) {
-            glDeleteBuffers(1, &bufferID);
-        }
-    }
+    Buffer(Type type, GLenum usage = GL_STATIC_DRAW);
+    ~Buffer();
 
     // Generate the buffer
-    void generateBuffer() {
-        glGenBuffers(1, &bufferID);
-    }
+    void generateBuffer();
 
     // Bind the buffer to a specific target (e.g., GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, etc.)
-    void bind() const {
-        GLenum target = getBufferTarget();
-        glBindBuffer(target, bufferID);
-    }
+    void bind() const;
 
     // Unbind the buffer
-    void unbind() const {
-        GLenum target = getBufferTarget();
-        glBindBuffer(target, 0);
-    }
+    void unbind() const;
 
     // Upload data to the buffer
-    void uploadData(const void* data, size_t size) {
-        bind();
-        glBufferData(getBufferTarget(), size, data, usage);
-    }
+    void uploadData(const void* data, size_t size);
+
+    // Update part of the buffer in place (the buffer must already be large enough)
+    void uploadSubData(const void* data, size_t offset, size_t size);
 
     // Map the buffer for reading or writing
-    void* mapBuffer(GLenum access = GL_READ_WRITE) {
-        bind();
-        return glMapBuffer(getBufferTarget(), access);
-    }
+    void* mapBuffer(GLenum access = GL_READ_WRITE);
 
     // Unmap the buffer
-    void unmapBuffer() const {
-        glUnmapBuffer(getBufferTarget());
-    }
+    void unmapBuffer() const;
 
     // Set a buffer as an SSBO or UBO (with binding points)
-    void setBufferBinding(GLuint bindingPoint) {
-        bind();
-        if (type == STORAGE_BUFFER) {
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingPoint, bufferID);
-        } else if (type == UNIFORM_BUFFER) {
-            glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, bufferID);
-        }
-    }
+    void setBufferBinding(GLuint bindingPoint);
 
-    GLuint getBufferID() const { return bufferID; }
+    GLuint getBufferID() const;
 
 private:
     GLuint bufferID;    // OpenGL buffer ID
@@ -219,17 +374,83 @@ private:
     GLenum usage;       // Usage hint for the buffer (e.g., GL_STATIC_DRAW, GL_DYNAMIC_DRAW)
 
     // Returns the appropriate OpenGL target based on the buffer type
-    GLenum getBufferTarget() const {
-        switch (type) {
-            case VERTEX_BUFFER: return GL_ARRAY_BUFFER;
-            case ELEMENT_BUFFER: return GL_ELEMENT_ARRAY_BUFFER;
-            case STORAGE_BUFFER: return GL_SHADER_STORAGE_BUFFER;
-            case UNIFORM_BUFFER: return GL_UNIFORM_BUFFER;
-            default: return GL_ARRAY_BUFFER;  // Default to vertex buffer
-        }
-    }
+    GLenum getBufferTarget() const;
 };
 
+// Constructor for a buffer object
+Buffer::Buffer(Type type, GLenum usage)
+    : bufferID(0), type(type), usage(usage) {}
+
+// Destructor
+Buffer::~Buffer() {
+    if (bufferID != 0) {
+        glDeleteBuffers(1, &bufferID);
+    }
+}
+
+// Generate the buffer
+void Buffer::generateBuffer() {
+    glGenBuffers(1, &bufferID);
+}
+
+// Bind the buffer to a specific target (e.g., GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, etc.)
+void Buffer::bind() const {
+    GLenum target = getBufferTarget();
+    glBindBuffer(target, bufferID);
+}
+
+// Unbind the buffer
+void Buffer::unbind() const {
+    GLenum target = getBufferTarget();
+    glBindBuffer(target, 0);
+}
+
+// Upload data to the buffer
+void Buffer::uploadData(const void* data, size_t size) {
+    bind();
+    glBufferData(getBufferTarget(), size, data, usage);
+}
+
+// Update part of the buffer in place (the buffer must already be large enough)
+void Buffer::uploadSubData(const void* data, size_t offset, size_t size) {
+    bind();
+    glBufferSubData(getBufferTarget(), offset, size, data);
+}
+
+// Map the buffer for reading or writing
+void* Buffer::mapBuffer(GLenum access) {
+    bind();
+    return glMapBuffer(getBufferTarget(), access);
+}
+
+// Unmap the buffer
+void Buffer::unmapBuffer() const {
+    glUnmapBuffer(getBufferTarget());
+}
+
+// Set a buffer as an SSBO or UBO (with binding points)
+void Buffer::setBufferBinding(GLuint bindingPoint) {
+    bind();
+    if (type == STORAGE_BUFFER) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingPoint, bufferID);
+    } else if (type == UNIFORM_BUFFER) {
+        glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, bufferID);
+    }
+}
+
+GLuint Buffer::getBufferID() const { return bufferID; }
+
+// Returns the appropriate OpenGL target based on the buffer type
+GLenum Buffer::getBufferTarget() const {
+    switch (type) {
+        case VERTEX_BUFFER: return GL_ARRAY_BUFFER;
+        case ELEMENT_BUFFER: return GL_ELEMENT_ARRAY_BUFFER;
+        case STORAGE_BUFFER: return GL_SHADER_STORAGE_BUFFER;
+        case UNIFORM_BUFFER: return GL_UNIFORM_BUFFER;
+        default: return GL_ARRAY_BUFFER;  // Default to vertex buffer
+    }
+}
+
 // Quad Class
 class Quad {
 public:
@@ -287,6 +508,12 @@ public:
     // Resize the texture (used for recreating it with a different size)
     void resize(int newWidth, int newHeight);
 
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    // Replace the whole image, data in the texture's format and data type (rows from the bottom)
+    void upload(const void* data);
+
     // Bind the texture to a texture unit (slot)
     void bind(GLuint slot = 0) const;
 
@@ -337,6 +564,11 @@ void Texture::resize(int newWidth, int newHeight) {
     setTextureParams();
 }
 
+void Texture::upload(const void* data) {
+    bind();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, dataType, data);
+}
+
 // Bind the texture to a specified texture unit (slot)
 void Texture::bind(GLuint slot) const {
     glActiveTexture(GL_TEXTURE0 + slot);  // Activate the correct texture unit
@@ -365,4 +597,65 @@ void Texture::setTextureParams() const {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); // Linear filtering for magnification
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // Wrap horizontally
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE); // Wrap vertically
-}
\ No newline at end of file
+}
+
+class Framebuffer {
+public:
+    Framebuffer();
+    ~Framebuffer();
+
+    // Attach a texture as a color attachment (index) of the framebuffer
+    void attachTexture(const Texture& texture, GLuint index = 0);
+
+    // Attach a depth texture (GL_DEPTH_COMPONENT* format) for depth testing
+    void attachDepthTexture(const Texture& texture);
+
+    // Bind for rendering, 0 restores the default framebuffer
+    void bind() const;
+    void unbind() const;
+
+    bool isComplete() const;
+
+    GLuint getID() const { return fbo; }
+
+private:
+    GLuint fbo;
+};
+
+Framebuffer::Framebuffer() {
+    glGenFramebuffers(1, &fbo);
+}
+
+Framebuffer::~Framebuffer() {
+    glDeleteFramebuffers(1, &fbo);
+}
+
+// Attach a texture as a color attachment, the draw buffers are updated to cover all attachments so far
+void Framebuffer::attachTexture(const Texture& texture, GLuint index) {
+    bind();
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + index, GL_TEXTURE_2D, texture.getID(), 0);
+
+    std::vector<GLenum> drawBuffers;
+    for (GLuint i = 0; i <= index; i++) {
+        drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + i);
+    }
+    glDrawBuffers(static_cast<GLsizei>(drawBuffers.size()), drawBuffers.data());
+}
+
+void Framebuffer::attachDepthTexture(const Texture& texture) {
+    bind();
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture.getID(), 0);
+}
+
+void Framebuffer::bind() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+}
+
+void Framebuffer::unbind() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+bool Framebuffer::isComplete() const {
+    bind();
+    return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
@@ -1,9 +1,16 @@
 #ifndef SHADER_HPP
 #define SHADER_HPP
 #include "includes.hpp"
+// Per-variant preprocessor defines (name -> value), injected right after #version
+using ShaderDefines = std::map<std::string, std::string>;
+
+class ProgramBinaryCache;
+
 class Shader {
 public:
-    Shader(const std::map<GLenum, std::string>& shaderPaths);
+    // With a binary cache the linked program is loaded from disk when possible and stored after compiling
+    Shader(const std::map<GLenum, std::string>& shaderPaths, const ShaderDefines& defines = ShaderDefines(),
+           ProgramBinaryCache* binaryCache = nullptr);
     ~Shader();
 
     void use() const;
@@ -12,18 +19,46 @@ public:
     void setMat4(const std::string& name, const glm::mat4& matrix) const;
     void setVec3(const std::string& name, const glm::vec3& value) const;
     void setUInt(const std::string& name, unsigned int value) const;
+    void setFloat(const std::string& name, float value) const;
 
     void setTexture(const std::string& name, GLuint textureID, GLuint unit) const;
     void setImage(const std::string& name, GLuint textureID, GLuint bindingPoint, GLenum format = GL_RGBA8) const;
 
+    // Local work group size of a compute program
+    glm::ivec3 getWorkGroupSize() const;
+
 private:
-    GLuint compileShader(GLenum type, const std::string& source);
-    GLuint createProgram(const std::vector<GLuint>& shaders);
+    GLuint compileShader(GLenum type, const std::string& source, const std::vector<std::string>& sourceFiles);
+    GLuint createProgram(const std::vector<GLuint>& shaders, bool retrievable = false);
     
     GLuint program;
 
+    // Uniform locations looked up once per name instead of on every set call
+    mutable std::unordered_map<std::string, GLint> uniformLocations;
+    GLint getUniformLocation(const std::string& name) const;
+
     // Helper function to load shader source from a file
     std::string loadShaderSource(const std::string& filepath);
+
+    // Resolves #include "file" (relative to the including file, each file at most once) and
+    // injects the defines after #version. sourceFiles receives the #line source string numbers.
+    std::string preprocess(const std::string& filepath, const ShaderDefines& defines, std::vector<std::string>& sourceFiles);
+    bool expandIncludes(const std::string& filepath, std::string& output, std::vector<std::string>& sourceFiles, std::unordered_set<std::string>& included);
+};
+
+// Linked programs keyed by (file set, defines), so switching variants at runtime never recompiles
+class ShaderCache {
+public:
+    explicit ShaderCache(ProgramBinaryCache* binaryCache = nullptr) : binaryCache(binaryCache) {}
+
+    std::shared_ptr<Shader> get(const std::map<GLenum, std::string>& shaderPaths, const ShaderDefines& defines = ShaderDefines());
+
+    size_t size() const { return programs.size(); }
+    void clear() { programs.clear(); }
+
+private:
+    std::map<std::string, std::shared_ptr<Shader>> programs;
+    ProgramBinaryCache* binaryCache;
 };
 
 class Buffer {
@@ -51,6 +86,9 @@ public:
     // Upload data to the buffer
     void uploadData(const void* data, size_t size);
 
+    // Update part of the buffer in place (the buffer must already be large enough)
+    void uploadSubData(const void* data, size_t offset, size_t size);
+
     // Map the buffer for reading or writing
     void* mapBuffer(GLenum access = GL_READ_WRITE);
 
@@ -95,6 +133,12 @@ public:
     // Resize the texture (used for recreating it with a different size)
     void resize(int newWidth, int newHeight);
 
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    // Replace the whole image, data in the texture's format and data type (rows from the bottom)
+    void upload(const void* data);
+
     // Bind the texture to a texture unit (slot)
     void bind(GLuint slot = 0) const;
 
@@ -115,4 +159,27 @@ private:
     void setTextureParams() const;
 };
 
+class Framebuffer {
+public:
+    Framebuffer();
+    ~Framebuffer();
+
+    // Attach a texture as a color attachment (index) of the framebuffer
+    void attachTexture(const Texture& texture, GLuint index = 0);
+
+    // Attach a depth texture (GL_DEPTH_COMPONENT* format) for depth testing
+    void attachDepthTexture(const Texture& texture);
+
+    // Bind for rendering, 0 restores the default framebuffer
+    void bind() const;
+    void unbind() const;
+
+    bool isComplete() const;
+
+    GLuint getID() const { return fbo; }
+
+private:
+    GLuint fbo;
+};
+
 #endif // SHADER_HPP
\ No newline at end of file
@@ -0,0 +1,81 @@
+#version 430 core
+
+// Temporal accumulation: blends this frame's path traced color into a reprojected history.
+// The history alpha channel counts the accumulated frames, the blend weight is 1/count, so a
+// still camera converges progressively and a moving one keeps an EMA of about historyLimit frames.
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+#include "include/frame.glsl"
+#include "include/common.glsl"
+
+layout (rgba16f, binding = 0) uniform image2D screenTexture;            // In: this frame's samples, out: accumulated color
+layout (rgba16f, binding = 1) uniform readonly image2D normalTexture;   // This frame's primary hit normals
+layout (r32f, binding = 2) uniform readonly image2D depthTexture;       // This frame's primary hit distances
+layout (rgba32f, binding = 3) uniform readonly image2D historyIn;       // Previous frame's history (rgb color, a frame count)
+layout (rgba32f, binding = 4) uniform writeonly image2D historyOut;
+layout (rgba16f, binding = 5) uniform readonly image2D prevNormalTexture;
+layout (r32f, binding = 6) uniform readonly image2D prevDepthTexture;
+
+const float NORMAL_THRESHOLD = 0.9;     // Minimum cos angle between current and previous normal
+const float DEPTH_THRESHOLD = 0.05;     // Maximum relative distance difference
+
+// Where this pixel's surface point was on screen last frame, -1 if the history can't be used
+ivec2 reproject(ivec2 fragCoord, vec2 texSize, float depth, out float expectedDepth) {
+    vec2 ndc = (fragCoord / texSize) * 2.0 - 1.0;
+    ndc.x *= aspectRatio;
+    vec4 worldSpacePos = invViewProj * vec4(ndc, -1.0, 1.0);
+    vec3 rayDir = normalize(worldSpacePos.xyz / worldSpacePos.w);
+    vec3 hitPoint = cameraPosition + rayDir * depth;
+
+    // Previous view-projection is camera relative like the current one
+    vec3 prevOffset = hitPoint - prevCameraPosition;
+    expectedDepth = length(prevOffset);
+    vec4 prevClip = prevViewProj * vec4(prevOffset, 1.0);
+    if (prevClip.w <= 0.0) {
+        return ivec2(-1);
+    }
+    vec2 prevNdc = prevClip.xy / prevClip.w;
+    prevNdc.x /= aspectRatio;
+    return ivec2(floor((prevNdc * 0.5 + 0.5) * texSize + 0.5));
+}
+
+void main() {
+    ivec2 fragCoord = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(screenTexture);
+    if (any(greaterThanEqual(fragCoord, size))) {
+        return;
+    }
+
+    vec3 color = imageLoad(screenTexture, fragCoord).rgb;
+    float depth = imageLoad(depthTexture, fragCoord).r;
+    vec3 normal = imageLoad(normalTexture, fragCoord).xyz;
+
+    vec4 history = vec4(0.0);
+    if (historyLimit > 1.0) {
+        if (depth >= infinity) {
+            // Background: nothing to reproject, reuse the same pixel if it was background too
+            if (imageLoad(prevDepthTexture, fragCoord).r >= infinity) {
+                history = imageLoad(historyIn, fragCoord);
+            }
+        } else {
+            float expectedDepth;
+            ivec2 prevCoord = reproject(fragCoord, vec2(size), depth, expectedDepth);
+            if (all(greaterThanEqual(prevCoord, ivec2(0))) && all(lessThan(prevCoord, size))) {
+                float prevDepth = imageLoad(prevDepthTexture, prevCoord).r;
+                vec3 prevNormal = imageLoad(prevNormalTexture, prevCoord).xyz;
+                bool sameSurface = abs(prevDepth - expectedDepth) < DEPTH_THRESHOLD * expectedDepth
+                                && dot(prevNormal, normal) > NORMAL_THRESHOLD;
+                if (sameSurface) {
+                    history = imageLoad(historyIn, prevCoord);
+                }
+            }
+        }
+    }
+
+    float count = min(history.a + 1.0, historyLimit);
+    vec3 accumulated = mix(history.rgb, color, 1.0 / count);
+
+    imageStore(historyOut, fragCoord, vec4(accumulated, count));
+    imageStore(screenTexture, fragCoord, vec4(accumulated, 1.0));
+}
@@ -0,0 +1,116 @@
+#version 430 core
+
+// One à-trous wavelet iteration (SVGF style): a 5x5 B-spline kernel with STEP_SIZE pixels between
+// the taps, run with STEP_SIZE 1, 2, 4, ... so a few iterations cover a wide radius. Taps are weighted
+// down across depth and normal discontinuities and where the luminance differs by more than the
+// local noise (the variance), the variance is filtered along with the color for the next iteration.
+
+#ifndef STEP_SIZE
+#define STEP_SIZE 1
+#endif
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout (rgba16f, binding = 0) uniform readonly image2D colorTexture;       // rgb color, a variance
+layout (rgba16f, binding = 1) uniform readonly image2D normalTexture;
+layout (r32f, binding = 2) uniform readonly image2D depthTexture;
+layout (rgba16f, binding = 3) uniform writeonly image2D outputTexture;
+
+// The tile covers the taps of small steps; from 4 on it would be mostly texels no tap reads,
+// so those iterations read the images directly
+#define USE_TILE (STEP_SIZE <= 2)
+
+#if USE_TILE
+#define TILE_RADIUS (2 * STEP_SIZE)
+#include "denoise.glsl"
+#else
+float luminance(vec3 color) {
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+#endif
+
+const float PHI_COLOR = 4.0;        // Luminance difference allowed, in standard deviations
+const float PHI_NORMAL = 128.0;     // Power of the normal cos
+const float PHI_DEPTH = 0.02;       // Relative distance difference allowed per pixel of offset
+
+const float KERNEL[3] = float[3](3.0 / 8.0, 1.0 / 4.0, 1.0 / 16.0);
+
+ivec2 groupOrigin;
+ivec2 imageBounds;
+
+vec4 fetchColor(ivec2 pixel) {
+#if USE_TILE
+    return tileColor[tileIndex(pixel - groupOrigin)];
+#else
+    return imageLoad(colorTexture, clamp(pixel, ivec2(0), imageBounds - 1));
+#endif
+}
+
+vec4 fetchGeometry(ivec2 pixel) {
+#if USE_TILE
+    return tileGeometry[tileIndex(pixel - groupOrigin)];
+#else
+    pixel = clamp(pixel, ivec2(0), imageBounds - 1);
+    return vec4(imageLoad(normalTexture, pixel).xyz, imageLoad(depthTexture, pixel).r);
+#endif
+}
+
+void main() {
+    imageBounds = imageSize(colorTexture);
+    groupOrigin = ivec2(gl_WorkGroupID.xy) * 16;
+#if USE_TILE
+    loadTile(groupOrigin, imageBounds);
+#endif
+
+    ivec2 fragCoord = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(fragCoord, imageBounds))) {
+        return;
+    }
+
+    vec4 center = fetchColor(fragCoord);
+    vec4 geometry = fetchGeometry(fragCoord);
+
+    // Nothing was hit, the background has no noise to remove
+    if (dot(geometry.xyz, geometry.xyz) < 0.5) {
+        imageStore(outputTexture, fragCoord, center);
+        return;
+    }
+
+    // The luminance stop uses a 3x3 blurred variance, a single pixel's estimate is itself noisy
+    float variance = 0.0;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            float k = (x == 0 ? 0.5 : 0.25) * (y == 0 ? 0.5 : 0.25);
+            variance += fetchColor(fragCoord + ivec2(x, y)).a * k;
+        }
+    }
+    float centerLuminance = luminance(center.rgb);
+    float luminanceScale = PHI_COLOR * sqrt(max(variance, 0.0)) + 1e-4;
+
+    vec3 colorSum = vec3(0);
+    float varianceSum = 0.0;
+    float weightSum = 0.0;
+    for (int y = -2; y <= 2; y++) {
+        for (int x = -2; x <= 2; x++) {
+            ivec2 pixel = fragCoord + ivec2(x, y) * STEP_SIZE;
+            if (any(lessThan(pixel, ivec2(0))) || any(greaterThanEqual(pixel, imageBounds))) {
+                continue;
+            }
+            vec4 tapColor = fetchColor(pixel);
+            vec4 tapGeometry = fetchGeometry(pixel);
+
+            // Clamped, box edges can have normals longer than 1
+            float normalWeight = pow(clamp(dot(geometry.xyz, tapGeometry.xyz), 0.0, 1.0), PHI_NORMAL);
+            float depthWeight = exp(-abs(geometry.w - tapGeometry.w) / (PHI_DEPTH * geometry.w * length(vec2(x, y) * STEP_SIZE) + 1e-4));
+            float luminanceWeight = exp(-abs(centerLuminance - luminance(tapColor.rgb)) / luminanceScale);
+
+            float weight = KERNEL[abs(x)] * KERNEL[abs(y)] * normalWeight * depthWeight * luminanceWeight;
+            colorSum += tapColor.rgb * weight;
+            varianceSum += tapColor.a * weight * weight;
+            weightSum += weight;
+        }
+    }
+
+    // The center tap always has a weight of KERNEL[0]^2
+    imageStore(outputTexture, fragCoord, vec4(colorSum / weightSum, varianceSum / (weightSum * weightSum)));
+}
@@ -0,0 +1,30 @@
+// Shared by the denoiser passes. The including shader declares colorTexture, normalTexture and
+// depthTexture and defines TILE_RADIUS, then each workgroup loads its 16x16 pixels plus TILE_RADIUS
+// on every side once into shared memory instead of every thread fetching its whole neighborhood.
+
+#define GROUP_SIZE 16
+#define TILE_SIZE (GROUP_SIZE + 2 * TILE_RADIUS)
+
+shared vec4 tileColor[TILE_SIZE * TILE_SIZE];       // rgb color, a variance
+shared vec4 tileGeometry[TILE_SIZE * TILE_SIZE];    // xyz normal, w primary hit distance
+
+float luminance(vec3 color) {
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+// Every invocation helps, including the ones outside the image, so call it before any early return
+void loadTile(ivec2 groupOrigin, ivec2 size) {
+    ivec2 tileOrigin = groupOrigin - TILE_RADIUS;
+    for (int i = int(gl_LocalInvocationIndex); i < TILE_SIZE * TILE_SIZE; i += GROUP_SIZE * GROUP_SIZE) {
+        ivec2 pixel = clamp(tileOrigin + ivec2(i % TILE_SIZE, i / TILE_SIZE), ivec2(0), size - 1);
+        tileColor[i] = imageLoad(colorTexture, pixel);
+        tileGeometry[i] = vec4(imageLoad(normalTexture, pixel).xyz, imageLoad(depthTexture, pixel).r);
+    }
+    barrier();
+}
+
+// Pixel offset from the workgroup origin to its tile index, must stay within TILE_RADIUS of the group
+int tileIndex(ivec2 local) {
+    ivec2 t = local + TILE_RADIUS;
+    return t.y * TILE_SIZE + t.x;
+}
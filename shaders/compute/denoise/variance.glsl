@@ -0,0 +1,52 @@
+#version 430 core
+
+// First denoiser pass: estimates the luminance variance of every pixel from the 5x5 neighborhood
+// on the same surface and stores it next to the color for the à-trous iterations.
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout (rgba16f, binding = 0) uniform readonly image2D colorTexture;
+layout (rgba16f, binding = 1) uniform readonly image2D normalTexture;
+layout (r32f, binding = 2) uniform readonly image2D depthTexture;
+layout (rgba16f, binding = 3) uniform writeonly image2D outputTexture;     // rgb color, a variance
+
+#define TILE_RADIUS 2
+#include "denoise.glsl"
+
+const float NORMAL_THRESHOLD = 0.9;
+
+void main() {
+    ivec2 size = imageSize(colorTexture);
+    ivec2 groupOrigin = ivec2(gl_WorkGroupID.xy) * GROUP_SIZE;
+    loadTile(groupOrigin, size);
+
+    ivec2 fragCoord = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(fragCoord, size))) {
+        return;
+    }
+
+    ivec2 local = ivec2(gl_LocalInvocationID.xy);
+    vec4 center = tileColor[tileIndex(local)];
+    vec3 normal = tileGeometry[tileIndex(local)].xyz;
+
+    // First and second moments of the luminance over the neighbors facing the same way
+    float sum = 0.0;
+    float sumSquares = 0.0;
+    float count = 0.0;
+    for (int y = -2; y <= 2; y++) {
+        for (int x = -2; x <= 2; x++) {
+            int index = tileIndex(local + ivec2(x, y));
+            if (dot(normal, tileGeometry[index].xyz) < NORMAL_THRESHOLD && dot(normal, normal) > 0.5) {
+                continue;
+            }
+            float l = luminance(tileColor[index].rgb);
+            sum += l;
+            sumSquares += l * l;
+            count += 1.0;
+        }
+    }
+    float mean = sum / count;
+    float variance = max(sumSquares / count - mean * mean, 0.0);
+
+    imageStore(outputTexture, fragCoord, vec4(center.rgb, variance));
+}
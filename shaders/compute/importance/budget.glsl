@@ -0,0 +1,57 @@
+#version 430 core
+
+// Turns the tile importance into per-pixel sample counts: every pixel gets minSamples, the rest of
+// the frame's sample budget is split by each tile's share of the total importance. A per-pixel
+// dither on the fractional part keeps the expected total equal to the budget.
+
+#define IMPORTANCE_TILE 8
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+#include "../include/frame.glsl"
+
+layout (r16f, binding = 0) uniform readonly image2D importanceTexture;
+layout (r8ui, binding = 1) uniform writeonly uimage2D budgetTexture;
+layout (rgba16f, binding = 2) uniform writeonly image2D debugTexture;
+
+layout (std430, binding = 10) buffer ImportanceBuffer {
+    float totalImportance;
+};
+
+uniform uint sampleBudget;      // Samples for the whole frame
+uniform uint minSamples;
+uniform uint maxSamples;
+uniform uint debugView;         // 1: also write the budget as a heat map into debugTexture
+
+float dither(ivec2 pixel) {
+    return fract(sin(dot(vec2(pixel), vec2(12.9898, 78.233)) + float(frameNo % 1024u) * 0.618034) * 43758.5453);
+}
+
+void main() {
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(pixel, ivec2(resolution)))) {
+        return;
+    }
+
+    float pixelCount = float(resolution.x * resolution.y);
+    float extra = max(float(sampleBudget) - pixelCount * float(minSamples), 0.0);
+
+    float share;
+    if (totalImportance > 0.0) {
+        ivec2 tile = pixel / IMPORTANCE_TILE;
+        float importance = imageLoad(importanceTexture, tile).r;
+        // Tiles along the right and bottom edges can be cut off by the image
+        ivec2 tilePixels = min(ivec2(IMPORTANCE_TILE), ivec2(resolution) - tile * IMPORTANCE_TILE);
+        share = extra * importance / (totalImportance * float(tilePixels.x * tilePixels.y));
+    } else {
+        // Nothing needs extra work, spread the budget evenly
+        share = extra / pixelCount;
+    }
+    uint samples = clamp(minSamples + uint(floor(share + dither(pixel))), minSamples, maxSamples);
+    imageStore(budgetTexture, pixel, uvec4(samples));
+
+    if (debugView != 0) {
+        float heat = float(samples) / float(maxSamples);
+        imageStore(debugTexture, pixel, vec4(heat, heat * heat * 0.3, 0.0, 1.0));
+    }
+}
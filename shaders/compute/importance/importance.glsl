@@ -0,0 +1,59 @@
+#version 430 core
+
+// Importance pre-pass: one invocation per IMPORTANCE_TILE x IMPORTANCE_TILE pixel tile traces a few
+// primary rays and measures direct light visibility with sampleLight. Surfaces whose lights are
+// blocked (small couldBeLit) are the ones direct lighting can't approximate, so they get the most
+// importance; fully lit surfaces, lights and background get none.
+
+#ifndef USE_MESH
+#define USE_MESH 1
+#endif
+#ifndef SHADOWS
+#define SHADOWS 1
+#endif
+
+#define IMPORTANCE_TILE 8
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+#include "../include/frame.glsl"
+#include "../include/common.glsl"
+#include "../include/scene.glsl"
+#include "../include/trace.glsl"
+
+layout (r16f, binding = 0) uniform writeonly image2D importanceTexture;   // One texel per tile
+
+void main() {
+    ivec2 tile = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(tile, imageSize(importanceTexture)))) {
+        return;
+    }
+    samplerBegin(uvec2(tile), frameNo);
+
+    // 2x2 rays spread over the tile
+    float importance = 0.0;
+    for (int i = 0; i < 4; i++) {
+        vec2 pixel = (vec2(tile) + (vec2(i % 2, i / 2) + 0.5) * 0.5) * IMPORTANCE_TILE;
+        vec2 ndc = (pixel / vec2(resolution)) * 2.0 - 1.0;
+        ndc.x *= aspectRatio;
+        vec4 worldSpacePos = invViewProj * vec4(ndc, -1.0, 1.0);
+
+        Ray ray;
+        ray.point = cameraPosition;
+        ray.dir = normalize(worldSpacePos.xyz / worldSpacePos.w);
+        vec3 normal = vec3(0);
+        Material material;
+        float distance = rayDist(ray, normal, material).x;
+        if (distance >= infinity || material.type == 0) {
+            continue;
+        }
+
+        vec3 point = ray.point + ray.dir * distance + normal * 0.001;
+        samplerDimension = bounceDimension(uint(i)) + DIM_BOUNCE_LIGHTS;
+        float couldBeLit = sampleLight(point, normal).w;
+        // Same scale as the megakernel's k += int(couldBeLit*0.2)
+        importance += 1.0 / (1.0 + couldBeLit * 0.2);
+    }
+
+    imageStore(importanceTexture, tile, vec4(importance * 0.25));
+}
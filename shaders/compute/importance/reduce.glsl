@@ -0,0 +1,37 @@
+#version 430 core
+
+// Sums the importance of all tiles in a single workgroup (strided loads, then a shared memory tree)
+
+layout(local_size_x = 256) in;
+
+layout (r16f, binding = 0) uniform readonly image2D importanceTexture;
+
+layout (std430, binding = 10) buffer ImportanceBuffer {
+    float totalImportance;
+};
+
+shared float partialSums[256];
+
+void main() {
+    ivec2 size = imageSize(importanceTexture);
+    int tileCount = size.x * size.y;
+    uint thread = gl_LocalInvocationID.x;
+
+    float sum = 0.0;
+    for (int i = int(thread); i < tileCount; i += 256) {
+        sum += imageLoad(importanceTexture, ivec2(i % size.x, i / size.x)).r;
+    }
+    partialSums[thread] = sum;
+    barrier();
+
+    for (uint stride = 128; stride > 0; stride >>= 1) {
+        if (thread < stride) {
+            partialSums[thread] += partialSums[thread + stride];
+        }
+        barrier();
+    }
+
+    if (thread == 0) {
+        totalImportance = partialSums[0];
+    }
+}
@@ -0,0 +1,195 @@
+// Shared types, intersection routines and random numbers for the ray tracing compute shaders
+
+struct Ray {
+    vec3 col;
+    vec3 dir;
+    vec3 point;
+    float dist;
+};
+
+struct Material{
+    int type;
+    float opaqueness, smoothness, specularity;
+    vec3 color;
+};
+
+struct Sphere{
+    float radius;
+    vec3 position;
+    Material material;
+};
+
+struct Box{
+    vec3 position, size, rotation;
+    Material material;
+};
+
+const float aspectRatio = 4/3;
+const float infinity = 99999999.;
+const float PI = 3.14159;
+int checks = 0;
+
+mat4 rotateY(float rotation){
+    rotation = radians(rotation);
+	float ys = sin(rotation);
+	float yc = cos(rotation);
+	float yoc = 1.0-yc;
+	return mat4(yc,0.0,ys,0.0,
+				0.0,yoc+yc,0.0,0.0,
+				-ys,0.0,yc,0.0,
+				0.0,0.0,0.0,1.0);
+}
+
+mat4 rotateX(float rotation){
+    rotation = radians(rotation);
+	float xs = sin(rotation);
+	float xc = cos(rotation);
+	float xoc = 1.0-xc;
+	return mat4(xoc+xc,0.0,0.0,0.0,
+			    0.0,xc,-xs,0.0,
+				0.0,xs,xc,0.0,
+				0.0,0.0,0.0,1.0);
+}
+
+mat4 rotateZ(float rotation){
+    rotation = radians(rotation);
+    float zs = sin(rotation);
+    float zc = cos(rotation);
+    float zoc = 1.0-zc;
+	return mat4(zc,zs,0.0,0.0,
+			    -zs,zc,0.0,0.0,
+				0.0,0.0,zoc+zc,0.0,
+				0.0,0.0,0.0,1.0);
+}
+
+/*
+ * intersection functions
+ * https://iquilezles.org/articles/intersectors
+ */
+ 
+vec4 boxHit(Ray ray,Box box) {
+    mat4 translate = mat4(1.0,0.0,0.0,0.0,
+                          0.0,1.0,0.0,0.0,
+                          0.0,0.0,1.0,0.0,
+                          box.position,1.0)*rotateX(box.rotation.x)*rotateY(box.rotation.y)*rotateZ(box.rotation.z);
+
+    vec3 q = (inverse(translate)*vec4(ray.point,1.0)).xyz;
+    vec3 m = 1.0/(inverse(translate)*vec4(ray.dir,0.0)).xyz; 
+    vec3 n = m*q;  
+    vec3 k = abs(m)*box.size;
+    vec3 t1 = -n-k;
+    vec3 t2 = -n+k;
+    float tn = max(max(t1.x,t1.y),t1.z);
+    float tf = min(min(t2.x,t2.y),t2.z);
+    if(tn>tf||tf<0.0) return vec4(-1.0); //ray missed
+
+    //vec3 normal = sign(q)*step(t1.yzx,t1.xyz)*step(t1.zxy,t1.xyz);
+
+    vec3 normal = (tn>0.0) ? step(vec3(tn),t1) : // ro ouside the box
+                           step(t2,vec3(tf));  // ro inside the box
+    normal *= -sign(m);
+
+        mat3 inverseRotation = inverse(transpose(mat3(rotateX(box.rotation.x) * rotateY(box.rotation.y) * rotateZ(box.rotation.z))));
+    normal = inverseRotation * normal;
+
+    return vec4(normal,(tn>0.0) ?tn:tf);
+}
+
+vec2 sphereHit(Ray Ray,Sphere sphere){
+    // Vector from the ray origin to the sphere's center
+    vec3 rc = Ray.point - sphere.position;
+
+    // Compute the coefficients of the quadratic equation
+    float b = dot(rc, Ray.dir);
+    float c = dot(rc, rc) - pow(sphere.radius, 2.0);
+
+    // Discriminant of the quadratic equation (b^2 - c)
+    float t = pow(b, 2.0) - c;
+
+    // If discriminant is positive, there are intersections
+    if (t > 0.0) {
+        // Calculate the two possible intersection distances (t1 and t2)
+        float t1 = -b - sqrt(t);  // First intersection point
+        float t2 = -b + sqrt(t);  // Second intersection point
+
+        // If t1 is negative, the ray starts inside the sphere and t1 is the exit point
+        // t2 is the entry point into the sphere
+        if (t1 < 0.0) {
+            return vec2(t2,-1.0);  // The ray is inside the sphere, t2 is the entry point
+        }
+
+        // If t1 is positive, return the nearest intersection in front of the ray
+        return vec2(t1,1.0);  // Otherwise, t1 is the entry point into the sphere
+    }
+
+    // If no intersection, return a large negative value or other indication of no hit
+    return vec2(-1.0,0);
+}
+
+vec3 triangleHit(Ray Ray, in vec3 v0, in vec3 v1, in vec3 v2, out vec3 n )
+{
+    vec3 v1v0 = v1 - v0;
+    vec3 v2v0 = v2 - v0;
+    vec3 rov0 = Ray.point - v0;
+    n = cross( v1v0, v2v0 );
+    vec3  q = cross( rov0, Ray.dir );
+    float d = 1.0/dot( Ray.dir, n );
+    float u = d*dot( -q, v2v0 );
+    float v = d*dot(  q, v1v0 );
+    float t = d*dot( -n, rov0 );
+    if(min(u, min(v, (1-(u+v)))) < 0.0) t = -1.0;
+    //t=min(u, min(v, (1-(u+v)))) * t;
+    n = normalize(n);
+    return vec3( t, u, v );
+}
+
+// Ray/AABB slab test, returns the entry distance or infinity on a miss (or if further than tMax)
+float aabbHit(vec3 origin, vec3 invDir, vec3 boundsMin, vec3 boundsMax, float tMax) {
+    vec3 t0 = (boundsMin - origin) * invDir;
+    vec3 t1 = (boundsMax - origin) * invDir;
+    vec3 tSmall = min(t0, t1);
+    vec3 tBig = max(t0, t1);
+    float tn = max(max(tSmall.x, tSmall.y), max(tSmall.z, 0.0));
+    float tf = min(min(tBig.x, tBig.y), min(tBig.z, tMax));
+    return tn <= tf ? tn : infinity;
+}
+
+// Octahedral normal encoding, a unit vector in two values in [-1, 1] (the G-buffer's RG16 snorm normal)
+vec2 octEncode(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * signs;
+}
+
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float fold = max(-n.z, 0.0);
+    n.xy -= vec2(n.x >= 0.0 ? fold : -fold, n.y >= 0.0 ? fold : -fold);
+    return normalize(n);
+}
+
+#include "sampler.glsl"
+
+vec3 cosWeightedRandomHemisphereDirection( const vec3 n) {
+  	vec2 r = hash2();
+    
+	vec3  uu = cross( n, vec3(0.0,1.0,1.0) );
+	// n along (0, 1, 1) itself (exact box normals can be), any other axis gives the tangent
+	if (dot(uu, uu) < 1e-6) uu = cross( n, vec3(1.0,0.0,0.0) );
+	uu = normalize( uu );
+	vec3  vv = cross( uu, n );
+	
+	float ra = sqrt(r.y);
+	float rx = ra*cos(6.2831*r.x); 
+	float ry = ra*sin(6.2831*r.x);
+	float rz = sqrt( 1.0-r.y );
+	vec3  rr = vec3( rx*uu + ry*vv + rz*n );
+    
+    return normalize( rr );
+}
+
+vec3 randomSphereDirection() {
+    vec2 r = hash2()*6.2831;
+	vec3 dr=vec3(sin(r.x)*vec2(sin(r.y),cos(r.y)),cos(r.x));
+	return dr;
+}
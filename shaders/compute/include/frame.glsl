@@ -0,0 +1,12 @@
+// Per-frame constants, written once per frame into a ring buffer slot (see FrameUniformRing)
+layout(std140, binding = 0) uniform FrameUniforms {
+    mat4 invViewProj;       // Clip space to world space directions (view matrix without translation)
+    mat4 prevViewProj;      // Last frame's camera relative view-projection, for reprojection
+    vec3 cameraPosition;
+    uint frameNo;
+    vec3 prevCameraPosition;
+    float historyLimit;     // Max frames in the temporal history, 1 discards it
+    uint samplesPerPixel;   // Runtime counts, capped by RAY_SAMPLES / RAY_BOUNCES
+    uint maxBounces;
+    uvec2 resolution;       // Size of the traced image
+};
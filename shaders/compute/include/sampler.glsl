@@ -0,0 +1,136 @@
+// Random numbers for the path tracers: Owen-scrambled Sobol points (Burley 2020, "Practical Hash-based
+// Owen Scrambling") instead of a hash per call. Every pixel walks its own shuffled and scrambled copy of
+// the sequence, so its samples stay stratified while neighbouring pixels stay uncorrelated.
+// The first four dimensions are 4D Sobol points; later ones reuse them in groups of four, each group
+// with its own index shuffle and scramble. A path reads fixed dimensions (see the layout below) so
+// the same decision always gets the same coordinate of the sequence.
+
+#ifndef LIGHT_SAMPLES
+#define LIGHT_SAMPLES 2  // Lights picked per shading point
+#endif
+
+// Dimension layout of one sample: the camera jitter, then one block per path segment holding the
+// specular and transparency choices, the bounce direction and LIGHT_SAMPLES light samples
+// (position, then which light). Blocks are multiples of four so pairs never straddle a group.
+const uint DIM_CAMERA = 0u;
+const uint DIM_BOUNCES = 4u;
+const uint DIM_BOUNCE_LIGHTS = 4u;      // Offset of the light samples in a segment block
+const uint DIMS_PER_LIGHT = 4u;
+const uint DIMS_PER_BOUNCE = DIM_BOUNCE_LIGHTS + DIMS_PER_LIGHT * uint(LIGHT_SAMPLES);
+
+uint bounceDimension(uint segment) {
+    return DIM_BOUNCES + segment * DIMS_PER_BOUNCE;
+}
+
+// Joe-Kuo direction numbers of the first four Sobol dimensions, 32 bits each
+const uint SOBOL_DIRECTIONS[128] = uint[128](
+    0x80000000u, 0x40000000u, 0x20000000u, 0x10000000u, 0x08000000u, 0x04000000u, 0x02000000u, 0x01000000u,
+    0x00800000u, 0x00400000u, 0x00200000u, 0x00100000u, 0x00080000u, 0x00040000u, 0x00020000u, 0x00010000u,
+    0x00008000u, 0x00004000u, 0x00002000u, 0x00001000u, 0x00000800u, 0x00000400u, 0x00000200u, 0x00000100u,
+    0x00000080u, 0x00000040u, 0x00000020u, 0x00000010u, 0x00000008u, 0x00000004u, 0x00000002u, 0x00000001u,
+    0x80000000u, 0xc0000000u, 0xa0000000u, 0xf0000000u, 0x88000000u, 0xcc000000u, 0xaa000000u, 0xff000000u,
+    0x80800000u, 0xc0c00000u, 0xa0a00000u, 0xf0f00000u, 0x88880000u, 0xcccc0000u, 0xaaaa0000u, 0xffff0000u,
+    0x80008000u, 0xc000c000u, 0xa000a000u, 0xf000f000u, 0x88008800u, 0xcc00cc00u, 0xaa00aa00u, 0xff00ff00u,
+    0x80808080u, 0xc0c0c0c0u, 0xa0a0a0a0u, 0xf0f0f0f0u, 0x88888888u, 0xccccccccu, 0xaaaaaaaau, 0xffffffffu,
+    0x80000000u, 0xc0000000u, 0x60000000u, 0x90000000u, 0xe8000000u, 0x5c000000u, 0x8e000000u, 0xc5000000u,
+    0x68800000u, 0x9cc00000u, 0xee600000u, 0x55900000u, 0x80680000u, 0xc09c0000u, 0x60ee0000u, 0x90550000u,
+    0xe8808000u, 0x5cc0c000u, 0x8e606000u, 0xc5909000u, 0x6868e800u, 0x9c9c5c00u, 0xeeee8e00u, 0x5555c500u,
+    0x8000e880u, 0xc0005cc0u, 0x60008e60u, 0x9000c590u, 0xe8006868u, 0x5c009c9cu, 0x8e00eeeeu, 0xc5005555u,
+    0x80000000u, 0xc0000000u, 0x20000000u, 0x50000000u, 0xf8000000u, 0x74000000u, 0xa2000000u, 0x93000000u,
+    0xd8800000u, 0x25400000u, 0x59e00000u, 0xe6d00000u, 0x78080000u, 0xb40c0000u, 0x82020000u, 0xc3050000u,
+    0x208f8000u, 0x51474000u, 0xfbea2000u, 0x75d93000u, 0xa0858800u, 0x914e5400u, 0xdbe79e00u, 0x25db6d00u,
+    0x58800080u, 0xe54000c0u, 0x79e00020u, 0xb6d00050u, 0x800800f8u, 0xc00c0074u, 0x200200a2u, 0x50050093u
+);
+
+uint samplerSeed = 0u;
+uint samplerIndex = 0u;
+uint samplerDimension = 0u;
+
+uint hashUint(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+uint hashCombine(uint seed, uint value) {
+    return seed ^ (value + 0x9e3779b9u + (seed << 6) + (seed >> 2));
+}
+
+uint laineKarrasPermutation(uint x, uint seed) {
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
+}
+
+// Owen scramble: flipping a bit depends only on the bits above it
+uint nestedUniformScramble(uint x, uint seed) {
+    return bitfieldReverse(laineKarrasPermutation(bitfieldReverse(x), seed));
+}
+
+// Sums the direction numbers of the index's set bits. Dimension 0 is the bit reversal of the index.
+uint sobol(uint index, uint dimension) {
+    if (dimension == 0u) {
+        return bitfieldReverse(index);
+    }
+    uint result = 0u;
+    for (; index != 0u; index &= index - 1u) {
+        result ^= SOBOL_DIRECTIONS[dimension * 32u + uint(findLSB(index))];
+    }
+    return result;
+}
+
+// Seed of a group of four dimensions and the pixel's shuffled sample index in it
+uint samplerGroup(uint group, out uint index) {
+    uint groupSeed = hashCombine(samplerSeed, hashUint(group));
+    index = nestedUniformScramble(samplerIndex, groupSeed);
+    return groupSeed;
+}
+
+float samplerScrambled(uint index, uint groupSeed, uint dimension) {
+    uint value = nestedUniformScramble(sobol(index, dimension), hashCombine(groupSeed, dimension));
+    return float(value >> 8) * (1.0 / 16777216.0);
+}
+
+// Coordinate of the current sample in [0, 1)
+float samplerGet(uint dimension) {
+    uint index;
+    uint groupSeed = samplerGroup(dimension / 4u, index);
+    return samplerScrambled(index, groupSeed, dimension % 4u);
+}
+
+// Start sample sampleIndex of a pixel (or tile). The index has to grow across frames for the
+// samples of one pixel to fill the sequence.
+void samplerBegin(uvec2 pixel, uint sampleIndex) {
+    samplerSeed = hashUint(pixel.x ^ hashUint(pixel.y));
+    samplerIndex = sampleIndex;
+    samplerDimension = DIM_CAMERA;
+}
+
+// The next dimensions of the current sample
+float hash1() {
+    return samplerGet(samplerDimension++);
+}
+
+// Pairs and triples never straddle a group of four in the layout, so they shuffle the index once
+vec2 hash2() {
+    uint index;
+    uint groupSeed = samplerGroup(samplerDimension / 4u, index);
+    uint dimension = samplerDimension % 4u;
+    samplerDimension += 2u;
+    return vec2(samplerScrambled(index, groupSeed, dimension), samplerScrambled(index, groupSeed, dimension + 1u));
+}
+
+vec3 hash3() {
+    uint index;
+    uint groupSeed = samplerGroup(samplerDimension / 4u, index);
+    uint dimension = samplerDimension % 4u;
+    samplerDimension += 3u;
+    return vec3(samplerScrambled(index, groupSeed, dimension), samplerScrambled(index, groupSeed, dimension + 1u),
+                samplerScrambled(index, groupSeed, dimension + 2u));
+}
@@ -0,0 +1,254 @@
+// Scene and mesh buffers shared by the ray tracing compute shaders, needs common.glsl
+
+#include "stats.glsl"
+
+// Scene data, filled from a scene file by the Scene class (scene.cpp)
+// Each buffer starts with its element count, padded to 16 bytes
+
+// GPU side sphere and box, materials are referenced by index
+struct SphereData{
+    vec3 position;
+    float radius;
+    uint material;
+};
+
+struct BoxData{
+    vec3 position;
+    uint material;
+    vec3 size, rotation;
+};
+
+layout (std430, binding = 3) buffer MaterialBuffer {
+    uint materialCount;
+    uint meshMaterial;  // Material of the triangle mesh
+    Material materials[];
+};
+
+layout (std430, binding = 4) buffer SphereBuffer {
+    uint ballCount;
+    SphereData balls[];
+};
+
+layout (std430, binding = 5) buffer BoxBuffer {
+    uint boxCount;
+    BoxData boxes[];
+};
+
+layout (std430, binding = 6) buffer SphereLightBuffer {
+    uint sphereLightCount;
+    SphereData sphereLightSources[];
+};
+
+layout (std430, binding = 7) buffer BoxLightBuffer {
+    uint boxLightCount;
+    BoxData boxLightSources[];
+};
+
+// Alias table over all lights (sphere lights first, then box lights), weighted by power (scene.cpp)
+struct LightEntry {
+    float threshold;
+    uint alias;
+    float pdf;
+    uint padding;
+};
+
+layout (std430, binding = 12) buffer LightTableBuffer {
+    uint lightCount;
+    uint lightCountPadding[3];  // LightEntry only aligns to 4 bytes, the entries start after the 16 byte header
+    LightEntry lightTable[];
+};
+
+// Light index for u in [0, 1), picked in proportion to its power, with the probability of picking it
+uint pickLight(float u, out float pdf) {
+    float scaled = u * float(lightCount);
+    uint index = min(uint(scaled), lightCount - 1u);
+    if (scaled - float(index) >= lightTable[index].threshold) {
+        index = lightTable[index].alias;
+    }
+    pdf = lightTable[index].pdf;
+    return index;
+}
+
+// Flattened BVH (depth first, left child is the next node), built on the CPU in bvh.cpp. The mesh
+// BVH's leaves hold triangles, the TLAS's leaves instances.
+struct BVHNode {
+    vec3 boundsMin;
+    uint leftOrFirst;    // Interior: right child index, leaf: first triangle or instance
+    vec3 boundsMax;
+    uint triangleCount;  // Triangles or instances of a leaf, 0 for interior nodes
+};
+
+const int BVH_STACK_SIZE = 64;
+
+// Instance of the TLAS (tlas.cpp): every object of the scene in the object space of the shape all
+// instances of its kind share, the unit sphere, the [-1, 1] cube or the mesh BVH.
+struct InstanceData {
+    vec4 worldToObject[3];  // Rows of the affine transform
+    vec3 boundsMin;         // World space box
+    uint kind;
+    vec3 boundsMax;
+    uint material;
+};
+
+const uint INSTANCE_SPHERE = 0u;        // TLAS::Kind
+const uint INSTANCE_BOX = 1u;
+const uint INSTANCE_SPHERE_LIGHT = 2u;
+const uint INSTANCE_BOX_LIGHT = 3u;
+const uint INSTANCE_MESH = 4u;
+
+layout (std430, binding = 13) buffer InstanceBuffer {
+    uint instanceCount;
+    InstanceData instances[];   // In leaf order
+};
+
+layout (std430, binding = 14) buffer TLASBuffer {
+    uint tlasNodeCount;
+    BVHNode tlasNodes[];
+};
+
+Sphere getSphere(SphereData data){
+    return Sphere(data.radius, data.position, materials[data.material]);
+}
+
+Box getBox(BoxData data){
+    return Box(data.position, data.size, data.rotation, materials[data.material]);
+}
+
+// Uniformly distributed point on the surface of the box for three uniform numbers: a face in
+// proportion to its area (the rest of r.x picks the side), then a point on it
+vec3 boxSurfacePoint(Box box, vec3 r) {
+    vec3 s = box.size;  // Half extents
+    vec3 faceAreas = vec3(s.y * s.z, s.x * s.z, s.x * s.y);
+    float totalArea = faceAreas.x + faceAreas.y + faceAreas.z;
+    if (totalArea <= 0.0) {
+        return box.position;
+    }
+
+    float pick = r.x * totalArea;
+    vec2 uv = r.yz * 2.0 - 1.0;
+    vec3 local;
+    if (pick < faceAreas.x) {
+        local = vec3(pick / faceAreas.x < 0.5 ? -s.x : s.x, uv.x * s.y, uv.y * s.z);
+    } else if (pick < faceAreas.x + faceAreas.y) {
+        local = vec3(uv.x * s.x, (pick - faceAreas.x) / faceAreas.y < 0.5 ? -s.y : s.y, uv.y * s.z);
+    } else {
+        local = vec3(uv.x * s.x, uv.y * s.y, (pick - faceAreas.x - faceAreas.y) / faceAreas.z < 0.5 ? -s.z : s.z);
+    }
+    // Same transform as boxHit
+    return box.position + mat3(rotateX(box.rotation.x) * rotateY(box.rotation.y) * rotateZ(box.rotation.z)) * local;
+}
+
+#if USE_MESH
+
+layout (std430, binding = 0) buffer VertexData {
+    vec4 vertices[];  // Array of vertices (w unused, vec3 arrays are padded to 16 bytes in std430 anyway)
+};
+
+layout (std430, binding = 1) buffer IndexData {
+    uint indices[];  // Array of indices, 3 per triangle, ordered by BVH leaf
+};
+
+layout (std430, binding = 2) buffer BVHData {
+    BVHNode nodes[];
+};
+
+// Closest triangle of the mesh closer than tMax, walks the BVH nearest child first
+float meshHit(Ray ray, float tMax, out vec3 normal) {
+    float dist = tMax;
+    if (nodes.length() == 0) return -1.0;
+
+    vec3 invDir = 1.0 / ray.dir;
+    STAT_ADD(STAT_NODE_TESTS, 1);
+    if (aabbHit(ray.point, invDir, nodes[0].boundsMin, nodes[0].boundsMax, dist) >= infinity) return -1.0;
+
+    uint stack[BVH_STACK_SIZE];
+    int stackSize = 0;
+    uint nodeIndex = 0;
+    while (true) {
+        BVHNode node = nodes[nodeIndex];
+        if (node.triangleCount > 0) {
+            STAT_ADD(STAT_TRIANGLE_TESTS, node.triangleCount);
+            for (uint i = node.leftOrFirst; i < node.leftOrFirst + node.triangleCount; i++) {
+                vec3 norm;
+                vec3 hitResult = triangleHit(ray, vertices[indices[i * 3]].xyz, vertices[indices[i * 3 + 1]].xyz, vertices[indices[i * 3 + 2]].xyz, norm);
+                if (hitResult.x > 0.0 && hitResult.x < dist) {
+                    dist = hitResult.x;
+                    normal = norm;
+                }
+            }
+            if (stackSize == 0) break;
+            nodeIndex = stack[--stackSize];
+            continue;
+        }
+
+        // Visit the nearer child first, keep the other one for later
+        STAT_ADD(STAT_NODE_TESTS, 2);
+        uint nearChild = nodeIndex + 1;
+        uint farChild = node.leftOrFirst;
+        float nearDist = aabbHit(ray.point, invDir, nodes[nearChild].boundsMin, nodes[nearChild].boundsMax, dist);
+        float farDist = aabbHit(ray.point, invDir, nodes[farChild].boundsMin, nodes[farChild].boundsMax, dist);
+        if (nearDist > farDist) {
+            uint swapChild = nearChild; nearChild = farChild; farChild = swapChild;
+            float swapDist = nearDist; nearDist = farDist; farDist = swapDist;
+        }
+
+        if (nearDist >= infinity) {
+            if (stackSize == 0) break;
+            nodeIndex = stack[--stackSize];
+            continue;
+        }
+        nodeIndex = nearChild;
+        if (farDist < infinity && stackSize < BVH_STACK_SIZE) {
+            stack[stackSize++] = farChild;
+        }
+    }
+
+    return dist < tMax ? dist : -1.0;
+}
+
+// Any triangle closer than tMax, for shadow rays. Returns on the first one found, so children are
+// not sorted by distance: both are only culled against tMax and the left one is visited first.
+bool meshOccluded(Ray ray, float tMax) {
+    if (nodes.length() == 0) return false;
+
+    vec3 invDir = 1.0 / ray.dir;
+    STAT_ADD(STAT_NODE_TESTS, 1);
+    if (aabbHit(ray.point, invDir, nodes[0].boundsMin, nodes[0].boundsMax, tMax) >= infinity) return false;
+
+    uint stack[BVH_STACK_SIZE];
+    int stackSize = 0;
+    uint nodeIndex = 0;
+    while (true) {
+        BVHNode node = nodes[nodeIndex];
+        if (node.triangleCount > 0) {
+            for (uint i = node.leftOrFirst; i < node.leftOrFirst + node.triangleCount; i++) {
+                STAT_ADD(STAT_TRIANGLE_TESTS, 1);
+                vec3 norm;
+                float t = triangleHit(ray, vertices[indices[i * 3]].xyz, vertices[indices[i * 3 + 1]].xyz, vertices[indices[i * 3 + 2]].xyz, norm).x;
+                if (t > 0.0 && t < tMax) return true;
+            }
+        } else {
+            STAT_ADD(STAT_NODE_TESTS, 2);
+            uint leftChild = nodeIndex + 1;
+            uint rightChild = node.leftOrFirst;
+            bool hitLeft = aabbHit(ray.point, invDir, nodes[leftChild].boundsMin, nodes[leftChild].boundsMax, tMax) < infinity;
+            bool hitRight = aabbHit(ray.point, invDir, nodes[rightChild].boundsMin, nodes[rightChild].boundsMax, tMax) < infinity;
+            if (hitLeft) {
+                if (hitRight && stackSize < BVH_STACK_SIZE) {
+                    stack[stackSize++] = rightChild;
+                }
+                nodeIndex = leftChild;
+                continue;
+            }
+            if (hitRight) {
+                nodeIndex = rightChild;
+                continue;
+            }
+        }
+        if (stackSize == 0) break;
+        nodeIndex = stack[--stackSize];
+    }
+    return false;
+}
+
+#endif
@@ -0,0 +1,79 @@
+// Ray statistics for the megakernel (RAY_STATS 1, otherwise everything here compiles to nothing).
+// Each invocation counts into local variables, statsEnd() sums them per work group in shared memory
+// and adds the group totals to RayStatsBuffer with one atomic per counter (read back by rayStats.cpp).
+// Shaders using it call statsBegin() and statsEnd() from uniform control flow: both have barriers.
+#ifndef RAY_STATS
+#define RAY_STATS 0
+#endif
+
+#if RAY_STATS
+
+// Counter indices, keep in sync with RayStats (rayStats.hpp)
+const int STAT_PRIMARY_RAYS = 0;
+const int STAT_SECONDARY_RAYS = 1;
+const int STAT_SHADOW_RAYS = 2;
+const int STAT_SPHERE_TESTS = 3;
+const int STAT_BOX_TESTS = 4;
+const int STAT_TRIANGLE_TESTS = 5;
+const int STAT_NODE_TESTS = 6;      // BVH bounding boxes
+const int STAT_END_LIGHT = 7;       // Path terminations
+const int STAT_END_MISS = 8;
+const int STAT_END_BOUNCES = 9;
+const int STAT_COUNTERS = 10;
+const int STAT_SAMPLE_BINS = 16;    // Pixels by samples taken in the adaptive loop, the last bin has the rest
+const int STAT_BOUNCE_BINS = 8;     // Paths by segments traced
+const int STAT_SAMPLE_HISTOGRAM = STAT_COUNTERS;
+const int STAT_BOUNCE_HISTOGRAM = STAT_SAMPLE_HISTOGRAM + STAT_SAMPLE_BINS;
+const int STAT_TOTAL = STAT_BOUNCE_HISTOGRAM + STAT_BOUNCE_BINS;
+
+// 64 bit counters as low and high word, a frame has more triangle tests than 32 bits hold
+layout (std430, binding = 11) buffer RayStatsBuffer {
+    uint rayStats[STAT_TOTAL * 2];
+};
+
+uint localStats[STAT_COUNTERS];
+shared uint groupStats[STAT_TOTAL];
+
+#define STAT_ADD(counter, n) localStats[counter] += uint(n)
+// Histograms go straight to shared memory, at most one update per path or pixel
+#define STAT_HISTOGRAM(first, bins, value) atomicAdd(groupStats[(first) + clamp(int(value), 0, (bins) - 1)], 1u)
+
+void statsBegin() {
+    for (int i = 0; i < STAT_COUNTERS; i++) {
+        localStats[i] = 0u;
+    }
+    uint groupInvocations = gl_WorkGroupSize.x * gl_WorkGroupSize.y * gl_WorkGroupSize.z;
+    for (uint i = gl_LocalInvocationIndex; i < STAT_TOTAL; i += groupInvocations) {
+        groupStats[i] = 0u;
+    }
+    barrier();
+}
+
+void statsEnd() {
+    for (int i = 0; i < STAT_COUNTERS; i++) {
+        if (localStats[i] != 0u) {
+            atomicAdd(groupStats[i], localStats[i]);
+        }
+    }
+    barrier();
+
+    uint groupInvocations = gl_WorkGroupSize.x * gl_WorkGroupSize.y * gl_WorkGroupSize.z;
+    for (uint i = gl_LocalInvocationIndex; i < STAT_TOTAL; i += groupInvocations) {
+        uint value = groupStats[i];
+        if (value != 0u) {
+            uint previous = atomicAdd(rayStats[i * 2], value);
+            if (previous + value < previous) {
+                atomicAdd(rayStats[i * 2 + 1], 1u);  // Carry
+            }
+        }
+    }
+}
+
+#else
+
+#define STAT_ADD(counter, n)
+#define STAT_HISTOGRAM(first, bins, value)
+void statsBegin() {}
+void statsEnd() {}
+
+#endif
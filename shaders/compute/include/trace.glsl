@@ -0,0 +1,264 @@
+// Closest hit and direct light sampling shared by the megakernel and the wavefront passes,
+// needs common.glsl, scene.glsl and the USE_MESH / SHADOWS defines
+
+// Ray in an instance's object space. The direction is not normalized, so distances along it are
+// still world space distances.
+Ray instanceRay(InstanceData instance, Ray ray) {
+    Ray local;
+    local.point = vec3(dot(instance.worldToObject[0], vec4(ray.point, 1.0)),
+                       dot(instance.worldToObject[1], vec4(ray.point, 1.0)),
+                       dot(instance.worldToObject[2], vec4(ray.point, 1.0)));
+    local.dir = vec3(dot(instance.worldToObject[0].xyz, ray.dir),
+                     dot(instance.worldToObject[1].xyz, ray.dir),
+                     dot(instance.worldToObject[2].xyz, ray.dir));
+    return local;
+}
+
+// Object space normal back in world space (the transposed inverse of the object to world transform)
+vec3 instanceNormal(InstanceData instance, vec3 normal) {
+    return normalize(normal.x * instance.worldToObject[0].xyz + normal.y * instance.worldToObject[1].xyz + normal.z * instance.worldToObject[2].xyz);
+}
+
+// Distance to the unit sphere and the side the ray starts on (like sphereHit), -1 on a miss
+vec2 unitSphereHit(Ray ray) {
+    float a = dot(ray.dir, ray.dir);
+    float b = dot(ray.point, ray.dir);
+    float h = b * b - a * (dot(ray.point, ray.point) - 1.0);
+    if (h <= 0.0) {
+        return vec2(-1.0, 0.0);
+    }
+    h = sqrt(h);
+    float t1 = (-b - h) / a;
+    return t1 < 0.0 ? vec2((-b + h) / a, -1.0) : vec2(t1, 1.0);
+}
+
+// Distance to the [-1, 1] cube and its object space normal there (like boxHit), w = -1 on a miss
+vec4 unitBoxHit(Ray ray) {
+    vec3 m = 1.0 / ray.dir;
+    vec3 n = m * ray.point;
+    vec3 k = abs(m);
+    vec3 t1 = -n - k;
+    vec3 t2 = -n + k;
+    float tn = max(max(t1.x, t1.y), t1.z);
+    float tf = min(min(t2.x, t2.y), t2.z);
+    if (tn > tf || tf < 0.0) return vec4(-1.0);
+    vec3 normal = (tn > 0.0) ? step(vec3(tn), t1) : step(t2, vec3(tf));
+    return vec4(normal * -sign(m), (tn > 0.0) ? tn : tf);
+}
+
+// Closest surface of a sphere or box instance nearer than dist: updates dist and the object space normal
+bool instanceHit(InstanceData instance, Ray ray, inout float dist, inout vec3 normal, inout float isInside) {
+    Ray local = instanceRay(instance, ray);
+    if (instance.kind == INSTANCE_SPHERE || instance.kind == INSTANCE_SPHERE_LIGHT) {
+        STAT_ADD(STAT_SPHERE_TESTS, 1);
+        vec2 hitResult = unitSphereHit(local);
+        if (hitResult.x > 0.0 && hitResult.x < dist) {
+            dist = hitResult.x;
+            isInside = hitResult.y;
+            normal = hitResult.y * (local.point + local.dir * hitResult.x);
+            return true;
+        }
+    } else if (instance.kind == INSTANCE_BOX || instance.kind == INSTANCE_BOX_LIGHT) {
+        STAT_ADD(STAT_BOX_TESTS, 1);
+        vec4 hitResult = unitBoxHit(local);
+        if (hitResult.w > 0.0 && hitResult.w < dist) {
+            dist = hitResult.w;
+            normal = hitResult.xyz;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Function to compute the distance and material at the intersection: walks the TLAS nearest child
+// first and tests the instances of the leaves it reaches
+vec2 rayDist(inout Ray rayTrace, inout vec3 normal, out Material material) {
+    float dist = infinity;
+    float isInside = 0;
+    checks++;
+    if (tlasNodeCount == 0u) {
+        return vec2(dist, isInside);
+    }
+
+    vec3 invDir = 1.0 / rayTrace.dir;
+    STAT_ADD(STAT_NODE_TESTS, 1);
+    if (aabbHit(rayTrace.point, invDir, tlasNodes[0].boundsMin, tlasNodes[0].boundsMax, dist) >= infinity) {
+        return vec2(dist, isInside);
+    }
+
+    uint stack[BVH_STACK_SIZE];
+    int stackSize = 0;
+    uint nodeIndex = 0;
+    uint hitInstance = 0;
+    int meshInstance = -1;  // The mesh's BVH is walked once after the TLAS, bounded by the closest hit so far
+    vec3 objectNormal = vec3(0);
+    while (true) {
+        BVHNode node = tlasNodes[nodeIndex];
+        if (node.triangleCount > 0) {
+            for (uint i = node.leftOrFirst; i < node.leftOrFirst + node.triangleCount; i++) {
+                if (instances[i].kind == INSTANCE_MESH) {
+                    meshInstance = int(i);
+                } else if (instanceHit(instances[i], rayTrace, dist, objectNormal, isInside)) {
+                    hitInstance = i;
+                }
+            }
+            if (stackSize == 0) break;
+            nodeIndex = stack[--stackSize];
+            continue;
+        }
+
+        // Visit the nearer child first, keep the other one for later
+        STAT_ADD(STAT_NODE_TESTS, 2);
+        uint nearChild = nodeIndex + 1;
+        uint farChild = node.leftOrFirst;
+        float nearDist = aabbHit(rayTrace.point, invDir, tlasNodes[nearChild].boundsMin, tlasNodes[nearChild].boundsMax, dist);
+        float farDist = aabbHit(rayTrace.point, invDir, tlasNodes[farChild].boundsMin, tlasNodes[farChild].boundsMax, dist);
+        if (nearDist > farDist) {
+            uint swapChild = nearChild; nearChild = farChild; farChild = swapChild;
+            float swapDist = nearDist; nearDist = farDist; farDist = swapDist;
+        }
+
+        if (nearDist >= infinity) {
+            if (stackSize == 0) break;
+            nodeIndex = stack[--stackSize];
+            continue;
+        }
+        nodeIndex = nearChild;
+        if (farDist < infinity && stackSize < BVH_STACK_SIZE) {
+            stack[stackSize++] = farChild;
+        }
+    }
+
+#if USE_MESH
+    if (meshInstance >= 0) {
+        vec3 norm;
+        float bd = meshHit(instanceRay(instances[meshInstance], rayTrace), dist, norm);
+        if (bd > 0.0 && bd < dist) {
+            dist = bd;
+            objectNormal = norm;
+            hitInstance = uint(meshInstance);
+        }
+    }
+#endif
+
+    // Normal and material only for the closest hit
+    if (dist < infinity) {
+        normal = instanceNormal(instances[hitInstance], objectNormal);
+        material = materials[instances[hitInstance].material];
+    }
+    return vec2(dist, isInside);
+}
+
+// Any-hit query for shadow rays: true as soon as a surface is found closer than tMax. Lights don't
+// block (the ray ends on one), and no normal or material is computed. TLAS children are only culled
+// against tMax, not sorted.
+bool occluded(Ray ray, float tMax) {
+    if (tlasNodeCount == 0u) return false;
+
+    vec3 invDir = 1.0 / ray.dir;
+    STAT_ADD(STAT_NODE_TESTS, 1);
+    if (aabbHit(ray.point, invDir, tlasNodes[0].boundsMin, tlasNodes[0].boundsMax, tMax) >= infinity) return false;
+
+    uint stack[BVH_STACK_SIZE];
+    int stackSize = 0;
+    uint nodeIndex = 0;
+    while (true) {
+        BVHNode node = tlasNodes[nodeIndex];
+        if (node.triangleCount > 0) {
+            for (uint i = node.leftOrFirst; i < node.leftOrFirst + node.triangleCount; i++) {
+                InstanceData instance = instances[i];
+                if (instance.kind == INSTANCE_SPHERE_LIGHT || instance.kind == INSTANCE_BOX_LIGHT) continue;
+                Ray local = instanceRay(instance, ray);
+                if (instance.kind == INSTANCE_SPHERE) {
+                    STAT_ADD(STAT_SPHERE_TESTS, 1);
+                    float t = unitSphereHit(local).x;
+                    if (t > 0.0 && t < tMax) return true;
+                } else if (instance.kind == INSTANCE_BOX) {
+                    STAT_ADD(STAT_BOX_TESTS, 1);
+                    float t = unitBoxHit(local).w;
+                    if (t > 0.0 && t < tMax) return true;
+                }
+#if USE_MESH
+                else if (meshOccluded(local, tMax)) return true;
+#endif
+            }
+        } else {
+            STAT_ADD(STAT_NODE_TESTS, 2);
+            uint leftChild = nodeIndex + 1;
+            uint rightChild = node.leftOrFirst;
+            bool hitLeft = aabbHit(ray.point, invDir, tlasNodes[leftChild].boundsMin, tlasNodes[leftChild].boundsMax, tMax) < infinity;
+            bool hitRight = aabbHit(ray.point, invDir, tlasNodes[rightChild].boundsMin, tlasNodes[rightChild].boundsMax, tMax) < infinity;
+            if (hitLeft) {
+                if (hitRight && stackSize < BVH_STACK_SIZE) {
+                    stack[stackSize++] = rightChild;
+                }
+                nodeIndex = leftChild;
+                continue;
+            }
+            if (hitRight) {
+                nodeIndex = rightChild;
+                continue;
+            }
+        }
+        if (stackSize == 0) break;
+        nodeIndex = stack[--stackSize];
+    }
+    return false;
+}
+
+// Direct light (xyz) from LIGHT_SAMPLES lights picked by power, each divided by the probability of
+// picking it so the sum over all lights is estimated without bias, and how far the point is from
+// being lit by the picked lights (w). The cost no longer grows with the number of lights.
+// Reads the light sample dimensions starting at samplerDimension and leaves it past them.
+vec4 sampleLight(vec3 point, vec3 normal){
+    vec3 lightness = vec3(0);
+    float couldBeLit = infinity;
+    uint lightDimension = samplerDimension;
+    samplerDimension += DIMS_PER_LIGHT * uint(LIGHT_SAMPLES);
+    if (lightCount == 0u) {
+        return vec4(lightness, couldBeLit);
+    }
+    Ray lightRay;
+
+    for(int s=0;s<LIGHT_SAMPLES;s++){
+        float pdf;
+        uint light = pickLight(samplerGet(lightDimension + uint(s) * DIMS_PER_LIGHT + 3u), pdf);
+        samplerDimension = lightDimension + uint(s) * DIMS_PER_LIGHT;
+        bool isSphere = light < sphereLightCount;
+        Sphere ball;
+        Box block;
+        vec3 lightPos;
+        Material lightMaterial;
+        if (isSphere) {
+            ball = getSphere(sphereLightSources[light]);
+            lightPos = ball.position + randomSphereDirection()*ball.radius;
+            lightMaterial = ball.material;
+        } else {
+            block = getBox(boxLightSources[light - sphereLightCount]);
+            lightPos = boxSurfacePoint(block, hash3());
+            lightMaterial = block.material;
+        }
+
+        vec3 dirToLight = lightPos-point;
+        lightRay.dir = normalize(dirToLight);
+        lightRay.point = point+lightRay.dir*0.0001;
+        float squareDist = dot(dirToLight, dirToLight);
+        // The shadow ray ends where it enters the light, the sampled point can be on its far side
+        float lightDist = isSphere ? sphereHit(lightRay, ball).x : boxHit(lightRay, block).w;
+        float distance = lightDist > 0.0 ? lightDist : sqrt(squareDist);
+#if SHADOWS
+        STAT_ADD(STAT_SHADOW_RAYS, 1);
+        bool visible = !occluded(lightRay, distance);
+#else
+        // Shadow-free variant: every light is assumed visible
+        bool visible = true;
+#endif
+        if(visible){
+            lightness += (clamp(dot(lightRay.dir, normal),0.0,1.0) * lightMaterial.color)/(distance * pdf * float(LIGHT_SAMPLES));
+        }else{
+        couldBeLit = min(squareDist / (lightMaterial.color.x + lightMaterial.color.y + lightMaterial.color.z), couldBeLit);
+        }
+	}
+    samplerDimension = lightDimension + DIMS_PER_LIGHT * uint(LIGHT_SAMPLES);
+    return vec4(lightness, couldBeLit);
+}
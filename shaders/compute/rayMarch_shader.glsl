@@ -1,14 +1,47 @@
 #version 430 core
 
+// Sphere tracer for signed distance fields. With SDF_BRICKS (the RayMarcher's variant) the distance
+// comes from the scene baked by sdfBaker.cpp: a coarse grid whose cells are either empty, with the
+// distance at their center, or point to an 8x8x8 brick of distance samples in a 3D atlas. Every step
+// is then one trilinear lookup however many primitives the scene has, and rays jump across empty cells.
+// Without it the small analytic test scene in sdScene is evaluated.
+//
+// The same file builds the cone pre-passes: with CONE_TILE set each invocation marches one cone around
+// the rays of a CONE_TILE x CONE_TILE pixel tile and stores how far they can all go before anything is
+// in reach, starting from the distance the CONE_PARENT_TILE pass found for the enclosing tile. The full
+// resolution march with CONE_PREPASS starts each ray at the distance of its CONE_PREPASS sized tile.
+
+#ifndef SDF_BRICKS
+#define SDF_BRICKS 0
+#endif
+#ifndef CONE_TILE
+#define CONE_TILE 0
+#endif
+#ifndef CONE_PARENT_TILE
+#define CONE_PARENT_TILE 0
+#endif
+#ifndef CONE_PREPASS
+#define CONE_PREPASS 0
+#endif
+
 // Work group size of 16x16
 layout(local_size_x = 16, local_size_y = 16) in;
 
-layout(location = 0) uniform mat4 viewMatrix;   // View matrix
-layout(location = 1) uniform mat4 projMatrix;   // Projection matrix
-layout(location = 2) uniform vec3 position;   // Projection matrix
+#include "include/frame.glsl"
+#include "include/common.glsl"
+#include "include/scene.glsl"
 
-// Texture input (bind to texture unit 0)
-layout (rgba8, binding = 0) uniform image2D screenTexture;  // Binding point 0
+layout (rgba16f, binding = 0) uniform image2D screenTexture;
+layout (rgba16f, binding = 1) uniform image2D normalTexture;
+layout (r32f, binding = 2) uniform image2D depthTexture;
+#if CONE_TILE
+layout (r32f, binding = 3) uniform writeonly image2D coneDistance;
+#if CONE_PARENT_TILE
+layout (r32f, binding = 4) uniform readonly image2D parentConeDistance;
+#endif
+#elif CONE_PREPASS
+layout (r32f, binding = 3) uniform readonly image2D coneDistance;
+#endif
 
 // Constants and precision
 const int MAX_MARCHING_STEPS = 256;
@@ -16,7 +49,22 @@ const float MIN_DIST = 0.0;
 const float MAX_DIST = 100.0;
 const float PRECISION = 0.001;
 const float infty = 9999999.0;
-const float aspectRatio = 4/3;
+
+#if SDF_BRICKS
+#define BRICK_SIZE 8                        // SdfBrickMap::BRICK_SIZE
+const uint EMPTY_CELL = 0xffffffffu;
+const int EMPTY_SPACE = -1;                 // surf.mat of a lower bound from the coarse grid
+
+// Atlas position of each cell's brick in bricks (x | y << 10 | z << 20), or EMPTY_CELL
+layout(binding = 0) uniform usampler3D sdfCells;
+layout(binding = 1) uniform sampler3D sdfCellDistances;     // Distance at each cell's center
+layout(binding = 2) uniform sampler3D sdfAtlas;             // R16F distance bricks, linear filtering
+layout(binding = 3) uniform usampler3D sdfMaterials;        // Closest primitive's material per sample
+uniform vec3 sdfOrigin;                     // Minimum corner of the grid
+uniform float sdfCellSize;
+uniform vec3 sdfGridSize;                   // Cells per axis
+uniform vec3 sdfAtlasSize;                  // Atlas texels per axis
+#endif
 
 int iterCounter = 0;
 
@@ -59,6 +107,57 @@ float sdBox(vec3 p, vec3 b, vec3 offset) {
     return d;
 }
 
+#if SDF_BRICKS
+// Atlas texel of the brick's first sample
+ivec3 brickOrigin(uint brick) {
+    return ivec3(brick & 1023u, (brick >> 10) & 1023u, brick >> 20) * BRICK_SIZE;
+}
+
+// Baked scene SDF. Outside the grid and in empty cells it returns a lower bound (mat EMPTY_SPACE):
+// the distance to the grid, nothing outside it is baked, or the distance at the cell's center minus
+// how far p is from it.
+surf sdScene(vec3 p) {
+    iterCounter++;
+    vec3 gridPos = (p - sdfOrigin) / sdfCellSize;
+    vec3 outside = max(max(-gridPos, gridPos - sdfGridSize), 0.0);
+    if (any(lessThan(gridPos, vec3(0))) || any(greaterThanEqual(gridPos, sdfGridSize))) {
+        return surf(length(outside) * sdfCellSize, EMPTY_SPACE, vec3(0));
+    }
+
+    ivec3 cell = ivec3(gridPos);
+    uint brick = texelFetch(sdfCells, cell, 0).r;
+    if (brick == EMPTY_CELL) {
+        float centerDistance = texelFetch(sdfCellDistances, cell, 0).r;
+        return surf(abs(centerDistance) - length(gridPos - vec3(cell) - 0.5) * sdfCellSize, EMPTY_SPACE, vec3(0));
+    }
+    // The brick's samples span the cell corner to corner
+    vec3 texel = vec3(brickOrigin(brick)) + (gridPos - vec3(cell)) * float(BRICK_SIZE - 1) + 0.5;
+    return surf(texture(sdfAtlas, texel / sdfAtlasSize).r, 0, vec3(1));
+}
+
+// Material color of the sample closest to p, only read once a ray has hit
+vec3 surfaceColor(vec3 p) {
+    vec3 gridPos = clamp((p - sdfOrigin) / sdfCellSize, vec3(0), sdfGridSize - 0.001);
+    ivec3 cell = ivec3(gridPos);
+    uint brick = texelFetch(sdfCells, cell, 0).r;
+    if (brick == EMPTY_CELL) {
+        return vec3(0);
+    }
+    ivec3 sampleIndex = ivec3(round((gridPos - vec3(cell)) * float(BRICK_SIZE - 1)));
+    return materials[texelFetch(sdfMaterials, brickOrigin(brick) + sampleIndex, 0).r].color;
+}
+
+// Distance along the ray to the far side of the coarse cell containing p, 0 outside the grid
+float emptyCellExit(vec3 p, vec3 dir) {
+    vec3 gridPos = (p - sdfOrigin) / sdfCellSize;
+    if (any(lessThan(gridPos, vec3(0))) || any(greaterThanEqual(gridPos, sdfGridSize))) {
+        return 0.0;
+    }
+    vec3 farSide = floor(gridPos) + step(vec3(0), dir);
+    vec3 t = (farSide - gridPos) / dir;     // +inf on axes the ray doesn't move along
+    return max(min(t.x, min(t.y, t.z)), 0.0) * sdfCellSize;
+}
+#else
 // Scene SDF
 surf sdScene(vec3 p) {
     surf scene = surf(sdPlane(p, vec3(0.0, 1.0, 0.0), 2.5), 1, vec3(1));
@@ -68,6 +167,8 @@ surf sdScene(vec3 p) {
     return scene;
 }
 
+#endif
+
 float GetDistanceToNearestSurface(vec3 p){
     return sdScene(p).sd;
 }
@@ -75,7 +176,12 @@ float GetDistanceToNearestSurface(vec3 p){
 vec3 GetSurfaceNormal(vec3 p)
 {
     float d0 = GetDistanceToNearestSurface(p);
+#if SDF_BRICKS
+    // Half a sample apart, the filtered atlas is flat at smaller scales
+    vec2 epsilon = vec2(sdfCellSize / float(BRICK_SIZE - 1) * 0.5, 0);
+#else
     const vec2 epsilon = vec2(.0001,0);
+#endif
     vec3 d1 = vec3(
         GetDistanceToNearestSurface(p-epsilon.xyy),
         GetDistanceToNearestSurface(p-epsilon.yxy),
@@ -83,12 +189,12 @@ vec3 GetSurfaceNormal(vec3 p)
     return normalize(d0 - d1);
 }
 
-surf fireRay(inout ray marchRay, float end, float w){
+surf fireRay(inout ray marchRay, float start, float end, float w){
     float rp = 0.0; // previous r
     float ri = 0.0; // current r
     float rn = infty; // next r
     float d = 0.0;  // accumulated distance
-    float t = 0.0; // current position along the ray
+    float t = start; // current position along the ray
     surf co;  // closest object
     for (int i = 0; i < MAX_MARCHING_STEPS; i++) {
         co = sdScene(marchRay.point + (t + d) * marchRay.dir);  // Sample the scene
@@ -102,13 +208,29 @@ surf fireRay(inout ray marchRay, float end, float w){
         }
         
         t += d;  // Move the ray forward by the distance d
-        rp = ri;  // Store previous distance
-        ri = rn;  // Update current distance
-        d = ri + w * ri * (d - rp + ri) / (d + rp - ri);  // Update distance using acceleration factor
-        
-        if (rn < PRECISION && i > 1) {
-            marchRay.point += (t) * marchRay.dir;
-            return co;
+        bool emptySpace = false;
+#if SDF_BRICKS
+        if (co.mat == EMPTY_SPACE) {
+            // No surface before the far side of this coarse cell: jump there and restart the over-relaxation
+            t += max(emptyCellExit(marchRay.point + t * marchRay.dir, marchRay.dir), rn) + sdfCellSize * 0.001;
+            emptySpace = true;
+            rp = 0.0;
+            ri = 0.0;
+            d = 0.0;
+        }
+#endif
+        if (!emptySpace) {
+            rp = ri;  // Store previous distance
+            ri = rn;  // Update current distance
+            d = ri + w * ri * (d - rp + ri) / (d + rp - ri);  // Update distance using acceleration factor
+
+            if (rn < PRECISION && i > 1) {
+                marchRay.point += (t) * marchRay.dir;
+#if SDF_BRICKS
+                co.col = surfaceColor(marchRay.point);
+#endif
+                return co;
+            }
         }
         if (t > end){
             co.sd = end;
@@ -117,24 +239,35 @@ surf fireRay(inout ray marchRay, float end, float w){
             return co;
         }
     }
+    // Out of steps, counts as a miss
+    co.sd = end;
+    co.col = vec3(0);
+    marchRay.point += t * marchRay.dir;
+    return co;
 }
 
-// Accelerated Ray Marching
-surf rayMarch(vec3 ro, vec3 rd, float start, float end, float w) {
+// Accelerated Ray Marching, the first hit's normal and distance go to the temporal and denoise passes
+surf rayMarch(vec3 ro, vec3 rd, float start, float end, float w, out vec3 hitNormal, out float hitDistance) {
     surf co;  // closest object
     ray marchRay;
     marchRay.point = ro;
     marchRay.dir = rd;
     vec3 col = vec3(0);
+    hitNormal = vec3(0);
+    hitDistance = infinity;
     //co = fireRay(marchRay, end, w);
     for(int i = 0; i < 1; i++){
 
-        co = fireRay(marchRay, end, w);
+        co = fireRay(marchRay, i == 0 ? start : MIN_DIST, end, w);
         col += (1.0/(float(i)+1.0))*co.col;
         if (co.sd >= end){
             return co;
         }
         vec3 norm = GetSurfaceNormal(marchRay.point);
+        if (i == 0) {
+            hitNormal = norm;
+            hitDistance = distance(ro, marchRay.point);
+        }
         marchRay.dir = reflect(marchRay.dir, norm);
     }
     co.col = col;
@@ -143,34 +276,81 @@ surf rayMarch(vec3 ro, vec3 rd, float start, float end, float w) {
     return co;
 }
 
+// Same camera ray as the path tracer through pixel coordinate pixel (invViewProj is camera relative)
+vec3 cameraRay(vec2 pixel) {
+    vec2 ndc = (pixel / vec2(resolution)) * 2.0 - 1.0;
+    ndc.x *= aspectRatio;
+    vec4 worldSpacePos = invViewProj * vec4(ndc, -1.0, 1.0);
+    return normalize(worldSpacePos.xyz / worldSpacePos.w);
+}
+
+#if CONE_TILE
+// Marches the cone with the given axis and slope (tangent of its half angle) from start, where it is
+// known to be empty. The ball of radius r around the axis point at t covers the cone up to
+// t + (r - t * slope) / (1 + slope), so the whole cone stays empty up to the returned distance and
+// every ray inside it can skip that far. Stops once the cone is wider than the free space around it.
+float coneMarch(vec3 origin, vec3 axis, float slope, float start, float end) {
+    float t = start;
+    for (int i = 0; i < MAX_MARCHING_STEPS && t < end; i++) {
+        float advance = (sdScene(origin + t * axis).sd - t * slope) / (1.0 + slope);
+        if (advance < PRECISION) {
+            break;
+        }
+        t += advance;
+    }
+    return min(t, end);
+}
+
+void main() {
+    ivec2 tile = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(tile, imageSize(coneDistance)))) {
+        return;
+    }
+
+    // The cone around the tile's center ray through its corner pixels' rays holds every ray of the tile
+    vec2 first = vec2(tile * CONE_TILE);
+    vec2 last = first + float(CONE_TILE - 1);
+    vec3 axis = cameraRay((first + last) * 0.5);
+    float cosAngle = min(min(dot(axis, cameraRay(first)), dot(axis, cameraRay(last))),
+                         min(dot(axis, cameraRay(vec2(first.x, last.y))), dot(axis, cameraRay(vec2(last.x, first.y)))));
+    cosAngle = clamp(cosAngle, 0.01, 1.0);
+    float slope = sqrt(1.0 - cosAngle * cosAngle) / cosAngle;
+
+    float start = MIN_DIST;
+#if CONE_PARENT_TILE
+    // The enclosing tile's cone contains this one and is empty up to its distance
+    start = imageLoad(parentConeDistance, tile * CONE_TILE / CONE_PARENT_TILE).r;
+#endif
+    imageStore(coneDistance, tile, vec4(coneMarch(cameraPosition, axis, slope, start, MAX_DIST)));
+}
+#else
 void main() {
     // Get the fragment coordinates (pixel location in the image)
     ivec2 fragCoord = ivec2(gl_GlobalInvocationID.xy);
     
-    // Convert screen coordinates to NDC (Normalized Device Coordinates)
-    vec2 texSize = imageSize(screenTexture);
-    vec2 ndc = (fragCoord / texSize) * 2.0 - 1.0;  // Convert from pixel to NDC (-1 to 1)
-    // Apply aspect ratio correction
-    ndc.x *= aspectRatio; // Correct for aspect ratio
+    if (any(greaterThanEqual(fragCoord, ivec2(resolution)))) {
+        return;
+    }
 
-    // Convert from NDC to clip space
-    // NDC -> Clip Space (Z=-1, W=1)
-    vec4 clipSpacePos = vec4(ndc, -1.0, 1.0); // Setting Z=-1 for the near plane and W=1
+    vec3 rayDir = cameraRay(vec2(fragCoord));
+    vec3 rayOrigin = cameraPosition;
 
-    // Convert from clip space to view space by multiplying with the inverse projection matrix
-    vec4 viewSpacePos = inverse(projMatrix) * clipSpacePos; // Apply inverse projection matrix
-    viewSpacePos /= viewSpacePos.w; // Perspective divide to get normalized coordinates in view space
+    // Nothing is in reach of the ray before its tile's cone distance
+    float start = MIN_DIST;
+#if CONE_PREPASS
+    start = imageLoad(coneDistance, fragCoord / CONE_PREPASS).r;
+#endif
 
-    // Convert from view space to world space by multiplying with the inverse view matrix
-    vec3 rayDir = normalize((inverse(viewMatrix) * viewSpacePos).xyz); // Normalize to get ray direction
-
-    vec3 rayOrigin = position; // Camera position (translation part of the inverse view matrix)
-    
-    surf co = rayMarch(rayOrigin, rayDir, MIN_DIST, MAX_DIST, 0.6);
+    vec3 normal;
+    float hitDistance;
+    surf co = rayMarch(rayOrigin, rayDir, start, MAX_DIST, 0.6, normal, hitDistance);
+    imageStore(normalTexture, fragCoord, vec4(normal, 1.0));
+    imageStore(depthTexture, fragCoord, vec4(hitDistance));
 
     // Write the color to the screenTexture
     //imageStore(screenTexture, fragCoord, vec4(float(co.iter-1)/float(MAX_MARCHING_STEPS),0,0, 1.0));
     //imageStore(screenTexture, fragCoord, vec4(float(iterCounter)/float(MAX_MARCHING_STEPS),0,0, 1.0));
     imageStore(screenTexture, fragCoord, vec4(co.col, 1.0));
     //imageStore(screenTexture, fragCoord, vec4(co.sd/25.0,0,0, 1.0));
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,41 @@
+#version 430 core
+
+// Full resolution primary hit normals, the guide for upscaling a lower resolution trace
+
+#ifndef USE_MESH
+#define USE_MESH 1
+#endif
+#ifndef SHADOWS
+#define SHADOWS 1
+#endif
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+#include "../include/frame.glsl"
+#include "../include/common.glsl"
+#include "../include/scene.glsl"
+#include "../include/trace.glsl"
+
+layout (rgba16f, binding = 0) uniform writeonly image2D guideNormalTexture;
+
+void main() {
+    ivec2 fragCoord = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(guideNormalTexture);
+    if (any(greaterThanEqual(fragCoord, size))) {
+        return;
+    }
+
+    // Same camera ray as the path tracer, at this texture's resolution
+    vec2 ndc = (fragCoord / vec2(size)) * 2.0 - 1.0;
+    ndc.x *= aspectRatio;
+    vec4 worldSpacePos = invViewProj * vec4(ndc, -1.0, 1.0);
+
+    Ray ray;
+    ray.point = cameraPosition;
+    ray.dir = normalize(worldSpacePos.xyz / worldSpacePos.w);
+    vec3 normal = vec3(0);
+    Material material;
+    float distance = rayDist(ray, normal, material).x;
+
+    imageStore(guideNormalTexture, fragCoord, distance < infinity ? vec4(normal, 1.0) : vec4(0, 0, 0, 1.0));
+}
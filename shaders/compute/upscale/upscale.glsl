@@ -0,0 +1,52 @@
+#version 430 core
+
+// Edge-aware upscale (joint bilateral): each output pixel blends the 2x2 nearest trace pixels with
+// bilinear weights, scaled down where their normal differs from the full resolution guide normal,
+// so colors don't bleed across object edges.
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout (rgba16f, binding = 0) uniform readonly image2D traceTexture;        // Low resolution color
+layout (rgba16f, binding = 1) uniform readonly image2D traceNormalTexture;  // Low resolution normals
+layout (rgba16f, binding = 2) uniform readonly image2D guideNormalTexture;  // Full resolution normals
+layout (rgba16f, binding = 3) uniform writeonly image2D outputTexture;
+
+const float NORMAL_POWER = 32.0;
+
+void main() {
+    ivec2 fragCoord = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 outputSize = imageSize(outputTexture);
+    if (any(greaterThanEqual(fragCoord, outputSize))) {
+        return;
+    }
+    ivec2 traceSize = imageSize(traceTexture);
+
+    vec2 tracePos = (vec2(fragCoord) + 0.5) * vec2(traceSize) / vec2(outputSize) - 0.5;
+    ivec2 base = ivec2(floor(tracePos));
+    vec2 f = tracePos - vec2(base);
+    vec3 guideNormal = imageLoad(guideNormalTexture, fragCoord).xyz;
+
+    vec3 color = vec3(0);
+    vec3 bilinearColor = vec3(0);
+    float totalWeight = 0.0;
+    for (int i = 0; i < 4; i++) {
+        ivec2 offset = ivec2(i % 2, i / 2);
+        ivec2 coord = clamp(base + offset, ivec2(0), traceSize - 1);
+        float bilinear = (offset.x == 1 ? f.x : 1.0 - f.x) * (offset.y == 1 ? f.y : 1.0 - f.y);
+
+        vec3 sampleColor = imageLoad(traceTexture, coord).rgb;
+        vec3 sampleNormal = imageLoad(traceNormalTexture, coord).xyz;
+        // Background has a zero normal, it only matches other background
+        float similarity = dot(guideNormal, guideNormal) + dot(sampleNormal, sampleNormal) < 0.5
+                         ? 1.0 : pow(max(dot(guideNormal, sampleNormal), 0.0), NORMAL_POWER);
+
+        float weight = bilinear * similarity;
+        color += sampleColor * weight;
+        totalWeight += weight;
+        bilinearColor += sampleColor * bilinear;
+    }
+
+    // No neighbor on the same surface (thin features): plain bilinear
+    color = totalWeight > 1e-4 ? color / totalWeight : bilinearColor;
+    imageStore(outputTexture, fragCoord, vec4(color, 1.0));
+}
@@ -0,0 +1,21 @@
+#version 430 core
+
+// Wavefront pass 5: resolve the per-pixel sums into the image, same estimate as the megakernel
+
+#include "../include/frame.glsl"
+#include "../include/common.glsl"
+#include "wavefront.glsl"
+
+layout (rgba16f, binding = 0) uniform writeonly image2D screenTexture;
+
+uniform uint sampleCount;
+
+void main() {
+    uint slot = gl_GlobalInvocationID.x;
+    if (slot >= resolution.x * resolution.y) {
+        return;
+    }
+    ivec2 fragCoord = ivec2(slot % resolution.x, slot / resolution.x);
+    vec3 color = (paths[slot].lightSum * paths[slot].colorSum) / float(sampleCount * sampleCount);
+    imageStore(screenTexture, fragCoord, vec4(color, 1.0));
+}
@@ -0,0 +1,23 @@
+#version 430 core
+
+// Wavefront pass 4: shadow rays from each shaded point to the lights
+
+#include "../include/frame.glsl"
+#include "../include/common.glsl"
+#include "../include/scene.glsl"
+#include "../include/trace.glsl"
+#include "wavefront.glsl"
+
+uniform uint sampleIndex;
+uniform uint roundIndex;
+
+void main() {
+    uint slot;
+    if (!popQueue(SHADOW_QUEUE, slot)) {
+        return;
+    }
+    beginSample(slot, sampleIndex, bounceDimension(roundIndex) + DIM_BOUNCE_LIGHTS);
+
+    vec4 directBrightness = sampleLight(paths[slot].origin, paths[slot].hitNormal);
+    paths[slot].lightSum += directBrightness.xyz * paths[slot].lightWeight;
+}
@@ -0,0 +1,45 @@
+#version 430 core
+
+// Wavefront pass 2: closest hit for every queued ray. Misses end the path here, hits go to SHADE_QUEUE.
+
+#include "../include/frame.glsl"
+#include "../include/common.glsl"
+#include "../include/scene.glsl"
+#include "../include/trace.glsl"
+#include "wavefront.glsl"
+
+layout (rgba16f, binding = 1) uniform writeonly image2D normalTexture;
+layout (r32f, binding = 2) uniform writeonly image2D depthTexture;
+
+uniform uint inputQueue;
+uniform uint writeGBuffer;     // First round of the first sample: store primary normals and depth
+
+void main() {
+    uint slot;
+    if (!popQueue(inputQueue, slot)) {
+        return;
+    }
+
+    Ray ray;
+    ray.point = paths[slot].origin;
+    ray.dir = paths[slot].direction;
+    vec3 normal = vec3(0);
+    Material material;
+    float distance = rayDist(ray, normal, material).x;
+
+    if (writeGBuffer != 0) {
+        ivec2 fragCoord = ivec2(slot % resolution.x, slot / resolution.x);
+        imageStore(normalTexture, fragCoord, distance < infinity ? vec4(normal, 1.0) : vec4(0, 0, 0, 1.0));
+        imageStore(depthTexture, fragCoord, vec4(distance < infinity ? distance : infinity));
+    }
+
+    if (distance < infinity) {
+        paths[slot].hitNormal = normal;
+        paths[slot].hitDistance = distance;
+        paths[slot].hitColor = vec4(material.color, float(material.type));
+        paths[slot].hitParams = vec4(material.opaqueness, material.smoothness, material.specularity, 0.0);
+        pushQueue(SHADE_QUEUE, slot);
+    } else {
+        paths[slot].colorSum += paths[slot].throughput;
+    }
+}
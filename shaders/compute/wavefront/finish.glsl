@@ -0,0 +1,18 @@
+#version 430 core
+
+// Wavefront pass after the last round of a sample: the paths still in the ray queue ran out of
+// rounds (or bounces), their throughput counts like the megakernel's color after its bounce loop
+
+#include "../include/frame.glsl"
+#include "../include/common.glsl"
+#include "wavefront.glsl"
+
+uniform uint inputQueue;
+
+void main() {
+    uint slot;
+    if (!popQueue(inputQueue, slot)) {
+        return;
+    }
+    paths[slot].colorSum += paths[slot].throughput;
+}
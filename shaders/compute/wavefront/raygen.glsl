@@ -0,0 +1,36 @@
+#version 430 core
+
+// Wavefront pass 1: primary rays for one sample of every pixel, all pushed to RAY_QUEUE_A
+
+#include "../include/frame.glsl"
+#include "../include/common.glsl"
+#include "wavefront.glsl"
+
+uniform uint sampleIndex;
+
+void main() {
+    uint slot = gl_GlobalInvocationID.x;
+    if (slot >= resolution.x * resolution.y) {
+        return;
+    }
+    ivec2 fragCoord = ivec2(slot % resolution.x, slot / resolution.x);
+    beginSample(slot, sampleIndex, DIM_CAMERA);
+
+    // Same camera ray as the megakernel
+    vec2 ndc = (fragCoord / vec2(resolution)) * 2.0 - 1.0;
+    ndc.x *= aspectRatio;
+    vec4 worldSpacePos = invViewProj * vec4(ndc, -1.0, 1.0);
+
+    PathState path = paths[slot];
+    if (sampleIndex == 0) {
+        path.lightSum = vec3(0);
+        path.colorSum = vec3(0);
+    }
+    path.origin = cameraPosition + randomSphereDirection()*0.001;
+    path.direction = normalize(worldSpacePos.xyz / worldSpacePos.w);
+    path.throughput = vec3(1);
+    path.bounce = 0;
+    paths[slot] = path;
+
+    pushQueue(RAY_QUEUE_A, slot);
+}
@@ -0,0 +1,63 @@
+#version 430 core
+
+// Wavefront pass 3: material response at each hit. Lights end the path, surfaces pick the next
+// direction (pushed to the output ray queue) and request direct light through SHADOW_QUEUE.
+
+#include "../include/frame.glsl"
+#include "../include/common.glsl"
+#include "wavefront.glsl"
+
+uniform uint outputQueue;
+uniform uint sampleIndex;
+uniform uint roundIndex;
+uniform uint bounceLimit;     // maxBounces capped by the variant's RAY_BOUNCES
+
+void main() {
+    uint slot;
+    if (!popQueue(SHADE_QUEUE, slot)) {
+        return;
+    }
+    beginSample(slot, sampleIndex, bounceDimension(roundIndex));
+
+    PathState path = paths[slot];
+    vec3 point = path.origin + path.direction * path.hitDistance;
+    vec3 normal = path.hitNormal;
+    vec3 color = path.hitColor.rgb;
+
+    if (int(path.hitColor.a) == 0) {
+        // Light source
+        path.throughput *= color;
+        path.lightSum += color;
+        path.colorSum += path.throughput;
+        paths[slot] = path;
+        return;
+    }
+
+    // Same material model as traceRay in the megakernel
+    float opaqueness = path.hitParams.x;
+    float refractiveIndex = 0.1;
+    float specProbability = path.hitParams.z;
+    int isSpec = specProbability > hash1()? 1 : 0;
+    float smoothness = path.hitParams.y * isSpec;
+    int isTransparent = opaqueness < hash1()? 1 : 0;
+    vec3 refractedDir = refract(path.direction, normal, refractiveIndex);
+    vec3 diffuseDir = cosWeightedRandomHemisphereDirection(normal*(1-(isTransparent*2)));
+    vec3 specDir = reflect(path.direction, normal);
+    vec3 opaqueDir = mix(specDir, refractedDir, isTransparent);
+    path.direction = mix(diffuseDir, opaqueDir, smoothness);
+    path.origin = point + path.direction * 0.001;
+    path.throughput *= mix(color, vec3(1), min(isSpec+isTransparent,1));
+    path.lightWeight = 1.0 - min(smoothness+isTransparent,1);
+    path.bounce += 1 - isTransparent;
+
+    if (path.bounce < bounceLimit) {
+        pushQueue(outputQueue, slot);
+    } else {
+        path.colorSum += path.throughput;
+    }
+    paths[slot] = path;
+
+    if (path.lightWeight > 0.0) {
+        pushQueue(SHADOW_QUEUE, slot);
+    }
+}
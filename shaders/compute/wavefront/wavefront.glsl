@@ -0,0 +1,80 @@
+// Path state and work queues shared by the wavefront passes (see wavefront.cpp)
+//
+// Every pixel owns one path slot. The passes hand slots to each other through queues in a single
+// buffer; pushing counts with an atomic and bumps the queue's indirect dispatch group count
+// every WAVEFRONT_GROUP_SIZE items, so the next pass is dispatched with exactly enough groups.
+
+#ifndef USE_MESH
+#define USE_MESH 1
+#endif
+#ifndef SHADOWS
+#define SHADOWS 1
+#endif
+
+#define WAVEFRONT_GROUP_SIZE 64
+
+layout(local_size_x = WAVEFRONT_GROUP_SIZE) in;
+
+// Queue ids, must match WavefrontRenderer::Queue
+#define RAY_QUEUE_A 0
+#define RAY_QUEUE_B 1
+#define SHADE_QUEUE 2
+#define SHADOW_QUEUE 3
+
+struct PathState {
+    vec3 origin;
+    uint bounce;            // Opaque bounces so far, refraction doesn't count like in the megakernel
+    vec3 direction;
+    float lightWeight;      // How much direct light counts at the current shading point
+    vec3 throughput;
+    float padding0;
+    vec3 hitNormal;
+    float hitDistance;
+    vec4 hitColor;          // rgb material color, a material type
+    vec4 hitParams;         // opaqueness, smoothness, specularity
+    vec3 lightSum;          // Sums over all samples of the frame, resolved by the accumulate pass
+    float padding1;
+    vec3 colorSum;
+    float padding2;
+};
+
+struct QueueHeader {
+    uint groupsX, groupsY, groupsZ;     // glDispatchComputeIndirect arguments
+    uint count;
+};
+
+layout (std430, binding = 8) buffer PathBuffer {
+    PathState paths[];
+};
+
+layout (std430, binding = 9) buffer QueueBuffer {
+    uint queueCapacity;     // Items per queue (one per pixel)
+    uint queuePadding[3];
+    QueueHeader queues[4];
+    uint queueItems[];
+};
+
+void pushQueue(uint queue, uint slot) {
+    uint index = atomicAdd(queues[queue].count, 1);
+    if (index % WAVEFRONT_GROUP_SIZE == 0) {
+        atomicAdd(queues[queue].groupsX, 1);
+    }
+    queueItems[queue * queueCapacity + index] = slot;
+}
+
+// Slot for this invocation from an input queue, false past the end
+bool popQueue(uint queue, out uint slot) {
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= queues[queue].count) {
+        return false;
+    }
+    slot = queueItems[queue * queueCapacity + index];
+    return true;
+}
+
+// Start the slot's pixel sample for this frame and sample, at the given dimension
+void beginSample(uint slot, uint sampleIndex, uint dimension) {
+    uvec2 pixel = uvec2(slot % resolution.x, slot / resolution.x);
+    samplerBegin(pixel, frameNo*samplesPerPixel + sampleIndex);
+    samplerDimension = dimension;
+}
@@ -0,0 +1,66 @@
+#version 430 core
+
+#ifndef USE_MESH
+#define USE_MESH 1
+#endif
+
+#include "../../compute/include/frame.glsl"
+#include "../../compute/include/common.glsl"
+#include "../../compute/include/scene.glsl"
+#include "gbuffer.glsl"
+
+flat in uint primitive;
+
+layout(location = 0) out vec2 outNormal;       // Octahedral
+layout(location = 1) out float outDistance;    // Along the camera ray, like rayDist
+layout(location = 2) out uint outMaterial;
+
+void main() {
+    // The megakernel's camera ray for this pixel (tracePixel), the rasterizer samples the pixel center
+    vec2 ndc = (gl_FragCoord.xy - 0.5) / vec2(resolution) * 2.0 - 1.0;
+    ndc.x *= aspectRatio;
+    vec4 worldSpacePos = invViewProj * vec4(ndc, -1.0, 1.0);
+    Ray ray;
+    ray.point = cameraPosition;
+    ray.dir = normalize(worldSpacePos.xyz / worldSpacePos.w);
+
+    uint kind = primitive >> PRIMITIVE_KIND_SHIFT;
+    uint index = primitive & PRIMITIVE_INDEX_MASK;
+    float distance = -1.0;
+    vec3 normal = vec3(0);
+    uint material = NO_MATERIAL;
+    if (kind == PRIMITIVE_SPHERE || kind == PRIMITIVE_SPHERE_LIGHT) {
+        Sphere ball = getSphere(kind == PRIMITIVE_SPHERE ? balls[index] : sphereLightSources[index]);
+        vec2 hitResult = sphereHit(ray, ball);
+        distance = hitResult.x;
+        normal = normalize(hitResult.y * (ray.point + ray.dir * distance - ball.position));
+        material = kind == PRIMITIVE_SPHERE ? balls[index].material : sphereLightSources[index].material;
+    } else if (kind == PRIMITIVE_BOX || kind == PRIMITIVE_BOX_LIGHT) {
+        BoxData data = kind == PRIMITIVE_BOX ? boxes[index] : boxLightSources[index];
+        vec4 hitResult = boxHit(ray, getBox(data));
+        distance = hitResult.w;
+        normal = hitResult.xyz;
+        material = data.material;
+    } else {
+#if USE_MESH
+        // Distance to the triangle's plane: the rasterizer already decided the pixel is inside, the
+        // barycentric test of triangleHit could disagree on shared edges and leave holes
+        vec3 v0 = vertices[indices[index * 3]].xyz;
+        vec3 v1 = vertices[indices[index * 3 + 1]].xyz;
+        vec3 v2 = vertices[indices[index * 3 + 2]].xyz;
+        vec3 n = cross(v1 - v0, v2 - v0);
+        distance = dot(v0 - ray.point, n) / dot(ray.dir, n);
+        normal = normalize(n);
+        material = meshMaterial;
+#endif
+    }
+
+    // The bounding cube covers more pixels than the object
+    if (!(distance > 0.0)) {
+        discard;
+    }
+    outNormal = octEncode(normal);
+    outDistance = distance;
+    outMaterial = material;
+    gl_FragDepth = distance / (distance + 1.0);
+}
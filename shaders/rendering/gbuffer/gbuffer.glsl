@@ -0,0 +1,12 @@
+// Constants shared by the G-buffer pass (gbuffer.cpp) and the compute shaders reading it
+
+const uint NO_MATERIAL = 0xffffffffu;  // Material texture value where nothing was hit (GBuffer::NO_MATERIAL)
+
+// The vertex shader passes the primitive as kind << PRIMITIVE_KIND_SHIFT | index
+const uint PRIMITIVE_SPHERE = 0u;
+const uint PRIMITIVE_BOX = 1u;
+const uint PRIMITIVE_SPHERE_LIGHT = 2u;
+const uint PRIMITIVE_BOX_LIGHT = 3u;
+const uint PRIMITIVE_TRIANGLE = 4u;
+const uint PRIMITIVE_KIND_SHIFT = 28u;
+const uint PRIMITIVE_INDEX_MASK = (1u << PRIMITIVE_KIND_SHIFT) - 1u;
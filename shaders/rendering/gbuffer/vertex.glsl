@@ -0,0 +1,63 @@
+#version 430 core
+
+#ifndef USE_MESH
+#define USE_MESH 1
+#endif
+
+#include "../../compute/include/frame.glsl"
+#include "../../compute/include/common.glsl"
+#include "../../compute/include/scene.glsl"
+#include "gbuffer.glsl"
+
+uniform mat4 rasterViewProj;    // Camera relative view-projection, shifted half a pixel (GBuffer::render)
+uniform uint meshPass;          // 0: one bounding cube per instance, 1: the mesh triangles
+
+flat out uint primitive;
+
+// Slightly larger than the object, so the cube's edges never cut off pixels its fragments would hit
+const float PROXY_SCALE = 1.01;
+const float NEAR_PLANE = 0.001;  // The fragments write their own depth, this only clips what is behind the camera
+
+// Two triangles per face of the cube, corner i is at (bit 0, bit 1, bit 2) * 2 - 1
+const int cubeCorners[36] = int[36](
+    0, 2, 6,  0, 6, 4,   // -x
+    1, 3, 7,  1, 7, 5,   // +x
+    0, 1, 5,  0, 5, 4,   // -y
+    2, 3, 7,  2, 7, 6,   // +y
+    0, 1, 3,  0, 3, 2,   // -z
+    4, 5, 7,  4, 7, 6    // +z
+);
+
+void main() {
+    vec3 worldPosition = vec3(0);
+    if (meshPass == 1u) {
+#if USE_MESH
+        worldPosition = vertices[indices[gl_VertexID]].xyz;
+#endif
+        primitive = (PRIMITIVE_TRIANGLE << PRIMITIVE_KIND_SHIFT) | uint(gl_VertexID / 3);
+    } else {
+        int corner = cubeCorners[gl_VertexID];
+        vec3 local = (vec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1) * 2.0 - 1.0) * PROXY_SCALE;
+
+        // Instances are the spheres, boxes, sphere lights and box lights in a row
+        uint index = uint(gl_InstanceID);
+        uint kind = PRIMITIVE_SPHERE;
+        if (index >= ballCount) { index -= ballCount; kind = PRIMITIVE_BOX; }
+        if (kind == PRIMITIVE_BOX && index >= boxCount) { index -= boxCount; kind = PRIMITIVE_SPHERE_LIGHT; }
+        if (kind == PRIMITIVE_SPHERE_LIGHT && index >= sphereLightCount) { index -= sphereLightCount; kind = PRIMITIVE_BOX_LIGHT; }
+
+        if (kind == PRIMITIVE_SPHERE || kind == PRIMITIVE_SPHERE_LIGHT) {
+            SphereData sphere = kind == PRIMITIVE_SPHERE ? balls[index] : sphereLightSources[index];
+            worldPosition = sphere.position + local * sphere.radius;
+        } else {
+            // Same transform as boxHit
+            BoxData box = kind == PRIMITIVE_BOX ? boxes[index] : boxLightSources[index];
+            mat3 rotation = mat3(rotateX(box.rotation.x) * rotateY(box.rotation.y) * rotateZ(box.rotation.z));
+            worldPosition = box.position + rotation * (local * box.size);
+        }
+        primitive = (kind << PRIMITIVE_KIND_SHIFT) | index;
+    }
+
+    vec4 clip = rasterViewProj * vec4(worldPosition - cameraPosition, 1.0);
+    gl_Position = vec4(clip.xy, clip.w - 2.0 * NEAR_PLANE, clip.w);
+}
@@ -0,0 +1,117 @@
+#include "includes.hpp"
+#include "tilePool.hpp"
+
+TilePool::TilePool(int threadCount) {
+    threadCount = std::max(1, threadCount);
+    for (int i = 0; i < threadCount; i++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < threadCount; i++) {
+        threads.emplace_back(&TilePool::workerLoop, this, i);
+    }
+}
+
+TilePool::~TilePool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void TilePool::run(int count, const std::function<void(int)>& newTask) {
+    if (count <= 0) {
+        return;
+    }
+
+    // Contiguous blocks, so neighboring tiles (similar cost) start on the same worker
+    int workerCount = getThreadCount();
+    for (int w = 0; w < workerCount; w++) {
+        std::lock_guard<std::mutex> lock(workers[w]->mutex);
+        workers[w]->stolen = 0;
+        for (int i = count * w / workerCount; i < count * (w + 1) / workerCount; i++) {
+            workers[w]->tasks.push_back(i);
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    task = &newTask;
+    remaining = count;
+    generation++;
+    wake.notify_all();
+    finished.wait(lock, [this] { return remaining == 0 && activeWorkers == 0; });
+    task = nullptr;
+}
+
+size_t TilePool::getStolenCount() const {
+    size_t stolen = 0;
+    for (const std::unique_ptr<Worker>& worker : workers) {
+        stolen += worker->stolen;
+    }
+    return stolen;
+}
+
+bool TilePool::takeTask(int index, int& taskIndex) {
+    Worker& own = *workers[index];
+    {
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            taskIndex = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Steal the task the victim would have run last
+    int workerCount = getThreadCount();
+    for (int offset = 1; offset < workerCount; offset++) {
+        Worker& victim = *workers[(index + offset) % workerCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            taskIndex = victim.tasks.front();
+            victim.tasks.pop_front();
+            own.stolen++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TilePool::workerLoop(int index) {
+    unsigned int seenGeneration = 0;
+    while (true) {
+        const std::function<void(int)>* currentTask;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = generation;
+            // Woke up after that run() already returned
+            if (!task) {
+                continue;
+            }
+            currentTask = task;
+            activeWorkers++;
+        }
+
+        int taskIndex;
+        int completed = 0;
+        while (takeTask(index, taskIndex)) {
+            (*currentTask)(taskIndex);
+            completed++;
+        }
+
+        // run() returns only once no worker can still be holding its task
+        std::lock_guard<std::mutex> lock(mutex);
+        remaining -= completed;
+        activeWorkers--;
+        if (remaining == 0 && activeWorkers == 0) {
+            finished.notify_one();
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef TILE_POOL_HPP
+#define TILE_POOL_HPP
+
+#include "includes.hpp"
+
+// Fixed set of worker threads for per-tile jobs. Each worker owns a deque that run() fills with a
+// contiguous block of task indices; a worker takes from the back of its own deque and, once that is
+// empty, steals from the front of another's. Tiles with many samples (bright, adaptively sampled
+// areas) then don't leave the other threads idle at the end of a frame.
+class TilePool {
+public:
+    explicit TilePool(int threadCount = static_cast<int>(std::thread::hardware_concurrency()));
+    ~TilePool();
+
+    TilePool(const TilePool&) = delete;
+    TilePool& operator=(const TilePool&) = delete;
+
+    // Calls task(i) for every i in [0, count) on the workers, returns once all are done
+    void run(int count, const std::function<void(int)>& task);
+
+    int getThreadCount() const { return static_cast<int>(workers.size()); }
+
+    // Tasks taken from another worker's deque during the last run()
+    size_t getStolenCount() const;
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<int> tasks;
+        size_t stolen = 0;
+    };
+
+    void workerLoop(int index);
+    bool takeTask(int index, int& task);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable wake;           // A new run() started or the pool is shutting down
+    std::condition_variable finished;       // The last task of a run() completed
+    const std::function<void(int)>* task = nullptr;
+    unsigned int generation = 0;
+    int remaining = 0;                      // Tasks of the current run() not finished yet
+    int activeWorkers = 0;                  // Workers inside the current run()
+    bool stopping = false;
+};
+
+#endif // TILE_POOL_HPP
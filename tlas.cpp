@@ -0,0 +1,99 @@
+#include "includes.hpp"
+#include "tlas.hpp"
+#include "intersect.hpp"
+
+namespace {
+
+SceneInstance makeInstance(const TLAS::Object& object) {
+    SceneInstance instance{};
+    instance.kind = static_cast<uint32_t>(object.kind);
+    instance.material = object.material;
+    glm::vec3 extent = object.size;
+
+    if (object.kind == TLAS::SPHERE || object.kind == TLAS::SPHERE_LIGHT) {
+        // Translate, then scale the radius to 1
+        float inverseRadius = 1.0f / std::max(object.size.x, 1e-6f);
+        for (int row = 0; row < 3; row++) {
+            instance.worldToObject[row] = glm::vec4(0.0f);
+            instance.worldToObject[row][row] = inverseRadius;
+            instance.worldToObject[row].w = -object.position[row] * inverseRadius;
+        }
+        extent = glm::vec3(object.size.x);
+    } else if (object.kind == TLAS::BOX || object.kind == TLAS::BOX_LIGHT) {
+        // Into the box's rotated frame (the same rotation as boxHit), then its half extents to 1
+        BoxTransform box({object.position.x, object.position.y, object.position.z},
+                         {object.size.x, object.size.y, object.size.z},
+                         {object.rotation.x, object.rotation.y, object.rotation.z});
+        for (int row = 0; row < 3; row++) {
+            float inverseSize = 1.0f / std::max(object.size[row], 1e-6f);
+            glm::vec3 axis(box.worldToBox.m[row][0], box.worldToBox.m[row][1], box.worldToBox.m[row][2]);
+            axis *= inverseSize;
+            instance.worldToObject[row] = glm::vec4(axis, -glm::dot(axis, object.position));
+        }
+        // Rotated half extents: |R| * size
+        const Mat3& r = box.boxToWorld;
+        for (int row = 0; row < 3; row++) {
+            extent[row] = std::abs(r.m[row][0]) * object.size.x + std::abs(r.m[row][1]) * object.size.y + std::abs(r.m[row][2]) * object.size.z;
+        }
+    } else {
+        // The mesh BVH is in world space
+        for (int row = 0; row < 3; row++) {
+            instance.worldToObject[row] = glm::vec4(0.0f);
+            instance.worldToObject[row][row] = 1.0f;
+        }
+    }
+
+    instance.boundsMin = object.position - extent;
+    instance.boundsMax = object.position + extent;
+    return instance;
+}
+
+} // namespace
+
+void TLAS::update(const std::vector<Object>& objects) {
+    // Instances in object order, chunks of a large scene on their own threads
+    std::vector<SceneInstance> objectInstances(objects.size());
+    auto computeChunk = [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            objectInstances[i] = makeInstance(objects[i]);
+        }
+    };
+    std::vector<std::future<void>> tasks;
+    for (size_t first = PARALLEL_CHUNK_SIZE; first < objects.size(); first += PARALLEL_CHUNK_SIZE) {
+        tasks.push_back(std::async(std::launch::async, computeChunk, first, std::min(first + PARALLEL_CHUNK_SIZE, objects.size())));
+    }
+    computeChunk(0, std::min(PARALLEL_CHUNK_SIZE, objects.size()));
+    for (auto& task : tasks) {
+        task.get();
+    }
+
+    bool rebuild = objects.size() != instances.size();
+    if (!rebuild) {
+        // Same objects: keep the tree, put the new instances at their leaf positions and refit
+        const std::vector<uint32_t>& order = bvh.getOrder();
+        std::vector<glm::vec3> boundsMin(objects.size()), boundsMax(objects.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            instances[i] = objectInstances[order[i]];
+            boundsMin[i] = instances[i].boundsMin;
+            boundsMax[i] = instances[i].boundsMax;
+        }
+        bvh.refit(boundsMin, boundsMax);
+        rebuild = bvh.getCost() > builtCost * REBUILD_COST_RATIO;
+    }
+
+    if (rebuild) {
+        std::vector<glm::vec3> boundsMin(objects.size()), boundsMax(objects.size());
+        for (size_t i = 0; i < objects.size(); i++) {
+            boundsMin[i] = objectInstances[i].boundsMin;
+            boundsMax[i] = objectInstances[i].boundsMax;
+        }
+        bvh.build(boundsMin, boundsMax);
+        builtCost = bvh.getCost();
+
+        const std::vector<uint32_t>& order = bvh.getOrder();
+        instances.resize(objects.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            instances[i] = objectInstances[order[i]];
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef TLAS_HPP
+#define TLAS_HPP
+
+#include "includes.hpp"
+#include "bvh.hpp"
+
+// GPU side instance (std430 InstanceData in scene.glsl). The transform maps world space into the
+// object space of the shape every instance of its kind shares: the unit sphere, the [-1, 1] cube, or
+// the mesh BVH as it was built.
+struct SceneInstance {
+    glm::vec4 worldToObject[3];    // Rows of the affine transform
+    glm::vec3 boundsMin;           // World space box
+    uint32_t kind;                 // TLAS::Kind
+    glm::vec3 boundsMax;
+    uint32_t material;
+};
+static_assert(sizeof(SceneInstance) == 80, "SceneInstance must match the std430 layout in the shader");
+
+// Top-level acceleration structure over every object of the scene: a BVH over the instances' world
+// space boxes. When objects move the instances are recomputed on worker threads and the tree is
+// refit; it is rebuilt when the number of objects changes or refitting has made it too loose.
+class TLAS {
+public:
+    enum Kind { SPHERE, BOX, SPHERE_LIGHT, BOX_LIGHT, MESH };    // Scene::ObjectKind, then the mesh
+
+    // World space object an instance is made of
+    struct Object {
+        Kind kind;
+        glm::vec3 position;
+        glm::vec3 size;        // Radius in x for spheres, half extents for boxes and the mesh bounds
+        glm::vec3 rotation;    // Degrees around x, y, z like SceneBox, boxes only
+        uint32_t material;
+    };
+
+    // Rebuild once the refit tree's SAH cost exceeds the freshly built one's by this factor
+    static constexpr float REBUILD_COST_RATIO = 1.5f;
+    // Objects per worker thread when recomputing instances, smaller scenes stay on the calling thread
+    static constexpr size_t PARALLEL_CHUNK_SIZE = 1024;
+
+    // Recomputes the instances of the objects (same order and count as last time to refit)
+    void update(const std::vector<Object>& objects);
+
+    const std::vector<SceneInstance>& getInstances() const { return instances; }   // In leaf order
+    const std::vector<BVHNode>& getNodes() const { return bvh.getNodes(); }
+
+private:
+    BVH bvh;
+    std::vector<SceneInstance> instances;
+    float builtCost = 0.0f;     // SAH cost right after the last rebuild
+};
+
+#endif // TLAS_HPP
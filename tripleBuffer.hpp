@@ -0,0 +1,45 @@
+#ifndef TRIPLE_BUFFER_HPP
+#define TRIPLE_BUFFER_HPP
+
+#include "includes.hpp"
+
+// Hands the newest value from one writer thread to one reader thread without locks or waiting.
+// The writer fills its back slot and publishes it, which swaps it with the middle slot; the reader
+// swaps the middle slot with its front slot only when something new was published. Neither side
+// ever touches the slot the other one holds, so a slow reader just skips values.
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer: the slot to fill before publish()
+    T& back() { return slots[backIndex].value; }
+
+    void publish() {
+        int previous = middle.exchange(backIndex | NEW_BIT, std::memory_order_acq_rel);
+        backIndex = previous & INDEX_MASK;
+    }
+
+    // Reader: the last published value (the same one again until the writer publishes another)
+    const T& latest() {
+        if (middle.load(std::memory_order_relaxed) & NEW_BIT) {
+            int previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+            frontIndex = previous & INDEX_MASK;
+        }
+        return slots[frontIndex].value;
+    }
+
+private:
+    static constexpr int INDEX_MASK = 3;
+    static constexpr int NEW_BIT = 4;
+
+    // Own cache lines, the two threads write different slots
+    struct alignas(64) Slot {
+        T value{};
+    };
+
+    Slot slots[3];
+    std::atomic<int> middle{1};
+    int backIndex = 0;   // Writer only
+    int frontIndex = 2;  // Reader only
+};
+
+#endif // TRIPLE_BUFFER_HPP
@@ -0,0 +1,123 @@
+#include "includes.hpp"
+#include "wavefront.hpp"
+
+namespace {
+
+// Queue buffer layout: capacity (padded to 16 bytes), QUEUE_COUNT headers, then the items of each queue
+constexpr size_t QUEUE_HEADER_OFFSET = 16;
+constexpr size_t QUEUE_HEADER_SIZE = 16;
+
+// Everything a pass writes is read by the next one, either as SSBO data or as indirect arguments
+void passBarrier() {
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+} // namespace
+
+WavefrontRenderer::WavefrontRenderer(int width, int height)
+    : width(width), height(height),
+      pathBuffer(Buffer::STORAGE_BUFFER, GL_DYNAMIC_COPY), queueBuffer(Buffer::STORAGE_BUFFER, GL_DYNAMIC_COPY) {
+    size_t pixels = static_cast<size_t>(width) * height;
+
+    pathBuffer.generateBuffer();
+    pathBuffer.uploadData(nullptr, pixels * PATH_STATE_SIZE);
+
+    std::vector<uint32_t> queueData((QUEUE_HEADER_OFFSET + QUEUE_COUNT * QUEUE_HEADER_SIZE) / sizeof(uint32_t) + QUEUE_COUNT * pixels, 0);
+    queueData[0] = static_cast<uint32_t>(pixels);
+    queueBuffer.generateBuffer();
+    queueBuffer.uploadData(queueData.data(), queueData.size() * sizeof(uint32_t));
+}
+
+void WavefrontRenderer::setVariant(ShaderCache& shaderCache, const ShaderDefines& defines) {
+    raygenProgram = shaderCache.get({{GL_COMPUTE_SHADER, "shaders/compute/wavefront/raygen.glsl"}}, defines);
+    extendProgram = shaderCache.get({{GL_COMPUTE_SHADER, "shaders/compute/wavefront/extend.glsl"}}, defines);
+    shadeProgram = shaderCache.get({{GL_COMPUTE_SHADER, "shaders/compute/wavefront/shade.glsl"}}, defines);
+    connectProgram = shaderCache.get({{GL_COMPUTE_SHADER, "shaders/compute/wavefront/connect.glsl"}}, defines);
+    finishProgram = shaderCache.get({{GL_COMPUTE_SHADER, "shaders/compute/wavefront/finish.glsl"}}, defines);
+    accumulateProgram = shaderCache.get({{GL_COMPUTE_SHADER, "shaders/compute/wavefront/accumulate.glsl"}}, defines);
+
+    auto readCap = [&](const char* name) {
+        auto it = defines.find(name);
+        return it == defines.end() ? std::numeric_limits<int>::max() : std::atoi(it->second.c_str());
+    };
+    sampleCap = readCap("RAY_SAMPLES");
+    bounceCap = readCap("RAY_BOUNCES");
+}
+
+void WavefrontRenderer::resetQueue(Queue queue) {
+    uint32_t header[4] = {0, 1, 1, 0};
+    queueBuffer.uploadSubData(header, QUEUE_HEADER_OFFSET + queue * QUEUE_HEADER_SIZE, sizeof(header));
+}
+
+void WavefrontRenderer::dispatchQueue(Queue queue) {
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, queueBuffer.getBufferID());
+    glDispatchComputeIndirect(QUEUE_HEADER_OFFSET + queue * QUEUE_HEADER_SIZE);
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+}
+
+void WavefrontRenderer::render(const Texture& screenTexture, const Texture& normalTexture, const Texture& depthTexture,
+                               int samplesPerPixel, int maxBounces) {
+    samplesPerPixel = std::max(1, std::min(samplesPerPixel, sampleCap));
+    maxBounces = std::max(1, std::min(maxBounces, bounceCap));
+
+    pathBuffer.setBufferBinding(PATH_BINDING);
+    queueBuffer.setBufferBinding(QUEUE_BINDING);
+
+    GLuint pixelGroups = static_cast<GLuint>((static_cast<size_t>(width) * height + GROUP_SIZE - 1) / GROUP_SIZE);
+
+    // Refraction doesn't count as a bounce, the extra rounds let paths through glass finish
+    int rounds = maxBounces * 2;
+
+    for (int sample = 0; sample < samplesPerPixel; sample++) {
+        passBarrier();
+        resetQueue(RAY_QUEUE_A);
+
+        raygenProgram->use();
+        raygenProgram->setUInt("sampleIndex", sample);
+        glDispatchCompute(pixelGroups, 1, 1);
+
+        Queue input = RAY_QUEUE_A;
+        Queue output = RAY_QUEUE_B;
+        for (int round = 0; round < rounds; round++) {
+            passBarrier();
+            resetQueue(output);
+            resetQueue(SHADE_QUEUE);
+            resetQueue(SHADOW_QUEUE);
+
+            extendProgram->use();
+            extendProgram->setUInt("inputQueue", input);
+            extendProgram->setUInt("writeGBuffer", sample == 0 && round == 0 ? 1 : 0);
+            extendProgram->setImage("normalTexture", normalTexture.getID(), 1, GL_RGBA16F);
+            extendProgram->setImage("depthTexture", depthTexture.getID(), 2, GL_R32F);
+            dispatchQueue(input);
+            passBarrier();
+
+            shadeProgram->use();
+            shadeProgram->setUInt("outputQueue", output);
+            shadeProgram->setUInt("sampleIndex", sample);
+            shadeProgram->setUInt("roundIndex", round);
+            shadeProgram->setUInt("bounceLimit", maxBounces);
+            dispatchQueue(SHADE_QUEUE);
+            passBarrier();
+
+            connectProgram->use();
+            connectProgram->setUInt("sampleIndex", sample);
+            connectProgram->setUInt("roundIndex", round);
+            dispatchQueue(SHADOW_QUEUE);
+
+            std::swap(input, output);
+        }
+
+        // Paths that refracted more often than the rounds allow are cut off like at the bounce limit
+        passBarrier();
+        finishProgram->use();
+        finishProgram->setUInt("inputQueue", input);
+        dispatchQueue(input);
+    }
+
+    passBarrier();
+    accumulateProgram->use();
+    accumulateProgram->setUInt("sampleCount", samplesPerPixel);
+    accumulateProgram->setImage("screenTexture", screenTexture.getID(), 0, GL_RGBA16F);
+    glDispatchCompute(pixelGroups, 1, 1);
+}
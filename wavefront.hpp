@@ -0,0 +1,53 @@
+#ifndef WAVEFRONT_HPP
+#define WAVEFRONT_HPP
+
+#include "includes.hpp"
+#include "shaderStuff.hpp"
+
+// Path tracer split into small compute passes (ray generation, extend, shade, connect, accumulate)
+// that pass path slots through atomically compacted queues and are launched with
+// glDispatchComputeIndirect, instead of the single traceRay megakernel.
+// Only the threads with work run each pass, so divergence between materials, misses and shadow rays
+// doesn't keep whole workgroups busy.
+class WavefrontRenderer {
+public:
+    static constexpr int GROUP_SIZE = 64;           // WAVEFRONT_GROUP_SIZE in wavefront.glsl
+    static constexpr size_t PATH_STATE_SIZE = 128;  // sizeof(PathState) in wavefront.glsl
+    static constexpr GLuint PATH_BINDING = 8;
+    static constexpr GLuint QUEUE_BINDING = 9;
+
+    // Queue ids, must match wavefront.glsl
+    enum Queue { RAY_QUEUE_A, RAY_QUEUE_B, SHADE_QUEUE, SHADOW_QUEUE, QUEUE_COUNT };
+
+    WavefrontRenderer(int width, int height);
+
+    // Compile (through the cache) the passes with the variant's defines (USE_MESH, SHADOWS),
+    // RAY_SAMPLES and RAY_BOUNCES cap the counts passed to render() like they do in the megakernel
+    void setVariant(ShaderCache& shaderCache, const ShaderDefines& defines);
+
+    // Traces samplesPerPixel paths of up to maxBounces per pixel into screenTexture, the first
+    // sample's primary hits go to normalTexture and depthTexture. Frame uniforms must be bound.
+    void render(const Texture& screenTexture, const Texture& normalTexture, const Texture& depthTexture,
+                int samplesPerPixel, int maxBounces);
+
+private:
+    int width, height;
+    Buffer pathBuffer;
+    Buffer queueBuffer;
+
+    std::shared_ptr<Shader> raygenProgram;
+    std::shared_ptr<Shader> extendProgram;
+    std::shared_ptr<Shader> shadeProgram;
+    std::shared_ptr<Shader> connectProgram;
+    std::shared_ptr<Shader> finishProgram;
+    std::shared_ptr<Shader> accumulateProgram;
+
+    int sampleCap = std::numeric_limits<int>::max();
+    int bounceCap = std::numeric_limits<int>::max();
+
+    // Empty the queue (count 0, indirect arguments 0x1x1)
+    void resetQueue(Queue queue);
+    void dispatchQueue(Queue queue);
+};
+
+#endif // WAVEFRONT_HPP